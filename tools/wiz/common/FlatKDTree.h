@@ -0,0 +1,847 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _FLATKDTREE_H_
+#define _FLATKDTREE_H_
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <ctime>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace assembly3d
+{
+    /**
+     * @brief Fixed capacity heap collecting the nearest points of a query.
+     *
+     * The storage is provided by the caller, so a query does not allocate.
+     * While collecting, the farthest point is on top. After sort() the
+     * points are ordered by ascending distance.
+     */
+    class NearestHeap
+    {
+    public:
+        /**
+         * @brief Constructor.
+         *
+         * @param indices Storage for capacity point indices.
+         * @param distances Storage for capacity squared distances.
+         * @param capacity Maximum number of points to collect.
+         */
+        NearestHeap(int* indices, float* distances, int capacity)
+            : m_indices(indices), m_distances(distances),
+              m_capacity(capacity), m_size(0)
+        {
+        }
+
+        void clear() { m_size = 0; }
+        int size() const { return m_size; }
+        int capacity() const { return m_capacity; }
+        bool isFull() const { return m_size == m_capacity; }
+        const int* getIndices() const { return m_indices; }
+        const float* getDistances() const { return m_distances; }
+
+        /**
+         * @brief Squared distance a point has to beat to be collected.
+         */
+        float getBound(float radius2) const
+        {
+            return isFull() ? m_distances[0] : radius2;
+        }
+
+        /**
+         * @brief Adds a point, replacing the farthest one if the heap is full.
+         *
+         * The caller makes sure the point is closer than getBound().
+         */
+        void push(int index, float distance2)
+        {
+            if(isFull())
+            {
+                m_indices[0] = index;
+                m_distances[0] = distance2;
+                siftDown(0, m_size);
+                return;
+            }
+
+            int child = m_size++;
+            while(child > 0)
+            {
+                int parent = (child-1) / 2;
+                if(m_distances[parent] >= distance2)
+                    break;
+                m_indices[child] = m_indices[parent];
+                m_distances[child] = m_distances[parent];
+                child = parent;
+            }
+            m_indices[child] = index;
+            m_distances[child] = distance2;
+        }
+
+        /**
+         * @brief Orders the collected points by ascending distance.
+         *
+         * Heap sort in place, push() must not be called afterwards
+         * without clear().
+         */
+        void sort()
+        {
+            for(int end = m_size-1; end > 0; --end)
+            {
+                std::swap(m_indices[0], m_indices[end]);
+                std::swap(m_distances[0], m_distances[end]);
+                siftDown(0, end);
+            }
+        }
+
+    private:
+        void siftDown(int parent, int size)
+        {
+            int index = m_indices[parent];
+            float distance2 = m_distances[parent];
+            for(;;)
+            {
+                int child = parent*2 + 1;
+                if(child >= size)
+                    break;
+                if(child+1 < size && m_distances[child+1] > m_distances[child])
+                    ++child;
+                if(m_distances[child] <= distance2)
+                    break;
+                m_indices[parent] = m_indices[child];
+                m_distances[parent] = m_distances[child];
+                parent = child;
+            }
+            m_indices[parent] = index;
+            m_distances[parent] = distance2;
+        }
+
+        int* m_indices;
+        float* m_distances;
+        int m_capacity;
+        int m_size;
+    };
+
+    /**
+     * @brief Results of a batch query in compressed row form.
+     *
+     * The points found for query i are indices[offsets[i]] up to
+     * indices[offsets[i+1]], nearest first, with their squared distances
+     * at the same positions in distances.
+     */
+    struct QueryResults
+    {
+        std::vector<int> offsets;
+        std::vector<int> indices;
+        std::vector<float> distances;
+    };
+
+    /**
+     * @brief Statistics of the last FlatKDTree build.
+     */
+    struct KDTreeBuildStatistics
+    {
+        int numNodes;
+        int numLeaves;
+        int maxDepth;
+        double buildTime;   ///< Build time in seconds, see getTime().
+    };
+
+    /**
+     * @brief Compact KD-tree for 2D and 3D points.
+     *
+     * Points are stored in small leaf buckets, with the coordinates of
+     * every axis in one contiguous array in leaf order. Nodes only hold
+     * the split, the tree is traversed with an explicit stack and the
+     * results go into a caller provided NearestHeap, so queries never
+     * allocate. Results are indices into the point set passed to
+     * generate().
+     */
+    template<int dimensions=2>
+    class FlatKDTree
+    {
+    public:
+        /**
+         * @brief How inner nodes choose their split.
+         */
+        enum SplitMethod
+        {
+            MEDIAN_SPLIT,   ///< Exact median, balanced tree.
+            BINNED_SPLIT    ///< Median estimated from a histogram, faster build.
+        };
+
+        FlatKDTree()
+        {
+            m_statistics.numNodes = 0;
+            m_statistics.numLeaves = 0;
+            m_statistics.maxDepth = 0;
+            m_statistics.buildTime = 0.0;
+        }
+
+        /**
+         * @brief Builds the tree from points with an operator[] per axis.
+         *
+         * @param pointset The points, for example KDTree's Point.
+         */
+        template<class VectorT>
+        void generate(const std::vector<VectorT>& pointset,
+                      SplitMethod splitMethod=MEDIAN_SPLIT)
+        {
+            std::vector<float> coords(pointset.size()*dimensions);
+            for(size_t i = 0; i < pointset.size(); ++i)
+            {
+                for(int axis = 0; axis < dimensions; ++axis)
+                    coords[i*dimensions + axis] = pointset[i][axis];
+            }
+            generate(coords.empty() ? 0 : &coords[0],
+                     static_cast<int>(pointset.size()), dimensions, splitMethod);
+        }
+
+        /**
+         * @brief Builds the tree from interleaved coordinates.
+         *
+         * @param coords Coordinates of the first point.
+         * @param numPoints Number of points.
+         * @param stride Number of floats from one point to the next.
+         * @param splitMethod How inner nodes choose their split.
+         */
+        void generate(const float* coords, int numPoints, int stride,
+                      SplitMethod splitMethod=MEDIAN_SPLIT)
+        {
+            double startTime = getTime();
+
+            m_statistics.numNodes = 0;
+            m_statistics.numLeaves = 0;
+            m_statistics.maxDepth = 0;
+            m_statistics.buildTime = 0.0;
+
+            m_nodes.clear();
+            m_indices.resize(numPoints);
+            for(int axis = 0; axis < dimensions; ++axis)
+                m_coords[axis].resize(numPoints);
+
+            if(numPoints <= 0)
+                return;
+
+            // Points are partitioned together with their coordinates, which
+            // keeps the build free of indirect accesses.
+            std::vector<BuildPoint> points(numPoints);
+            for(int i = 0; i < numPoints; ++i)
+            {
+                for(int axis = 0; axis < dimensions; ++axis)
+                    points[i].coords[axis] = coords[i*stride + axis];
+                points[i].index = i;
+            }
+
+            m_nodes.reserve(2*(numPoints/BUCKET_SIZE + 1));
+            m_nodes.push_back(Node());
+
+            // The upper levels are built here. Subtrees below a size
+            // threshold are deferred and built in parallel, each into
+            // its own node array, and appended afterwards.
+            int numThreads = 1;
+#ifdef _OPENMP
+            numThreads = omp_get_max_threads();
+#endif
+            std::vector<BuildTask> tasks;
+            BuildContext context = {&points, splitMethod, &m_statistics,
+                                    numThreads > 1 ? &tasks : 0,
+                                    std::max(numPoints / (numThreads*8), static_cast<int>(PARALLEL_BUILD_SIZE))};
+            build(m_nodes, 0, context, 0, numPoints, 0);
+
+            if(tasks.empty() == false)
+            {
+                std::vector<std::vector<Node> > subtrees(tasks.size());
+                std::vector<KDTreeBuildStatistics> statistics(tasks.size());
+                const int numTasks = static_cast<int>(tasks.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+                for(int i = 0; i < numTasks; ++i)
+                {
+                    KDTreeBuildStatistics& taskStatistics = statistics[i];
+                    taskStatistics.numNodes = 0;
+                    taskStatistics.numLeaves = 0;
+                    taskStatistics.maxDepth = 0;
+                    BuildContext taskContext = {&points, splitMethod, &taskStatistics, 0, 0};
+                    subtrees[i].push_back(Node());
+                    build(subtrees[i], 0, taskContext, tasks[i].begin, tasks[i].end, tasks[i].depth);
+                }
+
+                for(int i = 0; i < numTasks; ++i)
+                {
+                    appendSubtree(tasks[i].node, subtrees[i]);
+                    m_statistics.numNodes += statistics[i].numNodes;
+                    m_statistics.numLeaves += statistics[i].numLeaves;
+                    m_statistics.maxDepth = std::max(m_statistics.maxDepth, statistics[i].maxDepth);
+                }
+            }
+
+            // Coordinates in leaf order, so every bucket is contiguous.
+            for(int i = 0; i < numPoints; ++i)
+            {
+                for(int axis = 0; axis < dimensions; ++axis)
+                    m_coords[axis][i] = points[i].coords[axis];
+                m_indices[i] = points[i].index;
+            }
+
+            m_statistics.buildTime = getTime() - startTime;
+        }
+
+        /**
+         * @brief Gets node count, leaf count, depth and time of the last build.
+         */
+        const KDTreeBuildStatistics& getBuildStatistics() const
+        {
+            return m_statistics;
+        }
+
+        int getNumberOfPoints() const
+        {
+            return static_cast<int>(m_indices.size());
+        }
+
+        /**
+         * @brief Collects the heap.capacity() nearest points of a location.
+         *
+         * @param location Query coordinates, dimensions floats.
+         * @param heap Cleared and filled with the points, nearest first.
+         * @return Number of points found.
+         */
+        int nearestQuery(const float* location, NearestHeap& heap) const
+        {
+            return query(location, FLT_MAX, heap);
+        }
+
+        /**
+         * @brief Collects the points closer than radius to a location.
+         *
+         * At most heap.capacity() points are collected, the nearest ones
+         * if there are more.
+         *
+         * @param location Query coordinates, dimensions floats.
+         * @param radius Search radius.
+         * @param heap Cleared and filled with the points, nearest first.
+         * @return Number of points found.
+         */
+        int radiusQuery(const float* location, float radius, NearestHeap& heap) const
+        {
+            return query(location, radius*radius, heap);
+        }
+
+        /**
+         * @brief Runs nearestQuery() for many locations in parallel.
+         *
+         * @param locations Coordinates of the first query location.
+         * @param numQueries Number of query locations.
+         * @param stride Number of floats from one location to the next.
+         * @param k Number of points to collect per query.
+         * @param results Results in query order.
+         * @param mortonOrder True to process the queries along a Morton
+         * curve, which helps if the locations are not spatially sorted.
+         * @return Total number of points found.
+         */
+        int nearestQuery(const float* locations, int numQueries, int stride, int k,
+                         QueryResults& results, bool mortonOrder=false) const
+        {
+            return batchQuery(locations, numQueries, stride, FLT_MAX, k,
+                              results, mortonOrder);
+        }
+
+        /**
+         * @brief Runs radiusQuery() for many locations in parallel.
+         *
+         * @param locations Coordinates of the first query location.
+         * @param numQueries Number of query locations.
+         * @param stride Number of floats from one location to the next.
+         * @param radius Search radius.
+         * @param maxPoints Maximum number of points to collect per query.
+         * @param results Results in query order.
+         * @param mortonOrder True to process the queries along a Morton curve.
+         * @return Total number of points found.
+         */
+        int radiusQuery(const float* locations, int numQueries, int stride,
+                        float radius, int maxPoints, QueryResults& results,
+                        bool mortonOrder=false) const
+        {
+            return batchQuery(locations, numQueries, stride, radius*radius,
+                              maxPoints, results, mortonOrder);
+        }
+
+    private:
+        static const int BUCKET_SIZE = 8;
+        static const int STACK_SIZE = 128;
+        static const int QUERY_CHUNK_SIZE = 256;
+        static const int PARALLEL_BUILD_SIZE = 4096;
+        static const int BINNED_MIN_SIZE = 256;
+        static const int BINNED_MAX_DEPTH = 32;
+        static const int NUM_BINS = 32;
+
+        /**
+         * @brief Tree node.
+         *
+         * Inner nodes have their children at first and first+1, leaves
+         * hold the points [first, first+count) in leaf order.
+         */
+        struct Node
+        {
+            float split;
+            int axis;
+            int first;
+            int count;
+        };
+
+        struct BuildPoint
+        {
+            float coords[dimensions];
+            int index;
+        };
+
+        struct AxisLess
+        {
+            AxisLess(int axis) : axis(axis) {}
+            bool operator()(const BuildPoint& lhs, const BuildPoint& rhs) const
+            {
+                return lhs.coords[axis] < rhs.coords[axis];
+            }
+            int axis;
+        };
+
+        struct BuildTask
+        {
+            int node;
+            int begin;
+            int end;
+            int depth;
+        };
+
+        struct BuildContext
+        {
+            std::vector<BuildPoint>* points;
+            SplitMethod splitMethod;
+            KDTreeBuildStatistics* statistics;
+            std::vector<BuildTask>* deferred;   ///< 0 to build everything.
+            int deferSize;
+        };
+
+        struct AxisBelow
+        {
+            AxisBelow(int axis, float value) : axis(axis), value(value) {}
+            bool operator()(const BuildPoint& point) const
+            {
+                return point.coords[axis] < value;
+            }
+            int axis;
+            float value;
+        };
+
+        /**
+         * @brief Wall clock seconds with OpenMP, processor seconds otherwise.
+         *
+         * Without OpenMP the build runs on one thread, so both agree up to
+         * the time the process is not scheduled.
+         */
+        static double getTime()
+        {
+#ifdef _OPENMP
+            return omp_get_wtime();
+#else
+            return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+        }
+
+        void build(std::vector<Node>& nodes, int nodeIndex, const BuildContext& context,
+                   int begin, int end, int depth)
+        {
+            std::vector<BuildPoint>& points = *context.points;
+
+            if(context.deferred && end - begin <= context.deferSize)
+            {
+                BuildTask task = {nodeIndex, begin, end, depth};
+                context.deferred->push_back(task);
+                return;
+            }
+
+            ++context.statistics->numNodes;
+            context.statistics->maxDepth = std::max(context.statistics->maxDepth, depth);
+
+            if(end - begin <= BUCKET_SIZE)
+            {
+                Node& leaf = nodes[nodeIndex];
+                leaf.split = 0.0f;
+                leaf.axis = -1;
+                leaf.first = begin;
+                leaf.count = end - begin;
+                ++context.statistics->numLeaves;
+                return;
+            }
+
+            // Split along the axis with the largest extent.
+            float minimum[dimensions];
+            float maximum[dimensions];
+            for(int axis = 0; axis < dimensions; ++axis)
+                minimum[axis] = maximum[axis] = points[begin].coords[axis];
+            for(int i = begin+1; i < end; ++i)
+            {
+                const float* point = points[i].coords;
+                for(int axis = 0; axis < dimensions; ++axis)
+                {
+                    minimum[axis] = std::min(minimum[axis], point[axis]);
+                    maximum[axis] = std::max(maximum[axis], point[axis]);
+                }
+            }
+            int splitAxis = 0;
+            for(int axis = 1; axis < dimensions; ++axis)
+            {
+                if(maximum[axis] - minimum[axis] > maximum[splitAxis] - minimum[splitAxis])
+                    splitAxis = axis;
+            }
+
+            int middle = -1;
+            float split = 0.0f;
+            if(context.splitMethod == BINNED_SPLIT && end - begin >= BINNED_MIN_SIZE &&
+               depth < BINNED_MAX_DEPTH)
+            {
+                middle = binnedSplit(points, begin, end, splitAxis,
+                                     minimum[splitAxis], maximum[splitAxis], split);
+            }
+            if(middle < 0)
+            {
+                middle = begin + (end - begin) / 2;
+                std::nth_element(points.begin() + begin, points.begin() + middle,
+                                 points.begin() + end, AxisLess(splitAxis));
+                split = points[middle].coords[splitAxis];
+            }
+
+            int first = static_cast<int>(nodes.size());
+            nodes.push_back(Node());
+            nodes.push_back(Node());
+
+            Node& node = nodes[nodeIndex];
+            node.split = split;
+            node.axis = splitAxis;
+            node.first = first;
+            node.count = 0;
+
+            build(nodes, first, context, begin, middle, depth+1);
+            build(nodes, first+1, context, middle, end, depth+1);
+        }
+
+        /**
+         * @brief Splits at the histogram bin border closest to the median.
+         *
+         * @return First point of the right half, or -1 if the split would
+         * leave less than a quarter of the points on one side.
+         */
+        int binnedSplit(std::vector<BuildPoint>& points, int begin, int end, int axis,
+                        float minimum, float maximum, float& split)
+        {
+            if(!(maximum > minimum))
+                return -1;
+
+            int bins[NUM_BINS] = {0};
+            const float scale = static_cast<float>(NUM_BINS) / (maximum - minimum);
+            for(int i = begin; i < end; ++i)
+            {
+                int bin = static_cast<int>((points[i].coords[axis] - minimum) * scale);
+                bins[std::min(std::max(bin, 0), NUM_BINS-1)]++;
+            }
+
+            const int half = (end - begin) / 2;
+            int bestBorder = 1;
+            int bestCount = bins[0];
+            int count = bins[0];
+            for(int border = 2; border < NUM_BINS; ++border)
+            {
+                count += bins[border-1];
+                if(std::abs(count - half) < std::abs(bestCount - half))
+                {
+                    bestBorder = border;
+                    bestCount = count;
+                }
+            }
+
+            const int quarter = (end - begin) / 4;
+            if(bestCount < quarter || (end - begin) - bestCount < quarter)
+                return -1;
+
+            split = minimum + static_cast<float>(bestBorder) / scale;
+            int middle = static_cast<int>(std::partition(points.begin() + begin, points.begin() + end,
+                                                         AxisBelow(axis, split)) - points.begin());
+            if(middle - begin < quarter || end - middle < quarter)
+                return -1;
+            return middle;
+        }
+
+        /**
+         * @brief Moves a subtree built into its own node array into the tree.
+         *
+         * The subtree root replaces the node the subtree was deferred at.
+         */
+        void appendSubtree(int nodeIndex, const std::vector<Node>& subtree)
+        {
+            const int base = static_cast<int>(m_nodes.size()) - 1;
+            for(size_t i = 0; i < subtree.size(); ++i)
+            {
+                Node node = subtree[i];
+                if(node.axis >= 0)
+                    node.first += base;
+
+                if(i == 0)
+                    m_nodes[nodeIndex] = node;
+                else
+                    m_nodes.push_back(node);
+            }
+        }
+
+        int query(const float* location, float radius2, NearestHeap& heap) const
+        {
+            heap.clear();
+            if(m_nodes.empty() || heap.capacity() <= 0)
+                return 0;
+
+            // Pending nodes with the squared distance to their split plane.
+            int stackNodes[STACK_SIZE];
+            float stackDistances[STACK_SIZE];
+            int stackSize = 0;
+            stackNodes[stackSize] = 0;
+            stackDistances[stackSize] = 0.0f;
+            ++stackSize;
+
+            while(stackSize > 0)
+            {
+                --stackSize;
+                if(stackDistances[stackSize] >= heap.getBound(radius2))
+                    continue;
+
+                const Node* node = &m_nodes[stackNodes[stackSize]];
+                while(node->axis >= 0)
+                {
+                    float delta = location[node->axis] - node->split;
+                    int nearChild = delta < 0.0f ? node->first : node->first+1;
+                    int farChild = delta < 0.0f ? node->first+1 : node->first;
+
+                    stackNodes[stackSize] = farChild;
+                    stackDistances[stackSize] = delta*delta;
+                    ++stackSize;
+
+                    node = &m_nodes[nearChild];
+                }
+
+                scanBucket(*node, location, radius2, heap);
+            }
+
+            heap.sort();
+            return heap.size();
+        }
+
+        int batchQuery(const float* locations, int numQueries, int stride,
+                       float radius2, int maxPoints, QueryResults& results,
+                       bool mortonOrder) const
+        {
+            if(numQueries < 0)
+                numQueries = 0;
+            if(maxPoints < 0)
+                maxPoints = 0;
+
+            results.offsets.assign(numQueries+1, 0);
+            results.indices.clear();
+            results.distances.clear();
+            if(numQueries == 0 || maxPoints == 0)
+                return 0;
+
+            std::vector<int> order;
+            if(mortonOrder)
+                getMortonOrder(locations, numQueries, stride, order);
+
+            // Every chunk of queries appends its points to its own buffers,
+            // so memory grows with the points found instead of maxPoints
+            // slots per query. The buffers are scattered in query order
+            // once all chunks are done.
+            const int numChunks = (numQueries + QUERY_CHUNK_SIZE-1) / QUERY_CHUNK_SIZE;
+            std::vector<std::vector<int> > chunkIndices(numChunks);
+            std::vector<std::vector<float> > chunkDistances(numChunks);
+            int* counts = &results.offsets[1];
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            {
+                std::vector<int> heapIndices(maxPoints);
+                std::vector<float> heapDistances(maxPoints);
+                NearestHeap heap(&heapIndices[0], &heapDistances[0], maxPoints);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+                for(int chunk = 0; chunk < numChunks; ++chunk)
+                {
+                    int begin = chunk*QUERY_CHUNK_SIZE;
+                    int end = std::min(begin + QUERY_CHUNK_SIZE, numQueries);
+                    for(int i = begin; i < end; ++i)
+                    {
+                        int q = mortonOrder ? order[i] : i;
+                        int count = query(&locations[static_cast<size_t>(q)*stride], radius2, heap);
+                        counts[q] = count;
+                        chunkIndices[chunk].insert(chunkIndices[chunk].end(),
+                                                   heapIndices.begin(), heapIndices.begin() + count);
+                        chunkDistances[chunk].insert(chunkDistances[chunk].end(),
+                                                     heapDistances.begin(), heapDistances.begin() + count);
+                    }
+                }
+            }
+
+            for(int q = 0; q < numQueries; ++q)
+                results.offsets[q+1] += results.offsets[q];
+            int total = results.offsets[numQueries];
+            results.indices.resize(total);
+            results.distances.resize(total);
+            if(total == 0)
+                return 0;
+
+            int* indices = &results.indices[0];
+            float* distances = &results.distances[0];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for(int chunk = 0; chunk < numChunks; ++chunk)
+            {
+                int begin = chunk*QUERY_CHUNK_SIZE;
+                int end = std::min(begin + QUERY_CHUNK_SIZE, numQueries);
+                size_t source = 0;
+                for(int i = begin; i < end; ++i)
+                {
+                    int q = mortonOrder ? order[i] : i;
+                    int offset = results.offsets[q];
+                    int count = results.offsets[q+1] - offset;
+                    std::copy(chunkIndices[chunk].begin() + source,
+                              chunkIndices[chunk].begin() + source + count, indices + offset);
+                    std::copy(chunkDistances[chunk].begin() + source,
+                              chunkDistances[chunk].begin() + source + count, distances + offset);
+                    source += count;
+                }
+            }
+
+            return total;
+        }
+
+        /**
+         * @brief Sorts query locations along a Morton curve over their bounds.
+         */
+        void getMortonOrder(const float* locations, int numQueries, int stride,
+                            std::vector<int>& order) const
+        {
+            const int bits = 30 / dimensions;
+
+            float minimum[dimensions];
+            float maximum[dimensions];
+            for(int axis = 0; axis < dimensions; ++axis)
+                minimum[axis] = maximum[axis] = locations[axis];
+            for(int i = 1; i < numQueries; ++i)
+            {
+                const float* location = &locations[static_cast<size_t>(i)*stride];
+                for(int axis = 0; axis < dimensions; ++axis)
+                {
+                    minimum[axis] = std::min(minimum[axis], location[axis]);
+                    maximum[axis] = std::max(maximum[axis], location[axis]);
+                }
+            }
+
+            std::vector<std::pair<unsigned int, int> > codes(numQueries);
+            for(int i = 0; i < numQueries; ++i)
+            {
+                const float* location = &locations[static_cast<size_t>(i)*stride];
+                unsigned int cell[dimensions];
+                for(int axis = 0; axis < dimensions; ++axis)
+                {
+                    float extent = maximum[axis] - minimum[axis];
+                    float t = extent > 0.0f ? (location[axis] - minimum[axis]) / extent : 0.0f;
+                    if(!(t > 0.0f))
+                        t = 0.0f;
+                    if(t > 1.0f)
+                        t = 1.0f;
+                    cell[axis] = static_cast<unsigned int>(t * ((1u << bits) - 1));
+                }
+
+                unsigned int code = 0;
+                for(int bit = bits-1; bit >= 0; --bit)
+                {
+                    for(int axis = 0; axis < dimensions; ++axis)
+                        code = (code << 1) | ((cell[axis] >> bit) & 1u);
+                }
+                codes[i] = std::make_pair(code, i);
+            }
+            std::sort(codes.begin(), codes.end());
+
+            order.resize(numQueries);
+            for(int i = 0; i < numQueries; ++i)
+                order[i] = codes[i].second;
+        }
+
+        void scanBucket(const Node& leaf, const float* location, float radius2,
+                        NearestHeap& heap) const
+        {
+            // Distances of the whole bucket first, the loops run over
+            // contiguous arrays and vectorize.
+            float distances[BUCKET_SIZE];
+            for(int i = 0; i < leaf.count; ++i)
+                distances[i] = 0.0f;
+            for(int axis = 0; axis < dimensions; ++axis)
+            {
+                const float* coords = &m_coords[axis][leaf.first];
+                const float value = location[axis];
+                for(int i = 0; i < leaf.count; ++i)
+                {
+                    float delta = coords[i] - value;
+                    distances[i] += delta*delta;
+                }
+            }
+
+            for(int i = 0; i < leaf.count; ++i)
+            {
+                if(distances[i] < heap.getBound(radius2))
+                    heap.push(m_indices[leaf.first + i], distances[i]);
+            }
+        }
+
+        std::vector<Node> m_nodes;
+        std::vector<float> m_coords[dimensions];
+        std::vector<int> m_indices;
+        KDTreeBuildStatistics m_statistics;
+    };
+}
+
+#endif  // _FLATKDTREE_H_
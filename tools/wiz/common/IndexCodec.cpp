@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "IndexCodec.h"
+#include <cstring>
+
+using namespace assembly3d;
+
+static const unsigned char codecVersion = 1;
+// Largest number of data bytes of one triangle: an auxiliary byte and
+// three 5 byte deltas.
+static const int maxTriangleData = 16;
+
+static const unsigned int noVertex = ~0u;
+
+namespace
+{
+    // Last 16 edges and vertices. Index i is the i-th most recent one.
+    struct Fifo
+    {
+        unsigned int edges[16][2];
+        unsigned int vertices[16];
+        unsigned int edgeOffset;
+        unsigned int vertexOffset;
+
+        Fifo()
+            : edgeOffset(0),
+              vertexOffset(0)
+        {
+            for(int i = 0; i < 16; ++i)
+            {
+                edges[i][0] = noVertex;
+                edges[i][1] = noVertex;
+                vertices[i] = noVertex;
+            }
+        }
+
+        const unsigned int* getEdge(int i) const
+        {
+            return edges[(edgeOffset - 1 - i) & 15];
+        }
+
+        unsigned int getVertex(int i) const
+        {
+            return vertices[(vertexOffset - 1 - i) & 15];
+        }
+
+        void pushEdge(unsigned int a, unsigned int b)
+        {
+            edges[edgeOffset & 15][0] = a;
+            edges[edgeOffset & 15][1] = b;
+            ++edgeOffset;
+        }
+
+        void pushVertex(unsigned int v)
+        {
+            vertices[vertexOffset & 15] = v;
+            ++vertexOffset;
+        }
+    };
+}
+
+// Vertex codes: 0 is the next unused vertex, 1-14 a recent vertex, 15 an
+// explicit delta.
+static int encodeVertex(unsigned int v, unsigned int next, const Fifo& fifo)
+{
+    if(v == next)
+        return 0;
+    for(int i = 0; i < 14; ++i)
+    {
+        if(fifo.getVertex(i) == v)
+            return i + 1;
+    }
+    return 15;
+}
+
+static void writeDelta(unsigned int v, unsigned int& last, std::vector<unsigned char>& data)
+{
+    int delta = (int)(v - last);
+    unsigned int zigzag = ((unsigned int)delta << 1) ^ (unsigned int)(delta >> 31);
+    while(zigzag >= 0x80)
+    {
+        data.push_back((unsigned char)(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    data.push_back((unsigned char)zigzag);
+    last = v;
+}
+
+static unsigned int readDelta(const unsigned char*& data, unsigned int& last)
+{
+    unsigned int zigzag = 0;
+    int shift = 0;
+    unsigned char byte;
+    do
+    {
+        byte = *data++;
+        zigzag |= (unsigned int)(byte & 0x7f) << shift;
+        shift += 7;
+    }
+    while((byte & 0x80) && shift < 35);
+
+    unsigned int v = last + ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    last = v;
+    return v;
+}
+
+// Applies a vertex code to the state, the same way on both sides.
+static void updateVertex(int code, unsigned int v, unsigned int& next, Fifo& fifo)
+{
+    if(code == 0)
+        ++next;
+    if(code == 0 || code == 15)
+        fifo.pushVertex(v);
+}
+
+IndexCodec::IndexCodec()
+{
+}
+
+IndexCodec::~IndexCodec()
+{
+}
+
+void IndexCodec::encode(const unsigned int* indices, int numIndices, std::vector<unsigned char>& buffer)
+{
+    const int numTriangles = numIndices / 3;
+
+    std::vector<unsigned char> codes(numTriangles);
+    std::vector<unsigned char> data;
+    data.reserve((size_t)numTriangles*2);
+
+    Fifo fifo;
+    unsigned int next = 0;
+    unsigned int last = 0;
+
+    for(int t = 0; t < numTriangles; ++t)
+    {
+        const unsigned int* triangle = indices + t*3;
+
+        int edge = -1;
+        int rotation = 0;
+        for(int i = 0; i < 15 && edge < 0; ++i)
+        {
+            const unsigned int* e = fifo.getEdge(i);
+            for(int r = 0; r < 3; ++r)
+            {
+                if(triangle[r] == e[0] && triangle[(r+1)%3] == e[1])
+                {
+                    edge = i;
+                    rotation = r;
+                    break;
+                }
+            }
+        }
+
+        if(edge >= 0)
+        {
+            unsigned int a = triangle[rotation];
+            unsigned int b = triangle[(rotation+1)%3];
+            unsigned int c = triangle[(rotation+2)%3];
+
+            int code = encodeVertex(c, next, fifo);
+            codes[t] = (unsigned char)((edge << 4) | code);
+            if(code == 15)
+                writeDelta(c, last, data);
+            updateVertex(code, c, next, fifo);
+
+            fifo.pushEdge(c, b);
+            fifo.pushEdge(a, c);
+        }
+        else
+        {
+            unsigned int a = triangle[0];
+            unsigned int b = triangle[1];
+            unsigned int c = triangle[2];
+
+            size_t aux = data.size();
+            data.push_back(0);
+
+            int codeA = encodeVertex(a, next, fifo);
+            if(codeA == 15)
+                writeDelta(a, last, data);
+            updateVertex(codeA, a, next, fifo);
+
+            int codeB = encodeVertex(b, next, fifo);
+            if(codeB == 15)
+                writeDelta(b, last, data);
+            updateVertex(codeB, b, next, fifo);
+
+            int codeC = encodeVertex(c, next, fifo);
+            if(codeC == 15)
+                writeDelta(c, last, data);
+            updateVertex(codeC, c, next, fifo);
+
+            codes[t] = (unsigned char)(0xf0 | codeA);
+            data[aux] = (unsigned char)((codeB << 4) | codeC);
+
+            fifo.pushEdge(b, a);
+            fifo.pushEdge(c, b);
+            fifo.pushEdge(a, c);
+        }
+    }
+
+    unsigned int size = (unsigned int)(1 + codes.size() + data.size() + maxTriangleData);
+    buffer.assign(sizeof(unsigned int) + size, 0);
+    memcpy(&buffer[0], &size, sizeof(unsigned int));
+    buffer[sizeof(unsigned int)] = codecVersion;
+    if(codes.empty() == false)
+        memcpy(&buffer[sizeof(unsigned int) + 1], &codes[0], codes.size());
+    if(data.empty() == false)
+        memcpy(&buffer[sizeof(unsigned int) + 1 + codes.size()], &data[0], data.size());
+}
+
+bool IndexCodec::decode(const unsigned char* buffer, size_t size, unsigned int* indices, int numIndices,
+                        unsigned int numVertices)
+{
+    if(numIndices % 3 != 0)
+        return false;
+    const int numTriangles = numIndices / 3;
+    if(size < 1 + (size_t)numTriangles + maxTriangleData || buffer[0] != codecVersion)
+        return false;
+
+    const unsigned char* codes = buffer + 1;
+    const unsigned char* data = codes + numTriangles;
+    // The padding lets a triangle read its data without further checks.
+    const unsigned char* dataEnd = buffer + size - maxTriangleData;
+
+    Fifo fifo;
+    unsigned int next = 0;
+    unsigned int last = 0;
+
+    for(int t = 0; t < numTriangles; ++t)
+    {
+        if(data > dataEnd)
+            return false;
+
+        unsigned int* triangle = indices + t*3;
+        int code = codes[t];
+        int edge = code >> 4;
+        if(edge < 15)
+        {
+            const unsigned int* e = fifo.getEdge(edge);
+            unsigned int a = e[0];
+            unsigned int b = e[1];
+
+            int codeC = code & 15;
+            unsigned int c;
+            if(codeC == 0)
+                c = next;
+            else if(codeC < 15)
+                c = fifo.getVertex(codeC - 1);
+            else
+                c = readDelta(data, last);
+            updateVertex(codeC, c, next, fifo);
+
+            triangle[0] = a;
+            triangle[1] = b;
+            triangle[2] = c;
+
+            fifo.pushEdge(c, b);
+            fifo.pushEdge(a, c);
+        }
+        else
+        {
+            int aux = *data++;
+            int vertexCodes[3] = {code & 15, aux >> 4, aux & 15};
+            for(int k = 0; k < 3; ++k)
+            {
+                unsigned int v;
+                if(vertexCodes[k] == 0)
+                    v = next;
+                else if(vertexCodes[k] < 15)
+                    v = fifo.getVertex(vertexCodes[k] - 1);
+                else
+                    v = readDelta(data, last);
+                updateVertex(vertexCodes[k], v, next, fifo);
+                triangle[k] = v;
+            }
+
+            fifo.pushEdge(triangle[1], triangle[0]);
+            fifo.pushEdge(triangle[2], triangle[1]);
+            fifo.pushEdge(triangle[0], triangle[2]);
+        }
+
+        if(triangle[0] >= numVertices || triangle[1] >= numVertices || triangle[2] >= numVertices)
+            return false;
+    }
+
+    return data <= dataEnd;
+}
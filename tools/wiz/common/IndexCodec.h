@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _INDEXCODEC_H_
+#define _INDEXCODEC_H_
+
+#include <vector>
+#include <cstddef>
+
+namespace assembly3d
+{
+    /**
+     * @brief Compression of triangle index buffers.
+     *
+     * Every triangle takes one code byte. Triangles sharing an edge with
+     * one of the last 15 triangle edges only code their third vertex: as
+     * the next unused vertex index, as one of the last 14 new vertices, or
+     * as a variable length delta to the last explicit vertex. The other
+     * triangles code all three vertices that way. Triangles may come back
+     * rotated, with the same winding. Ordering the indices for the vertex
+     * cache and the vertices by first use makes most codes hit.
+     *
+     * The block starts with its size in bytes (UNSIGNED_INT, not counted)
+     * and a version byte, followed by the code bytes, the data bytes and
+     * 16 bytes of padding.
+     */
+    class IndexCodec
+    {
+    private:
+        IndexCodec();
+        ~IndexCodec();
+    public:
+
+        /**
+         * @brief Encodes triangle indices.
+         *
+         * @param indices Triangle indices.
+         * @param numIndices Number of indices, a multiple of 3.
+         * @param buffer Receives the block, size included.
+         */
+        static void encode(const unsigned int* indices, int numIndices, std::vector<unsigned char>& buffer);
+        /**
+         * @brief Decodes triangle indices.
+         *
+         * @param buffer Block as written by encode(), without its size.
+         * @param size Size of the block.
+         * @param indices Receives numIndices indices.
+         * @param numIndices Number of indices, a multiple of 3.
+         * @param numVertices Number of vertices, all indices must be below.
+         * @return False if the block is malformed or an index is out of range.
+         */
+        static bool decode(const unsigned char* buffer, size_t size, unsigned int* indices, int numIndices,
+                           unsigned int numVertices);
+    };
+}
+
+#endif  // _INDEXCODEC_H_
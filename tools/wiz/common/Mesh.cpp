@@ -33,6 +33,7 @@
 
 #include "A3DIncludes.h"
 #include "Mesh.h"
+#include "MeshNormals.h"
 #include <limits>
 #include <cmath>
 #include <algorithm>
@@ -41,6 +42,9 @@ using namespace assembly3d;
 
 Mesh::Mesh()
 :
+m_faceNormalsValid(false),
+m_adjacencyValid(false),
+m_compactStorage(false),
 m_numVertices(0),
 m_numTriangles(0),
 m_hasPositions(false),
@@ -60,9 +64,15 @@ m_radius(0.0f)
     m_extent[0] = 0.0f;
     m_extent[1] = 0.0f;
     m_extent[2] = 0.0f;
+
+    for(int i = 0; i < 5; ++i)
+        m_strides[i] = 4;
 }
 
 Mesh::Mesh(const Mesh &m)
+:
+m_faceNormalsValid(false),
+m_adjacencyValid(false)
 {
     m_positions = m.m_positions;
     m_normals = m.m_normals;
@@ -70,6 +80,7 @@ Mesh::Mesh(const Mesh &m)
     m_tangents = m.m_tangents;
     m_bitangents = m.m_bitangents;
     m_faceNormals = m.m_faceNormals;
+    m_faceNormalsValid = m.m_faceNormalsValid;
 
     m_indices = m.m_indices;
     m_groups = m.m_groups;
@@ -77,6 +88,10 @@ Mesh::Mesh(const Mesh &m)
     m_meshPath = m.m_meshPath;
     m_format = m.m_format;
 
+    m_compactStorage = m.m_compactStorage;
+    for(int i = 0; i < 5; ++i)
+        m_strides[i] = m.m_strides[i];
+
     m_numVertices = m.m_numVertices;
     m_numTriangles = m.m_numTriangles;
     m_hasPositions = m.m_hasPositions;
@@ -116,6 +131,7 @@ Mesh& Mesh::operator=(const Mesh& m)
         m_tangents = m.m_tangents;
         m_bitangents = m.m_bitangents;
         m_faceNormals = m.m_faceNormals;
+        m_faceNormalsValid = m.m_faceNormalsValid;
 
         m_indices = m.m_indices;
         m_groups = m.m_groups;
@@ -123,6 +139,10 @@ Mesh& Mesh::operator=(const Mesh& m)
         m_meshPath = m.m_meshPath;
         m_format = m.m_format;
 
+        m_compactStorage = m.m_compactStorage;
+        for(int i = 0; i < 5; ++i)
+            m_strides[i] = m.m_strides[i];
+
         m_numVertices = m.m_numVertices;
         m_numTriangles = m.m_numTriangles;
         m_hasPositions = m.m_hasPositions;
@@ -149,9 +169,9 @@ Mesh& Mesh::operator=(const Mesh& m)
 void Mesh::bounds(float center[3], float &width, float &height,
                       float &length, float &radius, float extent[3]) const
 {
-    float xMax = std::numeric_limits<float>::min();
-    float yMax = std::numeric_limits<float>::min();
-    float zMax = std::numeric_limits<float>::min();
+    float xMax = -std::numeric_limits<float>::max();
+    float yMax = -std::numeric_limits<float>::max();
+    float zMax = -std::numeric_limits<float>::max();
 
     float xMin = std::numeric_limits<float>::max();
     float yMin = std::numeric_limits<float>::max();
@@ -161,13 +181,14 @@ void Mesh::bounds(float center[3], float &width, float &height,
     float y = 0.0f;
     float z = 0.0f;
 
-    int numVerts = static_cast<int>(m_positions.size()) / 4;
+    const int stride = m_strides[POSITION];
+    int numVerts = static_cast<int>(m_positions.size()) / stride;
 
     for (int i = 0; i < numVerts; ++i)
     {
-        x = m_positions.at(i*4 + 0);
-        y = m_positions.at(i*4 + 1);
-        z = m_positions.at(i*4 + 2);
+        x = m_positions.at(i*stride + 0);
+        y = stride > 1 ? m_positions.at(i*stride + 1) : 0.0f;
+        z = stride > 2 ? m_positions.at(i*stride + 2) : 0.0f;
 
         if (x < xMin)
             xMin = x;
@@ -216,6 +237,7 @@ void Mesh::addAttribute(const char* attrName, int attrSize, const char* attrType
         m_format.attributeSize.push_back(attrSize);
         m_format.attributeType.push_back(attrType);
         ++m_format.attributeCount;
+        updateStrides();
     }
 }
 
@@ -334,22 +356,26 @@ void Mesh::destroy()
 
     m_groups.clear();
     m_indices.clear();
+    invalidateAdjacency();
 
     m_positions.clear();
     m_normals.clear();
     m_texCoords.clear();
     m_tangents.clear();
     m_bitangents.clear();
-    m_faceNormals.clear();
+    invalidateNormals();
 
     m_format.name = "Assembly3D.mesh";
     m_format.attributeName.clear();
     m_format.attributeSize.clear();
     m_format.attributeType.clear();
+    m_format.compressedAttributes.clear();
     m_format.indexType = "UNSIGNED_INT";
     m_format.attributeCount = 0;
     m_format.isBinary = false;
-    
+
+    for(int i = 0; i < 5; ++i)
+        m_strides[i] = 4;
 }
 
 void Mesh::calculateBounds()
@@ -395,6 +421,7 @@ void Mesh::hasBitangents(bool val)
 void Mesh::setPositions(const std::vector<float>& positions)
 {
     m_positions = positions;
+    invalidateNormals();
 }
 void Mesh::setNormals(const std::vector<float>& normals)
 {
@@ -412,39 +439,60 @@ void Mesh::setBitangents(const std::vector<float>& bitangents)
 {
     m_bitangents = bitangents;
 }
-void Mesh::addPosition(float* position, int size)
+void Mesh::swapAttribute(AttributeType type, std::vector<float>& data)
 {
-    for(int i = 0; i < size; ++i)
+    switch(type)
     {
-        m_positions.push_back(position[i]);
+    case Mesh::POSITION:
+        m_positions.swap(data);
+        invalidateNormals();
+        break;
+    case Mesh::NORMAL:
+        m_normals.swap(data);
+        break;
+    case Mesh::TEXCOORD:
+        m_texCoords.swap(data);
+        break;
+    case Mesh::TANGENT:
+        m_tangents.swap(data);
+        break;
+    case Mesh::BITANGENT:
+        m_bitangents.swap(data);
+        break;
     }
 }
+void Mesh::addPosition(float* position, int size)
+{
+    addAttributeValue(POSITION, m_positions, position, size);
+    m_faceNormalsValid = false;
+}
 void Mesh::addNormal(float* normal, int size)
 {
-    for(int i = 0; i < size; ++i)
-    {
-        m_normals.push_back(normal[i]);
-    }
+    addAttributeValue(NORMAL, m_normals, normal, size);
 }
 void Mesh::addTexCoord(float* texCoord, int size)
 {
-    for(int i = 0; i < size; ++i)
-    {
-        m_texCoords.push_back(texCoord[i]);
-    }
+    addAttributeValue(TEXCOORD, m_texCoords, texCoord, size);
 }
 void Mesh::addTangent(float* tangent, int size)
 {
-    for(int i = 0; i < size; ++i)
-    {
-        m_tangents.push_back(tangent[i]);
-    }
+    addAttributeValue(TANGENT, m_tangents, tangent, size);
 }
 void Mesh::addBitangent(float* bitangent, int size)
 {
-    for(int i = 0; i < size; ++i)
+    addAttributeValue(BITANGENT, m_bitangents, bitangent, size);
+}
+
+void Mesh::addAttributeValue(AttributeType type, std::vector<float>& data,
+                             const float* value, int size)
+{
+    const int stride = m_strides[type];
+    for(int i = 0; i < stride; ++i)
     {
-        m_bitangents.push_back(bitangent[i]);
+        if(i < size)
+            data.push_back(value[i]);
+        else
+            data.push_back(i < 3 ? 0.0f : 1.0f);
     }
 }
 
@@ -456,24 +504,73 @@ void Mesh::clearVertices()
     m_texCoords.clear();
     m_tangents.clear();
     m_bitangents.clear();
-    m_faceNormals.clear();
+    invalidateNormals();
 }
 void Mesh::addIndex(unsigned int index)
 {
     m_indices.push_back(index);
+    m_adjacencyValid = false;
+    m_faceNormalsValid = false;
 }
 void Mesh::clearIndices()
 {
     m_indices.clear();
+    invalidateAdjacency();
+}
+void Mesh::setIndices(const std::vector<unsigned int>& indices)
+{
+    m_indices = indices;
+    invalidateAdjacency();
+}
+void Mesh::swapIndices(std::vector<unsigned int>& indices)
+{
+    m_indices.swap(indices);
+    invalidateAdjacency();
+}
+
+static void gatherAttribute(std::vector<float>& data, int stride,
+                            const std::vector<unsigned int>& newToOld)
+{
+    if(data.empty())
+        return;
+
+    std::vector<float> gathered(newToOld.size()*stride);
+    for(size_t i = 0; i < newToOld.size(); ++i)
+    {
+        const float* src = &data[newToOld[i]*stride];
+        float* dst = &gathered[i*stride];
+        for(int j = 0; j < stride; ++j)
+            dst[j] = src[j];
+    }
+    data.swap(gathered);
+}
+
+void Mesh::remapVertices(const std::vector<unsigned int>& newToOld)
+{
+    gatherAttribute(m_positions, m_strides[POSITION], newToOld);
+    gatherAttribute(m_normals, m_strides[NORMAL], newToOld);
+    gatherAttribute(m_texCoords, m_strides[TEXCOORD], newToOld);
+    gatherAttribute(m_tangents, m_strides[TANGENT], newToOld);
+    gatherAttribute(m_bitangents, m_strides[BITANGENT], newToOld);
+    invalidateNormals();
+
+    m_numVertices = static_cast<int>(newToOld.size());
+    invalidateAdjacency();
 }
 void Mesh::addGroup(Group group)
 {
     m_groups.push_back(group);
 }
 
+void Mesh::setGroups(const std::vector<Group>& groups)
+{
+    m_groups = groups;
+}
+
 void Mesh::setNumVertices(int numVertices)
 {
     m_numVertices = numVertices;
+    invalidateAdjacency();
 }
 
 void Mesh::setNumTriangles(int numTriangles)
@@ -481,6 +578,64 @@ void Mesh::setNumTriangles(int numTriangles)
     m_numTriangles = numTriangles;
 }
 
+static void repackAttribute(std::vector<float>& data, int fromStride,
+                            int toStride)
+{
+    if(data.empty() || fromStride == toStride)
+        return;
+
+    const size_t numVertices = data.size() / fromStride;
+    std::vector<float> repacked(numVertices*toStride);
+    for(size_t i = 0; i < numVertices; ++i)
+    {
+        const float* src = &data[i*fromStride];
+        float* dst = &repacked[i*toStride];
+        for(int j = 0; j < toStride; ++j)
+        {
+            if(j < fromStride)
+                dst[j] = src[j];
+            else
+                dst[j] = j < 3 ? 0.0f : 1.0f;
+        }
+    }
+    data.swap(repacked);
+}
+
+void Mesh::setCompactStorage(bool compact)
+{
+    int oldStrides[5];
+    for(int i = 0; i < 5; ++i)
+        oldStrides[i] = m_strides[i];
+
+    m_compactStorage = compact;
+    updateStrides();
+
+    repackAttribute(m_positions, oldStrides[POSITION], m_strides[POSITION]);
+    repackAttribute(m_normals, oldStrides[NORMAL], m_strides[NORMAL]);
+    repackAttribute(m_texCoords, oldStrides[TEXCOORD], m_strides[TEXCOORD]);
+    repackAttribute(m_tangents, oldStrides[TANGENT], m_strides[TANGENT]);
+    repackAttribute(m_bitangents, oldStrides[BITANGENT], m_strides[BITANGENT]);
+}
+
+void Mesh::updateStrides()
+{
+    static const char* names[5] = {"POSITION", "NORMAL", "TEXCOORD",
+                                   "TANGENT", "BITANGENT"};
+    static const int defaultSizes[5] = {3, 3, 2, 3, 3};
+
+    for(int i = 0; i < 5; ++i)
+    {
+        m_strides[i] = 4;
+        if(m_compactStorage)
+        {
+            int idx = getAttributeIndexWithName(names[i]);
+            int size = idx != -1 ? m_format.attributeSize[idx] : defaultSizes[i];
+            if(size >= 1 && size <= 4)
+                m_strides[i] = size;
+        }
+    }
+}
+
 void Mesh::initializeMeshFormat()
 {
     m_format.name = "Assembly3D.mesh";
@@ -530,103 +685,33 @@ void Mesh::initializeMeshFormat()
         m_format.attributeType.push_back("FLOAT");
     }
 
+    updateStrides();
 }
 
 float* Mesh::getFaceNormals()
 {
-    const unsigned int *pTriangle = 0;
-    float edge1[3] = {0.0f, 0.0f, 0.0f};
-    float edge2[3] = {0.0f, 0.0f, 0.0f};
-    float normal[3] = {0.0f, 0.0f, 0.0f};
-    float length = 0.0f;
-    int totalVertices = this->getNumberOfVertices();
-    int totalTriangles = this->getNumberOfTriangles();
-
-    // Initialize all the vertex normals.
-    m_faceNormals.clear();
-    m_faceNormals.assign(totalVertices*4, 0.0f);
-	
-	
-
-    // Calculate the vertex normals.
-    for (int i = 0; i < totalTriangles; ++i)
+    if(m_faceNormalsValid == false)
     {
-        pTriangle = this->getTriangle(i);
-        float* pPosition0 = getPosition(pTriangle[0]);
-        float* pPosition1 = getPosition(pTriangle[1]);
-        float* pPosition2 = getPosition(pTriangle[2]);
-
-        // Calculate triangle face normal.
-
-        edge1[0] = pPosition1[0] - pPosition0[0];
-        edge1[1] = pPosition1[1] - pPosition0[1];
-        edge1[2] = pPosition1[2] - pPosition0[2];
-
-        edge2[0] = pPosition2[0] - pPosition0[0];
-        edge2[1] = pPosition2[1] - pPosition0[1];
-        edge2[2] = pPosition2[2] - pPosition0[2];
-
-        normal[0] = (edge1[1] * edge2[2]) - (edge1[2] * edge2[1]);
-        normal[1] = (edge1[2] * edge2[0]) - (edge1[0] * edge2[2]);
-        normal[2] = (edge1[0] * edge2[1]) - (edge1[1] * edge2[0]);
-
-        // normalizing
-        length = 0.0f;
-        float tmpLength = 0.0f;
-        tmpLength = sqrtf(normal[0] * normal[0] +
-            normal[1] * normal[1] +
-            normal[2] * normal[2]);
-
-        if(tmpLength == 0.0f)
-            length = 0.0f;
-        else
-            length = 1.0f / tmpLength;
-
-        normal[0] *= length;
-        normal[1] *= length;
-        normal[2] *= length;
-
-
-        // Accumulate the normals.
-        float* pNormal0 = &m_faceNormals[pTriangle[0]*4];
-        float* pNormal1 = &m_faceNormals[pTriangle[1]*4];
-        float* pNormal2 = &m_faceNormals[pTriangle[2]*4];
-
-        pNormal0[0] += normal[0];
-        pNormal0[1] += normal[1];
-        pNormal0[2] += normal[2];
-
-        pNormal1[0] += normal[0];
-        pNormal1[1] += normal[1];
-        pNormal1[2] += normal[2];
-
-        pNormal2[0] += normal[0];
-        pNormal2[1] += normal[1];
-        pNormal2[2] += normal[2];
-
+        const MeshAdjacency& adjacency = getAdjacency();
+        const unsigned int* indices = m_indices.empty() ? 0 : &m_indices[0];
+        const float* positions = m_positions.empty() ? 0 : &m_positions[0];
+
+        std::vector<float> triangleNormals;
+        MeshNormals::computeTriangleNormals(positions, m_strides[POSITION], indices,
+                                            adjacency.getNumberOfTriangles(), triangleNormals);
+        MeshNormals::computeVertexNormals(positions, m_strides[POSITION], indices, adjacency,
+                                          triangleNormals, MeshNormals::UNWEIGHTED, m_faceNormals);
+        m_faceNormalsValid = true;
     }
-
-    // Normalize the vertex normals.
-    for (int i = 0; i < totalVertices; ++i)
-    {
-        float* pNormal = &m_faceNormals[i*4];
-
-        float tmpLength = sqrtf(pNormal[0] * pNormal[0] +
-            pNormal[1] * pNormal[1] + pNormal[2] * pNormal[2]);
-
-        if(tmpLength == 0.0f)
-            length = 0.0f;
-        else
-            length = 1.0f / tmpLength;
-
-        pNormal[0] *= length;
-        pNormal[1] *= length;
-        pNormal[2] *= length;
-    }
-	
 	return &m_faceNormals[0];
 }
 
+void Mesh::invalidateNormals()
+{
+    m_faceNormals.clear();
+    m_faceNormalsValid = false;
+}
+
 Mesh::Attribute Mesh::getAttribute(Mesh::AttributeType type)
 {
     Mesh::Attribute attribute;
@@ -638,6 +723,7 @@ Mesh::Attribute Mesh::getAttribute(Mesh::AttributeType type)
 			attribute.count = static_cast<int>(m_positions.size());
 			idx = getAttributeIndexWithName("POSITION");
 			attribute.size = m_format.attributeSize[idx];
+			attribute.stride = m_strides[type];
 			attribute.type = Mesh::POSITION;
 			break;
 		case Mesh::NORMAL:
@@ -645,6 +731,7 @@ Mesh::Attribute Mesh::getAttribute(Mesh::AttributeType type)
 			attribute.count = static_cast<int>(m_normals.size());
 			idx = getAttributeIndexWithName("NORMAL");
 			attribute.size = m_format.attributeSize[idx];
+			attribute.stride = m_strides[type];
 			attribute.type = Mesh::NORMAL;
 			break;
 		case Mesh::TEXCOORD:
@@ -652,6 +739,7 @@ Mesh::Attribute Mesh::getAttribute(Mesh::AttributeType type)
 			attribute.count = static_cast<int>(m_texCoords.size());
 			idx = getAttributeIndexWithName("TEXCOORD");
 			attribute.size = m_format.attributeSize[idx];
+			attribute.stride = m_strides[type];
 			attribute.type = Mesh::TEXCOORD;
 			break;
 		case Mesh::TANGENT:
@@ -659,6 +747,7 @@ Mesh::Attribute Mesh::getAttribute(Mesh::AttributeType type)
 			attribute.count = static_cast<int>(m_tangents.size());
 			idx = getAttributeIndexWithName("TANGENT");
 			attribute.size = m_format.attributeSize[idx];
+			attribute.stride = m_strides[type];
 			attribute.type = Mesh::TANGENT;
 			break;
 		case Mesh::BITANGENT:
@@ -666,24 +755,44 @@ Mesh::Attribute Mesh::getAttribute(Mesh::AttributeType type)
 			attribute.count = static_cast<int>(m_bitangents.size());
 			idx = getAttributeIndexWithName("BITANGENT");
 			attribute.size = m_format.attributeSize[idx];
+			attribute.stride = m_strides[type];
 			attribute.type = Mesh::BITANGENT;
 			break;
 		default:
 			attribute.data = 0;
 			attribute.count = 0;
 			attribute.size = 0;
+			attribute.stride = 0;
 			break;
     }
 
     return attribute;
 }
 
+const MeshAdjacency& Mesh::getAdjacency()
+{
+    if(m_adjacencyValid == false)
+    {
+        m_adjacency.build(m_indices.empty() ? 0 : &m_indices[0],
+                          static_cast<int>(m_indices.size() / 3), m_numVertices);
+        m_adjacencyValid = true;
+    }
+    return m_adjacency;
+}
+
+void Mesh::invalidateAdjacency()
+{
+    m_adjacency.clear();
+    m_adjacencyValid = false;
+    invalidateNormals();
+}
+
 void assembly3d::Mesh::printAttribute(assembly3d::Mesh::Attribute a)
 {
-    for(int i = 0; i < a.count/a.size; ++i){
+    for(int i = 0; i < a.count/a.stride; ++i){
         for(int j = 0; j < a.size; ++j)
         {
-            std::cout << a.data[i*a.size + j];
+            std::cout << a.data[i*a.stride + j];
         }
         std::cout << std::endl;
     }
@@ -37,6 +37,7 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include "MeshAdjacency.h"
 
 namespace assembly3d
 {
@@ -55,6 +56,11 @@ namespace assembly3d
             BITANGENT
         };
 
+        enum PrimitiveType{
+            TRIANGLES=0,
+            TRIANGLE_STRIP
+        };
+
         /**
          * @brief Mesh format information.
          *
@@ -66,6 +72,7 @@ namespace assembly3d
             std::vector<std::string> attributeName;
             std::vector<int> attributeSize;
             std::vector<std::string> attributeType;
+            std::vector<std::string> compressedAttributes;
             std::string indexType;
             bool isBinary;
         };
@@ -76,11 +83,12 @@ namespace assembly3d
             float* data;
             int count;
             int size;
+            int stride;
             AttributeType type;
 			
 			void get(unsigned int index, float* outElem)
 			{
-				float* d = &data[index*size];
+				float* d = &data[index*stride];
 				for(int i=0; i<size; i++)
 				{
 					outElem[i] = d[i];
@@ -97,7 +105,7 @@ namespace assembly3d
 								
 			void set(unsigned int index, float* outElem)            
 			{
-				float* d = &data[index*size];
+				float* d = &data[index*stride];
 				for(int i=0; i<size; i++)
 				{
 					d[i] = outElem[i];
@@ -111,6 +119,7 @@ namespace assembly3d
             char* name;
             int startIndex;
             int triangleCount;
+            PrimitiveType primitiveType;    ///< How the group is stored, always a list in memory.
         };
 
         Mesh();
@@ -133,15 +142,54 @@ namespace assembly3d
         /**
          * @brief Sets the format of mesh indices.
          *
-         * @param format A format string for indices (UNSIGNED_BYTE, UNSIGNED_SHORT or UNSIGNED_INT)
+         * @param format A format string for indices (UNSIGNED_BYTE, UNSIGNED_SHORT, UNSIGNED_INT or ENCODED)
         */
         void setIndexFormat(const char* format);
 
         /**
-         * @brief Generates face normals for mesh.
+         * @brief Switches between padded and compact attribute storage.
+         *
+         * Padded storage keeps every attribute at 4 floats per vertex,
+         * compact storage keeps each attribute at its declared size.
+         * Existing attribute data is repacked.
+         *
+         * @param compact True for compact storage.
+        */
+        void setCompactStorage(bool compact);
+        /**
+         * @brief Returns true if attributes are stored at their declared size.
+         *
+        */
+        bool isCompactStorage() const;
+        /**
+         * @brief Gets the number of floats between two vertices of an attribute.
+         *
+         * @param type The attribute.
+         * @return 4 for padded storage, the declared size for compact storage.
+        */
+        int getStride(AttributeType type) const;
+        /**
+         * @brief Re-reads the attribute strides from the mesh format.
          *
+         * Needed after the format of a compact mesh has been edited
+         * directly. Attribute data is not repacked.
+        */
+        void updateStrides();
+
+        /**
+         * @brief Gets smooth vertex normals generated from the triangles.
+         *
+         * The unit normals of the triangles around each vertex are
+         * averaged, 4 floats per vertex. The result is cached until
+         * positions or indices change through the mesh.
         */
         float* getFaceNormals();
+        /**
+         * @brief Drops the cached normals of getFaceNormals().
+         *
+         * Needed after positions have been edited through pointers.
+        */
+        void invalidateNormals();
 
         float* getPosition(unsigned int index);
         float* getNormal(unsigned int index);
@@ -234,15 +282,27 @@ namespace assembly3d
         MeshFormat& getMeshFormat();
 
         /**
-         * @brief Adds a vertex to the mesh.
+         * @brief Sets attribute data.
          *
-         * @param vertex A vertex.
+         * The data has to be laid out with the attribute's stride. The
+         * add functions take size components and pad or cut them to the
+         * stride.
         */
         void setPositions(const std::vector<float>& positions);
         void setNormals(const std::vector<float>& normals);
         void setTexCoords(const std::vector<float>& texCoords);
         void setTangents(const std::vector<float>& tangents);
         void setBitangents(const std::vector<float>& bitangents);
+        /**
+         * @brief Moves stride-4 attribute data into the mesh.
+         *
+         * Swaps data with the mesh's buffer, so no copy is made. data
+         * receives the previous contents.
+         *
+         * @param type Attribute to set.
+         * @param data Attribute data to swap in.
+        */
+        void swapAttribute(AttributeType type, std::vector<float>& data);
         void addPosition(float* position, int size=4);
         void addNormal(float* normal, int size=4);
         void addTexCoord(float* texCoord, int size=4);
@@ -265,6 +325,27 @@ namespace assembly3d
          *
         */
         void clearIndices();
+        /**
+         * @brief Replaces all indices.
+         *
+         * @param indices The new triangle indices.
+        */
+        void setIndices(const std::vector<unsigned int>& indices);
+        /**
+         * @brief Moves indices into the mesh without copying.
+         *
+         * @param indices Indices to swap with the mesh's indices.
+        */
+        void swapIndices(std::vector<unsigned int>& indices);
+        /**
+         * @brief Rebuilds all vertex attributes from a vertex remap.
+         *
+         * New vertex i gets the attributes of old vertex newToOld[i].
+         * Indices are left untouched.
+         *
+         * @param newToOld Old vertex index for every new vertex.
+        */
+        void remapVertices(const std::vector<unsigned int>& newToOld);
 
         /**
          * @brief Adds a group to the mesh.
@@ -272,6 +353,12 @@ namespace assembly3d
          * @param group A group.
         */
         void addGroup(Group group);
+        /**
+         * @brief Replaces all groups of the mesh.
+         *
+         * @param groups The new groups.
+        */
+        void setGroups(const std::vector<Group>& groups);
         /**
          * @brief Sets the number of vertices.
          *
@@ -415,6 +502,20 @@ namespace assembly3d
         void updateVecs();
 
         Attribute getAttribute(AttributeType type);
+        /**
+         * @brief Gets the vertex and edge adjacency of the triangles.
+         *
+         * Built on first use and kept until the indices or the number
+         * of vertices change through the mesh.
+        */
+        const MeshAdjacency& getAdjacency();
+        /**
+         * @brief Drops the cached adjacency.
+         *
+         * Needed after indices have been edited through getTriangle()
+         * or getIndicesPointer(). Also drops the cached normals.
+        */
+        void invalidateAdjacency();
 
     private:
 
@@ -431,6 +532,9 @@ namespace assembly3d
         void bounds(float center[3], float &width, float &height,
         float &length, float &radius, float extent[3]) const;
 
+        void addAttributeValue(AttributeType type, std::vector<float>& data,
+                               const float* value, int size);
+
         std::vector<float> m_positions;
         std::vector<float> m_normals;
         std::vector<float> m_texCoords;
@@ -438,14 +542,20 @@ namespace assembly3d
         std::vector<float> m_bitangents;
 		
 		std::vector<float> m_faceNormals;
+        bool m_faceNormalsValid;
 
         std::vector<unsigned int> m_indices;
         std::vector<Group> m_groups;
+        MeshAdjacency m_adjacency;
+        bool m_adjacencyValid;
 
         MeshFormat m_format;
 
         std::string m_meshPath;
 
+        bool m_compactStorage;
+        int m_strides[5];
+
         int m_numVertices;
         int m_numTriangles;
 
@@ -513,19 +623,25 @@ namespace assembly3d
     { x = m_extent[0]; y = m_extent[1]; z = m_extent[2]; }
 
     inline float* Mesh::getPosition(unsigned int index)
-    { return &m_positions[index * 4]; }
+    { return &m_positions[index * m_strides[POSITION]]; }
 
     inline float* Mesh::getNormal(unsigned int index)
-    { return &m_normals[index * 4]; }
+    { return &m_normals[index * m_strides[NORMAL]]; }
 
     inline float* Mesh::getTexCoord(unsigned int index)
-    { return &m_texCoords[index * 4]; }
+    { return &m_texCoords[index * m_strides[TEXCOORD]]; }
 
     inline float* Mesh::getTangent(unsigned int index)
-    { return &m_tangents[index * 4]; }
+    { return &m_tangents[index * m_strides[TANGENT]]; }
 
     inline float* Mesh::getBitangent(unsigned int index)
-    { return &m_bitangents[index * 4]; }
+    { return &m_bitangents[index * m_strides[BITANGENT]]; }
+
+    inline bool Mesh::isCompactStorage() const
+    { return m_compactStorage; }
+
+    inline int Mesh::getStride(AttributeType type) const
+    { return m_strides[type]; }
 
     inline Mesh::Group& Mesh::getGroup(unsigned int index)
     { return m_groups[index]; }
@@ -564,22 +680,22 @@ namespace assembly3d
     { return m_meshPath.c_str(); }
 
     inline float* Mesh::getPositionsPointer()
-    { return &m_positions[0]; }
+    { return m_positions.empty() ? 0 : &m_positions[0]; }
 
     inline float* Mesh::getNormalsPointer()
-    { return &m_normals[0]; }
+    { return m_normals.empty() ? 0 : &m_normals[0]; }
 
     inline float* Mesh::getTexCoordsPointer()
-    { return &m_texCoords[0]; }
+    { return m_texCoords.empty() ? 0 : &m_texCoords[0]; }
 
     inline float* Mesh::getTangentsPointer()
-    { return &m_tangents[0]; }
+    { return m_tangents.empty() ? 0 : &m_tangents[0]; }
 
     inline float* Mesh::getBitangentsPointer()
-    { return &m_bitangents[0]; }
+    { return m_bitangents.empty() ? 0 : &m_bitangents[0]; }
 
     inline unsigned int* Mesh::getIndicesPointer()
-    { return &m_indices[0]; }
+    { return m_indices.empty() ? 0 : &m_indices[0]; }
 
 }
 #endif  // _MESH_H_
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshAdjacency.h"
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace assembly3d;
+
+namespace
+{
+    // Below this many keys the bucket sort runs on one thread.
+    const int PARALLEL_MIN_KEYS = 1 << 16;
+
+    inline unsigned int nextHalfEdge(unsigned int halfEdge)
+    {
+        return halfEdge % 3 == 2 ? halfEdge - 2 : halfEdge + 1;
+    }
+
+    // Orders the half-edges starting at one vertex by their other vertex.
+    struct OtherVertexLess
+    {
+        OtherVertexLess(const unsigned int* indices) : indices(indices) {}
+        unsigned int other(unsigned int halfEdge) const
+        {
+            return std::max(indices[halfEdge], indices[nextHalfEdge(halfEdge)]);
+        }
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            unsigned int otherA = other(a);
+            unsigned int otherB = other(b);
+            return otherA < otherB || (otherA == otherB && a < b);
+        }
+        const unsigned int* indices;
+    };
+}
+
+MeshAdjacency::MeshAdjacency()
+:
+m_numVertices(0),
+m_numTriangles(0)
+{
+}
+
+MeshAdjacency::~MeshAdjacency()
+{
+}
+
+void MeshAdjacency::clear()
+{
+    m_numVertices = 0;
+    m_numTriangles = 0;
+    m_vertexOffsets.clear();
+    m_vertexTriangles.clear();
+    m_edgeVertices.clear();
+    m_edgeOffsets.clear();
+    m_edgeHalfEdges.clear();
+    m_halfEdgeEdges.clear();
+}
+
+void MeshAdjacency::bucketSort(const unsigned int* keys, int numKeys, int numBuckets,
+                               std::vector<int>& offsets, std::vector<unsigned int>& items)
+{
+    offsets.assign(numBuckets+1, 0);
+    items.resize(numKeys);
+
+    // Every part counts a range of the keys into its own histogram. The
+    // histograms together are kept no larger than the keys.
+    int numParts = 1;
+#ifdef _OPENMP
+    if(numKeys >= PARALLEL_MIN_KEYS)
+        numParts = std::max(1, std::min(omp_get_max_threads(), numKeys / std::max(numBuckets, 1)));
+#endif
+
+    std::vector<int> counts((size_t)numParts*numBuckets, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(numParts > 1)
+#endif
+    for(int part = 0; part < numParts; ++part)
+    {
+        int* partCounts = numBuckets > 0 ? &counts[(size_t)part*numBuckets] : 0;
+        const int first = (int)((long long)numKeys * part / numParts);
+        const int last = (int)((long long)numKeys * (part+1) / numParts);
+        for(int i = first; i < last; ++i)
+            ++partCounts[keys[i]];
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for if(numParts > 1)
+#endif
+    for(int b = 0; b < numBuckets; ++b)
+    {
+        int total = 0;
+        for(int part = 0; part < numParts; ++part)
+            total += counts[(size_t)part*numBuckets + b];
+        offsets[b+1] = total;
+    }
+
+    for(int i = 0; i < numBuckets; ++i)
+        offsets[i+1] += offsets[i];
+
+    // The counts become the write positions of every part. Lower parts
+    // come first in a bucket, so the items keep the key order.
+#ifdef _OPENMP
+#pragma omp parallel for if(numParts > 1)
+#endif
+    for(int b = 0; b < numBuckets; ++b)
+    {
+        int position = offsets[b];
+        for(int part = 0; part < numParts; ++part)
+        {
+            int count = counts[(size_t)part*numBuckets + b];
+            counts[(size_t)part*numBuckets + b] = position;
+            position += count;
+        }
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(numParts > 1)
+#endif
+    for(int part = 0; part < numParts; ++part)
+    {
+        int* partCounts = numBuckets > 0 ? &counts[(size_t)part*numBuckets] : 0;
+        const int first = (int)((long long)numKeys * part / numParts);
+        const int last = (int)((long long)numKeys * (part+1) / numParts);
+        for(int i = first; i < last; ++i)
+            items[partCounts[keys[i]]++] = i;
+    }
+}
+
+void MeshAdjacency::build(const unsigned int* indices, int numTriangles, int numVertices)
+{
+    clear();
+    m_numVertices = numVertices;
+    m_numTriangles = numTriangles;
+
+    const int numHalfEdges = numTriangles*3;
+
+    // -------------------------------------------------
+    // Vertex -> triangles
+    // -------------------------------------------------
+    bucketSort(indices, numHalfEdges, numVertices, m_vertexOffsets, m_vertexTriangles);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i = 0; i < numHalfEdges; ++i)
+        m_vertexTriangles[i] /= 3;
+
+    // -------------------------------------------------
+    // Edges
+    // -------------------------------------------------
+    // Half-edges are bucketed by their smaller vertex, then every bucket
+    // is sorted by the other vertex. Runs with the same other vertex are
+    // the half-edges of one edge.
+    std::vector<unsigned int> minVertex(numHalfEdges);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int h = 0; h < numHalfEdges; ++h)
+        minVertex[h] = std::min(indices[h], indices[nextHalfEdge(h)]);
+
+    std::vector<int> bucketOffsets;
+    bucketSort(numHalfEdges > 0 ? &minVertex[0] : 0, numHalfEdges, numVertices,
+               bucketOffsets, m_edgeHalfEdges);
+    minVertex.clear();
+
+    OtherVertexLess less(indices);
+    std::vector<int> edgeStart(numVertices+1, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+    for(int v = 0; v < numVertices; ++v)
+    {
+        unsigned int* first = numHalfEdges > 0 ? &m_edgeHalfEdges[0] + bucketOffsets[v] : 0;
+        unsigned int* last = numHalfEdges > 0 ? &m_edgeHalfEdges[0] + bucketOffsets[v+1] : 0;
+        if(last - first > 1)
+            std::sort(first, last, less);
+
+        int numEdges = 0;
+        for(unsigned int* it = first; it != last; ++it)
+        {
+            if(it == first || less.other(*it) != less.other(*(it-1)))
+                ++numEdges;
+        }
+        edgeStart[v+1] = numEdges;
+    }
+
+    for(int v = 0; v < numVertices; ++v)
+        edgeStart[v+1] += edgeStart[v];
+
+    const int numEdges = edgeStart[numVertices];
+    m_edgeVertices.resize(numEdges*2);
+    m_edgeOffsets.resize(numEdges+1);
+    m_edgeOffsets[numEdges] = numHalfEdges;
+    m_halfEdgeEdges.resize(numHalfEdges);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+    for(int v = 0; v < numVertices; ++v)
+    {
+        int edge = edgeStart[v] - 1;
+        for(int i = bucketOffsets[v]; i < bucketOffsets[v+1]; ++i)
+        {
+            unsigned int halfEdge = m_edgeHalfEdges[i];
+            unsigned int other = less.other(halfEdge);
+            if(i == bucketOffsets[v] || other != less.other(m_edgeHalfEdges[i-1]))
+            {
+                ++edge;
+                m_edgeVertices[edge*2] = v;
+                m_edgeVertices[edge*2+1] = other;
+                m_edgeOffsets[edge] = i;
+            }
+            m_halfEdgeEdges[halfEdge] = edge;
+        }
+    }
+}
+
+int MeshAdjacency::getOppositeHalfEdge(unsigned int halfEdge) const
+{
+    int edge = m_halfEdgeEdges[halfEdge];
+    if(getEdgeHalfEdgeCount(edge) != 2)
+        return -1;
+    const unsigned int* halfEdges = getEdgeHalfEdges(edge);
+    return static_cast<int>(halfEdges[0] == halfEdge ? halfEdges[1] : halfEdges[0]);
+}
+
+bool MeshAdjacency::isEdgeManifold() const
+{
+    for(int i = 0; i < getNumberOfEdges(); ++i)
+    {
+        if(getEdgeHalfEdgeCount(i) > 2)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _MESHADJACENCY_H_
+#define _MESHADJACENCY_H_
+
+#include <vector>
+
+namespace assembly3d
+{
+    /**
+     * @brief Vertex and edge adjacency of a triangle list.
+     *
+     * Vertex to triangle lists and edge to half-edge lists are stored in
+     * compressed row form. Half-edge h = 3*triangle + corner runs from
+     * that corner to the next one of the triangle. Every undirected edge
+     * is stored once with its smaller vertex first. All lists are in
+     * ascending order, so the result does not depend on the number of
+     * threads.
+     */
+    class MeshAdjacency
+    {
+    public:
+        MeshAdjacency();
+        ~MeshAdjacency();
+
+        /**
+         * @brief Builds the adjacency in linear time.
+         *
+         * The lists are built with counting sorts. With OpenMP every
+         * thread owns a range of vertices, so no two threads write the
+         * same list.
+         *
+         * @param indices Triangle indices, all below numVertices.
+         * @param numTriangles Number of triangles.
+         * @param numVertices Number of vertices.
+         */
+        void build(const unsigned int* indices, int numTriangles, int numVertices);
+        /**
+         * @brief Releases all lists.
+         *
+        */
+        void clear();
+
+        int getNumberOfVertices() const;
+        int getNumberOfTriangles() const;
+        int getNumberOfEdges() const;
+
+        /**
+         * @brief Gets the number of triangles using a vertex.
+         *
+        */
+        int getVertexTriangleCount(unsigned int vertex) const;
+        /**
+         * @brief Gets the triangles using a vertex.
+         *
+         * A triangle that uses the vertex twice is listed twice.
+        */
+        const unsigned int* getVertexTriangles(unsigned int vertex) const;
+
+        /**
+         * @brief Gets the vertices of an edge, v0 <= v1.
+         *
+        */
+        void getEdgeVertices(int edge, unsigned int& v0, unsigned int& v1) const;
+        /**
+         * @brief Gets the number of half-edges on an edge.
+         *
+         * 1 for boundary edges, 2 for manifold inner edges.
+        */
+        int getEdgeHalfEdgeCount(int edge) const;
+        /**
+         * @brief Gets the half-edges on an edge.
+         *
+        */
+        const unsigned int* getEdgeHalfEdges(int edge) const;
+        /**
+         * @brief Gets the edge of a half-edge.
+         *
+         * @param halfEdge 3*triangle + corner.
+        */
+        int getEdge(unsigned int halfEdge) const;
+        /**
+         * @brief Gets the other half-edge of a manifold edge.
+         *
+         * @return The half-edge or -1 for boundary and non-manifold edges.
+        */
+        int getOppositeHalfEdge(unsigned int halfEdge) const;
+        /**
+         * @brief Returns true if no edge is shared by more than two triangles.
+         *
+        */
+        bool isEdgeManifold() const;
+
+    private:
+        /**
+         * @brief Groups the key positions by key with a stable counting sort.
+         *
+         * @param keys Keys, all below numBuckets.
+         * @param numKeys Number of keys.
+         * @param numBuckets Number of distinct keys.
+         * @param offsets Start of every bucket in items, numBuckets+1 entries.
+         * @param items Positions of the keys, bucket by bucket.
+         */
+        static void bucketSort(const unsigned int* keys, int numKeys, int numBuckets,
+                               std::vector<int>& offsets, std::vector<unsigned int>& items);
+
+        int m_numVertices;
+        int m_numTriangles;
+
+        std::vector<int> m_vertexOffsets;
+        std::vector<unsigned int> m_vertexTriangles;
+
+        std::vector<unsigned int> m_edgeVertices;
+        std::vector<int> m_edgeOffsets;
+        std::vector<unsigned int> m_edgeHalfEdges;
+        std::vector<int> m_halfEdgeEdges;
+    };
+
+    inline int MeshAdjacency::getNumberOfVertices() const
+    { return m_numVertices; }
+    inline int MeshAdjacency::getNumberOfTriangles() const
+    { return m_numTriangles; }
+    inline int MeshAdjacency::getNumberOfEdges() const
+    { return static_cast<int>(m_edgeVertices.size() / 2); }
+    inline int MeshAdjacency::getVertexTriangleCount(unsigned int vertex) const
+    { return m_vertexOffsets[vertex+1] - m_vertexOffsets[vertex]; }
+    inline const unsigned int* MeshAdjacency::getVertexTriangles(unsigned int vertex) const
+    { return m_vertexTriangles.empty() ? 0 : &m_vertexTriangles[0] + m_vertexOffsets[vertex]; }
+    inline void MeshAdjacency::getEdgeVertices(int edge, unsigned int& v0, unsigned int& v1) const
+    { v0 = m_edgeVertices[edge*2]; v1 = m_edgeVertices[edge*2+1]; }
+    inline int MeshAdjacency::getEdgeHalfEdgeCount(int edge) const
+    { return m_edgeOffsets[edge+1] - m_edgeOffsets[edge]; }
+    inline const unsigned int* MeshAdjacency::getEdgeHalfEdges(int edge) const
+    { return &m_edgeHalfEdges[0] + m_edgeOffsets[edge]; }
+    inline int MeshAdjacency::getEdge(unsigned int halfEdge) const
+    { return m_halfEdgeEdges[halfEdge]; }
+}
+
+#endif  // _MESHADJACENCY_H_
@@ -34,12 +34,169 @@
 #include "A3DIncludes.h"
 #include "MeshIO.h"
 #include <fstream>
+#include <algorithm>
 #include "A3DUtils.h"
 #include "XmlParser.h"
+#include "Quantization.h"
+#include "IndexCodec.h"
+#include "VertexCodec.h"
+#include "TriangleStrips.h"
+#include <sstream>
 
 using namespace assembly3d;
 using namespace assembly3d::utils;
 
+static bool getAttributeType(const std::string& name, Mesh::AttributeType& type)
+{
+    if(name.compare("POSITION") == 0)
+        type = Mesh::POSITION;
+    else if(name.compare("NORMAL") == 0)
+        type = Mesh::NORMAL;
+    else if(name.compare("TEXCOORD") == 0)
+        type = Mesh::TEXCOORD;
+    else if(name.compare("TANGENT") == 0)
+        type = Mesh::TANGENT;
+    else if(name.compare("BITANGENT") == 0)
+        type = Mesh::BITANGENT;
+    else
+        return false;
+    return true;
+}
+
+// Ranges are written as space separated components.
+static bool parseRange(const std::string& text, int size, float* values)
+{
+    std::vector<std::string> tokens = StringUtils::tokenize(text, " ");
+    if((int)tokens.size() != size)
+        return false;
+    for(int c = 0; c < size; ++c)
+        values[c] = (float)atof(tokens[c].c_str());
+    return true;
+}
+
+static std::string formatRange(const float* values, int size)
+{
+    std::stringstream ss;
+    ss.precision(9);
+    for(int c = 0; c < size; ++c)
+        ss << (c > 0 ? " " : "") << values[c];
+    return ss.str();
+}
+
+// Reads an attribute block of any encoding into stride floats per vertex.
+static bool readEncodedAttribute(std::istream& fin, Quantization::Encoding encoding, int count, int size, int stride,
+                                 const float* minimum, const float* maximum, std::vector<float>& data)
+{
+    std::vector<unsigned char> block(Quantization::getBlockSize(encoding, size, count));
+    data.assign((size_t)count*stride, 0.0f);
+    if(count == 0)
+        return true;
+    if(block.empty())
+        return false;
+
+    fin.read((char *)(&block[0]), (std::streamsize)block.size());
+    if(fin.good() == false)
+        return false;
+    Quantization::decode(encoding, &block[0], count, size, stride, minimum, maximum, &data[0]);
+    return true;
+}
+
+// Reads an attribute block written by VertexCodec. Float attributes are
+// decoded straight into the mesh layout.
+static bool readCompressedAttribute(std::istream& fin, unsigned int compressedSize, Quantization::Encoding encoding,
+                                    int count, int size, int stride, const float* minimum, const float* maximum,
+                                    std::vector<float>& data)
+{
+    data.assign((size_t)count*stride, 0.0f);
+    if(size < 1 || size > 4 || size > stride)
+        return false;
+    if(count == 0)
+        return true;
+    if(compressedSize == 0)
+        return false;
+
+    std::vector<unsigned char> buffer(compressedSize);
+    fin.read((char *)(&buffer[0]), compressedSize);
+    if(fin.good() == false)
+        return false;
+
+    const int vertexSize = Quantization::getVertexSize(encoding, size);
+    if(encoding == Quantization::FLOAT)
+    {
+        // Missing components are 0, a missing w is 1.
+        for(int i = 0; i < count && stride > size; ++i)
+            data[(size_t)i*stride+stride-1] = 1.0f;
+        return VertexCodec::decode(&buffer[0], buffer.size(), (unsigned char*)&data[0], count, vertexSize,
+                                   stride*sizeof(float));
+    }
+
+    std::vector<unsigned char> block((size_t)count*vertexSize);
+    if(VertexCodec::decode(&buffer[0], buffer.size(), &block[0], count, vertexSize, vertexSize) == false)
+        return false;
+    Quantization::decode(encoding, &block[0], count, size, stride, minimum, maximum, &data[0]);
+    return true;
+}
+
+// Separator between triangle strips, 0 for index types without strips.
+static unsigned int getRestartIndex(const std::string& indexType)
+{
+    if(indexType.compare("UNSIGNED_INT") == 0)
+        return 0xffffffffu;
+    if(indexType.compare("UNSIGNED_SHORT") == 0)
+        return 0xffffu;
+    if(indexType.compare("UNSIGNED_BYTE") == 0)
+        return 0xffu;
+    return 0;
+}
+
+// Chooses the base vertex of every group and which strip groups are stored
+// as strips. Narrow index types keep the restart index free for strips.
+// Returns false if a group does not fit the index type.
+static bool planGroups(Mesh* mesh, const std::string& indexType, std::vector<unsigned int>& groupBases,
+                       std::vector<char>& groupStrips)
+{
+    const int numGroups = mesh->getNumberOfGroups();
+    groupBases.assign(numGroups, 0);
+    groupStrips.assign(numGroups, 0);
+
+    const unsigned int maxIndex = getRestartIndex(indexType);
+    if(maxIndex == 0)
+        return true;
+
+    for(int i = 0; i < numGroups; ++i)
+    {
+        const Mesh::Group& g = mesh->getGroup(i);
+        if(g.triangleCount <= 0)
+            continue;
+
+        const unsigned int* first = mesh->getIndicesPointer() + g.startIndex;
+        unsigned int lowest = first[0];
+        unsigned int highest = first[0];
+        for(int k = 1; k < g.triangleCount*3; ++k)
+        {
+            lowest = std::min(lowest, first[k]);
+            highest = std::max(highest, first[k]);
+        }
+
+        bool strip = g.primitiveType == Mesh::TRIANGLE_STRIP;
+        if(strip && highest - lowest >= maxIndex)
+            strip = false;
+        const unsigned int limit = strip ? maxIndex - 1 : maxIndex;
+        if(highest - lowest > limit)
+            return false;
+
+        groupBases[i] = highest > limit ? lowest : 0;
+        groupStrips[i] = strip ? 1 : 0;
+    }
+    return true;
+}
+
+static bool isCompressed(const Mesh::MeshFormat& format, const std::string& name)
+{
+    return std::find(format.compressedAttributes.begin(), format.compressedAttributes.end(), name) !=
+           format.compressedAttributes.end();
+}
+
 MeshIO::MeshIO()
 {
 }
@@ -56,16 +213,26 @@ bool MeshIO::load(Mesh* mesh, const char* file, const char* binaryFile)
     int groupIndex = 0;
     
     int numTriangles = 0;
+    // Stored indices per group, fewer than 3 per triangle for strips.
+    std::vector<int> groupIndexCounts;
+    int numStoredIndices = 0;
+    std::vector<unsigned int> groupBases;
+    bool hasStoredIndices = false;
 
     mesh->destroy();
     
     mesh->setMeshPath(file);
     Mesh::MeshFormat& format = mesh->getMeshFormat();
+    // Ranges of normalized attributes, [-1, 1] if not given.
+    std::vector<float> ranges;
+    std::vector<char> hasRange;
     
     XmlParser xml;
     if(xml.loadFile(file) == false)
         return false;
     
+    // Errors leave the loops, the tags are popped before returning.
+    bool valid = true;
     xml.pushTag("Mesh");
     {
         numVertices = xml.getAttribute("Vertices", "count", 0);
@@ -83,9 +250,24 @@ bool MeshIO::load(Mesh* mesh, const char* file, const char* binaryFile)
                 format.attributeName.push_back(xml.getAttribute("Attribute", "name", "", i));
                 format.attributeSize.push_back(xml.getAttribute("Attribute", "size", 0, i));
                 format.attributeType.push_back(xml.getAttribute("Attribute", "type", "FLOAT", i));
+
+                std::string compression = xml.getAttribute("Attribute", "compression", "", i);
+                if(compression.compare("ENCODED") == 0)
+                    format.compressedAttributes.push_back(format.attributeName[i]);
+                else if(compression.empty() == false)
+                {
+                    valid = false;
+                    break;
+                }
+
+                int size = std::max(0, std::min(format.attributeSize[i], 4));
+                ranges.resize((size_t)(i+1)*8, 0.0f);
+                hasRange.push_back(parseRange(xml.getAttribute("Attribute", "min", "", i), size, &ranges[i*8]) &&
+                                   parseRange(xml.getAttribute("Attribute", "max", "", i), size, &ranges[i*8+4]));
             }
         }
         xml.popTag();
+        mesh->updateStrides();
         
         xml.pushTag("Triangles");
         {
@@ -93,6 +275,17 @@ bool MeshIO::load(Mesh* mesh, const char* file, const char* binaryFile)
             {
                 Mesh::Group g;
 
+                std::string primitive = xml.getAttribute("Group", "primitive", "TRIANGLES", i);
+                if(primitive.compare("TRIANGLE_STRIP") == 0)
+                    g.primitiveType = Mesh::TRIANGLE_STRIP;
+                else if(primitive.compare("TRIANGLES") == 0)
+                    g.primitiveType = Mesh::TRIANGLES;
+                else
+                {
+                    valid = false;
+                    break;
+                }
+
                 std::string tmpGroupName = xml.getAttribute("Group", "name", "", i).c_str();
                 g.name = new char[tmpGroupName.length()+1];
                 g.name[tmpGroupName.length()] = 0;
@@ -103,6 +296,26 @@ bool MeshIO::load(Mesh* mesh, const char* file, const char* binaryFile)
                 g.startIndex = numIndices;
                 numIndices += g.triangleCount * 3;
                 ++groupIndex;
+
+                if(g.primitiveType == Mesh::TRIANGLE_STRIP)
+                {
+                    groupIndexCounts.push_back(std::max(0, xml.getAttribute("Group", "indices", 0, i)));
+                    hasStoredIndices = true;
+                }
+                else
+                {
+                    groupIndexCounts.push_back(g.triangleCount * 3);
+                }
+                numStoredIndices += groupIndexCounts.back();
+
+                const int baseVertex = xml.getAttribute("Group", "baseVertex", 0, i);
+                if(baseVertex < 0)
+                {
+                    valid = false;
+                    break;
+                }
+                groupBases.push_back(baseVertex);
+                hasStoredIndices = hasStoredIndices || baseVertex > 0;
                 
                 numTriangles += g.triangleCount;
                 
@@ -111,217 +324,127 @@ bool MeshIO::load(Mesh* mesh, const char* file, const char* binaryFile)
             mesh->setNumTriangles(numTriangles);
         }
         xml.popTag();
-        
-//        loadBinaryFile = !(xml.tagExists("Data"));
-        
-        // -------------------------------------------------
-        // Load binary file
-        // -------------------------------------------------
-        format.isBinary = true;
-
-        std::ifstream fin(binaryFile, std::ios::binary);
+    }
+    xml.popTag();
 
-        fin.seekg(0);
+    if(valid == false)
+        return false;
 
-        std::vector<float> verts;
-        std::vector<float> texCoords;
-        std::vector<float> normals;
-        std::vector<float> tangents;
-        std::vector<float> bitangents;
+//    loadBinaryFile = !(xml.tagExists("Data"));
 
-        bool loadTexture = false;
-        bool loadNormal = false;
-        bool loadTangent = false;
-        bool loadBitangent = false;
+    // -------------------------------------------------
+    // Load binary file
+    // -------------------------------------------------
+    {
+        format.isBinary = true;
 
-        int index = 0;
-        int startLoop = 0;
-        int endLoop = 0;
-        int idx = -1;
-        int aSize = format.attributeCount;
-        idx = mesh->getAttributeIndexWithName("POSITION");
+        std::ifstream fin(binaryFile, std::ios::binary);
 
-        if(idx > -1 && idx < aSize)
+        // Attribute blocks follow each other in declaration order, the
+        // indices come last.
+        std::streamoff offset = 0;
+        for(int i = 0; i < format.attributeCount; ++i)
         {
-            startLoop = numVertices*idx;
-            endLoop = numVertices *(idx+1);
+            Quantization::Encoding encoding = Quantization::getEncoding(format.attributeType[i]);
+            if(encoding == Quantization::UNKNOWN)
+                return false;
+            std::streamoff blockSize = Quantization::getBlockSize(encoding, format.attributeSize[i], numVertices);
 
-            for(int i = startLoop; i < endLoop; ++i)
+            // Compressed blocks start with their size and are padded to 4 bytes.
+            const bool compressed = isCompressed(format, format.attributeName[i]) && numVertices > 0;
+            unsigned int compressedSize = 0;
+            if(compressed)
             {
-				for(int j=0; j<format.attributeSize[idx]; ++j)
-				{
-					float x = 0.0f;
-					fin.read((char *)(&x), sizeof(x));
-					verts.push_back(x);
-					
-				}
-				for(int j=format.attributeSize[idx]; j<3; ++j)
-				{
-					verts.push_back(0.0f);           	
-				}
-				if(format.attributeSize[idx] < 4)
-				{
-					verts.push_back(1.0f);
-				}       
+                fin.seekg(offset);
+                fin.read((char *)(&compressedSize), sizeof(compressedSize));
+                // At most a header byte and 16 data bytes per 16 values.
+                const int vertexSize = Quantization::getVertexSize(encoding, format.attributeSize[i]);
+                if(fin.good() == false ||
+                   compressedSize > 1 + (std::streamoff)vertexSize*((numVertices + 15)/16)*17)
+                    return false;
+                blockSize = sizeof(unsigned int) + ((compressedSize + 3) & ~3u);
             }
-        }
-        idx = mesh->getAttributeIndexWithName("NORMAL");
-        if(idx > -1 && idx < aSize)
-        {
-            loadNormal = true;
-            index = 0;
-            startLoop = numVertices*idx;
-            endLoop = numVertices*(idx+1);
-            for(int i = startLoop; i < endLoop; ++i)
-            {
-				
-				for(int j=0; j<format.attributeSize[idx]; ++j)
-				{
-					float n = 0.0f;
-					fin.read((char *)(&n), sizeof(n));
-					normals.push_back(n);
-					
-				}
-				for(int j=format.attributeSize[idx]; j<3; ++j)
-				{
-					normals.push_back(0.0f);           	
-				}
-				if(format.attributeSize[idx] < 4)
-				{
-					normals.push_back(1.0f);
-				}       
-				
-            }
-        }
-        idx = mesh->getAttributeIndexWithName("TEXCOORD");
-        if(idx > -1 && idx < aSize)
-        {
-            loadTexture = true;
-            index = 0;
-            startLoop = numVertices*idx;
-            endLoop = numVertices*(idx+1);
-            for(int i = startLoop; i < endLoop; ++i)
+
+            Mesh::AttributeType type;
+            if(getAttributeType(format.attributeName[i], type) == false)
             {
-				
-				for(int j=0; j<format.attributeSize[idx]; ++j)
-				{
-					float t = 0.0f;
-					fin.read((char *)(&t), sizeof(t));
-					texCoords.push_back(t);
-					
-				}
-				for(int j=format.attributeSize[idx]; j<3; ++j)
-				{
-					texCoords.push_back(0.0f);           	
-				}
-				if(format.attributeSize[idx] < 4)
-				{
-					texCoords.push_back(1.0f);
-				}       
-				
+                offset += blockSize;
+                continue;
             }
-        }
-        idx = mesh->getAttributeIndexWithName("TANGENT");
-        if(idx > -1 && idx < aSize)
-        {
-            loadTangent = true;
-            index = 0;
-            startLoop = numVertices*idx;
-            endLoop = numVertices*(idx+1);
-            for(int i = startLoop; i < endLoop; ++i)
+
+            std::vector<float> data;
+            fin.seekg(offset);
+            if(compressed)
             {
-				for(int j=0; j<format.attributeSize[idx]; ++j)
-				{
-					float tan = 0.0f;
-					fin.read((char *)(&tan), sizeof(tan));
-					tangents.push_back(tan);
-					
-				}
-				for(int j=format.attributeSize[idx]; j<3; ++j)
-				{
-					tangents.push_back(0.0f);           	
-				}
-				if(format.attributeSize[idx] < 4)
-				{
-					tangents.push_back(1.0f);
-				}       
-				
+                fin.seekg(offset + (std::streamoff)sizeof(compressedSize));
+                if(readCompressedAttribute(fin, compressedSize, encoding, numVertices, format.attributeSize[i],
+                                           mesh->getStride(type), hasRange[i] ? &ranges[i*8] : 0,
+                                           hasRange[i] ? &ranges[i*8+4] : 0, data) == false)
+                    return false;
             }
-        }
-        idx = mesh->getAttributeIndexWithName("BITANGENT");
-        if(idx > -1 && idx < aSize)
-        {
-            loadBitangent = true;
-            index = 0;
-            startLoop = numVertices*idx;
-            endLoop = numVertices*(idx+1);
-            for(int i = startLoop; i < endLoop; ++i)
+            else if(encoding == Quantization::FLOAT)
             {
-				for(int j=0; j<format.attributeSize[idx]; ++j)
-				{
-					float btan = 0.0f;
-					fin.read((char *)(&btan), sizeof(btan));
-					bitangents.push_back(btan);
-					
-				}
-				for(int j=format.attributeSize[idx]; j<3; ++j)
-				{
-					bitangents.push_back(0.0f);           	
-				}
-				if(format.attributeSize[idx] < 4)
-				{
-					bitangents.push_back(1.0f);
-				}       
-				
+                if(readAttribute(fin, numVertices, format.attributeSize[i], mesh->getStride(type), data) == false)
+                    return false;
             }
-        }
-        if(format.indexType.compare("UNSIGNED_INT") == 0)
-        {
-            for(int i = 0; i < numIndices; ++i)
+            else if(readEncodedAttribute(fin, encoding, numVertices, format.attributeSize[i], mesh->getStride(type),
+                                         hasRange[i] ? &ranges[i*8] : 0, hasRange[i] ? &ranges[i*8+4] : 0,
+                                         data) == false)
             {
-                unsigned int index = 0;
-                fin.read((char *)(&index), sizeof(index));
-                mesh->addIndex(index);
+                return false;
             }
+            mesh->swapAttribute(type, data);
+
+            offset += blockSize;
         }
-        else if(format.indexType.compare("UNSIGNED_SHORT") == 0)
+
+        std::vector<unsigned int> indices;
+        fin.seekg(offset);
+        if(hasStoredIndices)
         {
-            for(int i = 0; i < numIndices; ++i)
+            const unsigned int restartIndex = getRestartIndex(format.indexType);
+            std::vector<unsigned int> stored;
+            if(restartIndex == 0 ||
+               readIndices(fin, numStoredIndices, format.indexType, stored, (unsigned int)numVertices) == false)
+                return false;
+
+            // Unpack the strips and add the base vertices, every group has to
+            // give its triangle count.
+            indices.reserve(numIndices);
+            int first = 0;
+            for(int i = 0; i < numGroups; ++i)
             {
-                unsigned short index = 0;
-                fin.read((char *)(&index), sizeof(index));
-                mesh->addIndex((unsigned int)index);
+                const Mesh::Group& g = mesh->getGroup(i);
+                const int count = groupIndexCounts[i];
+                const size_t begin = indices.size();
+                if(g.primitiveType == Mesh::TRIANGLE_STRIP)
+                {
+                    if(count > 0 && TriangleStrips::unstripify(&stored[first], count, restartIndex, indices) != g.triangleCount)
+                        return false;
+                }
+                else
+                {
+                    indices.insert(indices.end(), stored.begin() + first, stored.begin() + first + count);
+                }
+                for(size_t k = begin; k < indices.size(); ++k)
+                    indices[k] += groupBases[i];
+                first += count;
             }
+            if((int)indices.size() != numIndices)
+                return false;
         }
-        else if(format.indexType.compare("UNSIGNED_BYTE") == 0)
+        else if(readIndices(fin, numIndices, format.indexType, indices, (unsigned int)numVertices) == false)
         {
-            for(int i = 0; i < numIndices; ++i)
-            {
-                unsigned char index = 0;
-                fin.read((char *)(&index), sizeof(index));
-                mesh->addIndex((unsigned int)index);
-            }
+            return false;
         }
 
-        mesh->setPositions(verts);
-        if(loadNormal)
-        {
-            mesh->setNormals(normals);
-        }
-        if(loadTexture)
-        {
-            mesh->setTexCoords(texCoords);
-        }
-        if(loadTangent)
-        {
-            mesh->setTangents(tangents);
-        }
-        if(loadBitangent)
+        for(size_t k = 0; k < indices.size(); ++k)
         {
-            mesh->setBitangents(bitangents);
+            if(indices[k] >= (unsigned int)numVertices)
+                return false;
         }
+        mesh->swapIndices(indices);
     }
-    xml.popTag();
     
     mesh->calculateBounds();
     mesh->hasPositions(mesh->getAttributeIndexWithName("POSITION") != -1 ? true : false);
@@ -333,6 +456,126 @@ bool MeshIO::load(Mesh* mesh, const char* file, const char* binaryFile)
     return true;
 }
 
+bool MeshIO::loadModifier(Modifier* modifier, const char* file, const char* binaryFile)
+{
+    modifier->destroy();
+    modifier->setModifierPath(file);
+
+    XmlParser xml;
+    if(xml.loadFile(file) == false)
+        return false;
+
+    std::vector<int> counts;
+    std::vector<std::string> indexTypes;
+    // Encoding and range of every attribute, in file order.
+    std::vector<Quantization::Encoding> encodings;
+    std::vector<float> ranges;
+    std::vector<char> hasRange;
+    bool valid = true;
+
+    xml.pushTag("Modifier");
+    {
+        int numGroups = xml.getNumTags("Group");
+        for(int i = 0; i < numGroups && valid; ++i)
+        {
+            Modifier::Group g;
+            g.name = xml.getAttribute("Group", "name", "", i);
+            g.mode = Modifier::DELTA;
+            if(xml.getAttribute("Group", "mode", "DELTA", i).compare("OVERRIDE") == 0)
+                g.mode = Modifier::OVERRIDE;
+
+            counts.push_back(xml.getAttribute("Group", "count", 0, i));
+            indexTypes.push_back(xml.getAttribute("Group", "type", "UNSIGNED_INT", i));
+            // Vertex lists are not triangles, the index codec does not apply.
+            if(indexTypes.back().compare("ENCODED") == 0)
+                valid = false;
+
+            xml.pushTag("Group", i);
+            {
+                int numAttributes = xml.getNumTags("Attribute");
+                g.attributes.resize(numAttributes);
+                for(int j = 0; j < numAttributes; ++j)
+                {
+                    g.attributes[j].name = xml.getAttribute("Attribute", "name", "", j);
+                    g.attributes[j].size = xml.getAttribute("Attribute", "size", 0, j);
+                    encodings.push_back(Quantization::getEncoding(xml.getAttribute("Attribute", "type", "FLOAT", j)));
+                    if(g.attributes[j].size < 1 || g.attributes[j].size > 4 || encodings.back() == Quantization::UNKNOWN)
+                    {
+                        valid = false;
+                        break;
+                    }
+                    size_t r = ranges.size();
+                    ranges.resize(r + 8, 0.0f);
+                    hasRange.push_back(parseRange(xml.getAttribute("Attribute", "min", "", j), g.attributes[j].size, &ranges[r]) &&
+                                       parseRange(xml.getAttribute("Attribute", "max", "", j), g.attributes[j].size, &ranges[r+4]));
+                }
+            }
+            xml.popTag();
+
+            if(valid)
+                modifier->addGroup(g);
+        }
+    }
+    xml.popTag();
+
+    if(valid == false)
+        return false;
+
+    // -------------------------------------------------
+    // Load binary file
+    // -------------------------------------------------
+    std::ifstream fin(binaryFile, std::ios::binary);
+    if(fin.is_open() == false)
+        return false;
+
+    std::vector<float> values;
+    size_t attributeIndex = 0;
+    for(int i = 0; i < modifier->getNumberOfGroups(); ++i)
+    {
+        Modifier::Group& g = modifier->getGroup(i);
+        const int count = counts[i];
+
+        // The file interleaves the components, the modifier keeps one
+        // array per component.
+        for(size_t j = 0; j < g.attributes.size(); ++j)
+        {
+            Modifier::Target& target = g.attributes[j];
+            Quantization::Encoding encoding = encodings[attributeIndex];
+            const float* minimum = hasRange[attributeIndex] ? &ranges[attributeIndex*8] : 0;
+            const float* maximum = hasRange[attributeIndex] ? &ranges[attributeIndex*8+4] : 0;
+            ++attributeIndex;
+            if(encoding == Quantization::FLOAT)
+            {
+                values.resize((size_t)count*target.size);
+                if(count > 0)
+                    fin.read((char *)(&values[0]), (std::streamsize)count*target.size*sizeof(float));
+                if(fin.good() == false)
+                    return false;
+            }
+            else if(readEncodedAttribute(fin, encoding, count, target.size, target.size, minimum, maximum,
+                                         values) == false)
+            {
+                return false;
+            }
+
+            for(int c = 0; c < target.size; ++c)
+            {
+                std::vector<float>& component = target.components[c];
+                component.resize(count);
+                const float* src = values.empty() ? 0 : &values[c];
+                for(int k = 0; k < count; ++k, src += target.size)
+                    component[k] = *src;
+            }
+        }
+
+        // The vertices are checked against the mesh by Modifier::isValidFor().
+        if(readIndices(fin, count, indexTypes[i], g.vertices, 0) == false)
+            return false;
+    }
+
+    return true;
+}
+
 void MeshIO::dumpTxt(Mesh* mesh, const char* outFilePath)
 {
     // -------------------------------------------------------------------------------------------
@@ -494,6 +737,65 @@ void MeshIO::dumpTxt(Mesh* mesh, const char* outFilePath)
 
 void MeshIO::saveFile(Mesh* mesh, const char* outFilePath, const char* binaryFilePath)
 {
+    const Mesh::MeshFormat& format = mesh->getMeshFormat();
+    const int numVertices = mesh->getNumberOfVertices();
+
+    // Groups of narrow index types are stored relative to their lowest
+    // vertex where needed, see PartitionTool. If one does not fit even so,
+    // the indices are stored as UNSIGNED_INT rather than cut off.
+    const int numGroups = mesh->getNumberOfGroups();
+    std::string indexType = format.indexType;
+    std::vector<unsigned int> groupBases;
+    std::vector<char> groupStrips;
+    if(planGroups(mesh, indexType, groupBases, groupStrips) == false)
+    {
+        indexType = "UNSIGNED_INT";
+        planGroups(mesh, indexType, groupBases, groupStrips);
+    }
+
+    std::vector<unsigned int> storedIndices;
+    std::vector<int> groupIndexCounts(numGroups, 0);
+    bool hasStoredIndices = false;
+    for(int i = 0; i < numGroups; ++i)
+        hasStoredIndices = hasStoredIndices || groupStrips[i] || groupBases[i] > 0;
+    if(hasStoredIndices)
+    {
+        const unsigned int restartIndex = getRestartIndex(indexType);
+        std::vector<unsigned int> strip;
+        for(int i = 0; i < numGroups; ++i)
+        {
+            const Mesh::Group& g = mesh->getGroup(i);
+            if(g.triangleCount <= 0)
+                continue;
+            const unsigned int* first = mesh->getIndicesPointer() + g.startIndex;
+            const size_t begin = storedIndices.size();
+            storedIndices.insert(storedIndices.end(), first, first + g.triangleCount*3);
+            for(size_t k = begin; k < storedIndices.size(); ++k)
+                storedIndices[k] -= groupBases[i];
+            if(groupStrips[i])
+            {
+                TriangleStrips::stripify(&storedIndices[begin], g.triangleCount, restartIndex, strip);
+                storedIndices.resize(begin);
+                storedIndices.insert(storedIndices.end(), strip.begin(), strip.end());
+            }
+            groupIndexCounts[i] = static_cast<int>(storedIndices.size() - begin);
+        }
+    }
+
+    // Normalized attributes are mapped to their current range.
+    std::vector<float> ranges((size_t)format.attributeCount*8, 0.0f);
+    for(int i = 0; i < format.attributeCount; ++i)
+    {
+        Mesh::AttributeType type;
+        if(Quantization::usesRange(Quantization::getEncoding(format.attributeType[i])) &&
+           getAttributeType(format.attributeName[i], type))
+        {
+            Mesh::Attribute attribute = mesh->getAttribute(type);
+            Quantization::computeRange(attribute.data, numVertices, std::min(format.attributeSize[i], 4),
+                                       attribute.stride, &ranges[i*8], &ranges[i*8+4]);
+        }
+    }
+
     XmlParser xml;
     xml.addXmlDeclaration();
     // -------------------------------------------------------------------------------------------
@@ -530,6 +832,16 @@ void MeshIO::saveFile(Mesh* mesh, const char* outFilePath, const char* binaryFil
                 xml.addAttribute("Attribute", "name", mesh->getMeshFormat().attributeName[attribIndices[attrIndex]].c_str(), attrIndex);
                 xml.addAttribute("Attribute", "size", mesh->getMeshFormat().attributeSize[attribIndices[attrIndex]], attrIndex);
                 xml.addAttribute("Attribute", "type", mesh->getMeshFormat().attributeType[attribIndices[attrIndex]].c_str(), attrIndex);
+
+                int i = attribIndices[attrIndex];
+                if(Quantization::usesRange(Quantization::getEncoding(format.attributeType[i])))
+                {
+                    int size = std::min(format.attributeSize[i], 4);
+                    xml.addAttribute("Attribute", "min", formatRange(&ranges[i*8], size), attrIndex);
+                    xml.addAttribute("Attribute", "max", formatRange(&ranges[i*8+4], size), attrIndex);
+                }
+                if(isCompressed(format, format.attributeName[i]))
+                    xml.addAttribute("Attribute", "compression", "ENCODED", attrIndex);
             }
         }
         xml.popTag();
@@ -539,7 +851,7 @@ void MeshIO::saveFile(Mesh* mesh, const char* outFilePath, const char* binaryFil
         // -------------------------------------------------------------------------------------------
         xml.addTag("Triangles");
         xml.addAttribute("Triangles","groups", (int)mesh->getNumberOfGroups(), 0);
-        xml.addAttribute("Triangles", "type", mesh->getMeshFormat().indexType.c_str(), 0);
+        xml.addAttribute("Triangles", "type", indexType.c_str(), 0);
         
         xml.pushTag("Triangles");
         {
@@ -557,6 +869,13 @@ void MeshIO::saveFile(Mesh* mesh, const char* outFilePath, const char* binaryFil
 
                 xml.addAttribute("Group", "name", g.name, groupIndex);
                 xml.addAttribute("Group", "count", g.triangleCount, groupIndex);
+                if(groupStrips[groupIndex])
+                {
+                    xml.addAttribute("Group", "primitive", "TRIANGLE_STRIP", groupIndex);
+                    xml.addAttribute("Group", "indices", groupIndexCounts[groupIndex], groupIndex);
+                }
+                if(groupBases[groupIndex] > 0)
+                    xml.addAttribute("Group", "baseVertex", (int)groupBases[groupIndex], groupIndex);
             }
         }
     }
@@ -569,120 +888,122 @@ void MeshIO::saveFile(Mesh* mesh, const char* outFilePath, const char* binaryFil
     // -------------------------------------------------------------------------------------------
     std::ofstream fout(binaryFilePath, std::ios::binary);
     
-    int idx = -1;
+    const char* attributeNames[5] = {"POSITION", "NORMAL", "TEXCOORD", "TANGENT", "BITANGENT"};
+    const Mesh::AttributeType attributeTypes[5] = {Mesh::POSITION, Mesh::NORMAL, Mesh::TEXCOORD,
+                                                   Mesh::TANGENT, Mesh::BITANGENT};
     int aSize = mesh->getMeshFormat().attributeCount;
-    idx = mesh->getAttributeIndexWithName("POSITION");
-    if(idx > -1 && idx < aSize)
+    std::vector<unsigned char> block;
+    for(int i = 0; i < 5; ++i)
     {
-        for(int vertexIndex = 0; vertexIndex < mesh->getNumberOfVertices(); ++vertexIndex)
+        int idx = mesh->getAttributeIndexWithName(attributeNames[i]);
+        if(idx > -1 && idx < aSize && numVertices > 0)
         {
-            const float* position = mesh->getPosition(vertexIndex);
-            
-            for(int vertSizePosIndex = 0; vertSizePosIndex < mesh->getMeshFormat().attributeSize[idx]; ++vertSizePosIndex)
-            {
-                fout.write((char *)(&position[vertSizePosIndex]), sizeof(position[vertSizePosIndex]));
-            }   
-        }
-    }
-    idx = mesh->getAttributeIndexWithName("NORMAL");
-    if(idx > -1 && idx < aSize)
-    {
-        for(int vertexIndex = 0; vertexIndex < mesh->getNumberOfVertices(); ++vertexIndex)
-        {
-            const float* normal = mesh->getNormal(vertexIndex);
-            
-            for(int vertSizeNormalIndex = 0; vertSizeNormalIndex < mesh->getMeshFormat().attributeSize[idx]; ++vertSizeNormalIndex)
+            Mesh::Attribute attribute = mesh->getAttribute(attributeTypes[i]);
+            Quantization::Encoding encoding = Quantization::getEncoding(format.attributeType[idx]);
+            bool compressed = isCompressed(format, attributeNames[i]) && encoding != Quantization::UNKNOWN;
+            if((encoding == Quantization::FLOAT && compressed == false) || encoding == Quantization::UNKNOWN)
             {
-                fout.write((char *)(&normal[vertSizeNormalIndex]), sizeof(normal[vertSizeNormalIndex]));
+                writeAttribute(fout, attribute.data, numVertices, format.attributeSize[idx], attribute.stride);
+                continue;
             }
-        }
-    }
-    idx = mesh->getAttributeIndexWithName("TEXCOORD");
-    if(idx > -1 && idx < aSize)
-    {
-   
-        for(int vertexIndex = 0; vertexIndex < mesh->getNumberOfVertices(); ++vertexIndex)
-        {
-            const float* texCoord = mesh->getTexCoord(vertexIndex);
-            
-            for(int vertSizeTexIndex = 0; vertSizeTexIndex < mesh->getMeshFormat().attributeSize[idx]; ++vertSizeTexIndex)
+
+            bool ranged = Quantization::usesRange(encoding);
+            Quantization::encode(encoding, attribute.data, numVertices, std::min(format.attributeSize[idx], 4),
+                                 attribute.stride, ranged ? &ranges[idx*8] : 0, ranged ? &ranges[idx*8+4] : 0, block);
+            if(compressed)
             {
-                fout.write((char *)(&texCoord[vertSizeTexIndex]), sizeof(texCoord[vertSizeTexIndex]));
+                const int vertexSize = Quantization::getVertexSize(encoding, std::min(format.attributeSize[idx], 4));
+                std::vector<unsigned char> buffer;
+                VertexCodec::encode(&block[0], numVertices, vertexSize, buffer);
+                buffer.resize((buffer.size() + 3) & ~(size_t)3, 0);
+                fout.write((const char *)(&buffer[0]), (std::streamsize)buffer.size());
             }
+            else if(block.empty() == false)
+                fout.write((const char *)(&block[0]), (std::streamsize)block.size());
         }
     }
-    idx = mesh->getAttributeIndexWithName("TANGENT");
-    if(idx > -1 && idx < aSize)
+
+    int numIndices = mesh->getNumberOfTriangles()*3;
+    if(hasStoredIndices)
     {
-   
-        for(int vertexIndex = 0; vertexIndex < mesh->getNumberOfVertices(); ++vertexIndex)
-        {
-            const float* tangent = mesh->getTangent(vertexIndex);
-            
-            for(int vertSizeTexIndex = 0; vertSizeTexIndex < mesh->getMeshFormat().attributeSize[idx]; ++vertSizeTexIndex)
-            {
-                fout.write((char *)(&tangent[vertSizeTexIndex]), sizeof(tangent[vertSizeTexIndex]));
-            }
-        }
+        if(storedIndices.empty() == false)
+            writeIndices(fout, &storedIndices[0], static_cast<int>(storedIndices.size()), indexType);
     }
-    idx = mesh->getAttributeIndexWithName("BITANGENT");
-    if(idx > -1 && idx < aSize)
+    else if(numIndices > 0)
     {
-   
-        for(int vertexIndex = 0; vertexIndex < mesh->getNumberOfVertices(); ++vertexIndex)
-        {
-            const float* bitangent = mesh->getBitangent(vertexIndex);
-            
-            for(int vertSizeTexIndex = 0; vertSizeTexIndex < mesh->getMeshFormat().attributeSize[idx]; ++vertSizeTexIndex)
-            {
-                fout.write((char *)(&bitangent[vertSizeTexIndex]), sizeof(bitangent[vertSizeTexIndex]));
-            }
-        }
+        writeIndices(fout, mesh->getIndicesPointer(), numIndices, indexType);
     }
-    fout.flush();
     
-    if(mesh->getMeshFormat().indexType.compare("UNSIGNED_INT") == 0)
+    fout.flush();
+    fout.close();
+}
+
+void MeshIO::saveMeshlets(const Meshlets* meshlets, const char* outFilePath, const char* binaryFilePath)
+{
+    XmlParser xml;
+    xml.addXmlDeclaration();
+    // -------------------------------------------------------------------------------------------
+    // Root: Meshlets
+    // -------------------------------------------------------------------------------------------
+    xml.addTag("Meshlets");
+    xml.addAttribute("Meshlets", "xmlns", "http://xml.qu.tu-berlin.de/assembly/meshlets", 0);
+    xml.addAttribute("Meshlets", "xmlns:xsi", "http://www.w3.org/2001/XMLSchema-instance", 0);
+    xml.addAttribute("Meshlets", "xsi:schemaLocation", "http://xml.qu.tu-berlin.de/assembly/meshlets meshlets.xsd", 0);
+    xml.addAttribute("Meshlets", "maxVertices", meshlets->getMaxVertices(), 0);
+    xml.addAttribute("Meshlets", "maxTriangles", meshlets->getMaxTriangles(), 0);
+    xml.addAttribute("Meshlets", "groups", meshlets->getNumberOfGroups(), 0);
+    xml.pushTag("Meshlets");
     {
-        for(int triangleIndex = 0; triangleIndex < mesh->getNumberOfTriangles(); ++triangleIndex)
+        for(int groupIndex = 0; groupIndex < meshlets->getNumberOfGroups(); ++groupIndex)
         {
-            const unsigned int* pTriangle = mesh->getTriangle(triangleIndex);
-            unsigned int index0 = pTriangle[0];
-            unsigned int index1 = pTriangle[1];
-            unsigned int index2 = pTriangle[2];
-            fout.write((char* )(&index0), sizeof(index0));
-            fout.write((char* )(&index1), sizeof(index1));
-            fout.write((char* )(&index2), sizeof(index2));
+            // -------------------------------------------------------------------------------------------
+            // Group
+            // -------------------------------------------------------------------------------------------
+            xml.addTag("Group", false);
+
+            const Meshlets::Group& g = meshlets->getGroup(groupIndex);
+
+            xml.addAttribute("Group", "name", g.name, groupIndex);
+            xml.addAttribute("Group", "meshlets", (int)g.meshlets.size(), groupIndex);
+            xml.addAttribute("Group", "vertices", (int)g.vertices.size(), groupIndex);
+            xml.addAttribute("Group", "triangles", (int)g.triangles.size()/3, groupIndex);
         }
-      
     }
-    else if (mesh->getMeshFormat().indexType.compare("UNSIGNED_SHORT")==0)
+    xml.popTag();
+
+    xml.saveFile(outFilePath);
+
+    // -------------------------------------------------------------------------------------------
+    // Data
+    // -------------------------------------------------------------------------------------------
+    std::ofstream fout(binaryFilePath, std::ios::binary);
+
+    for(int groupIndex = 0; groupIndex < meshlets->getNumberOfGroups(); ++groupIndex)
     {
-        for(int triangleIndex = 0; triangleIndex < mesh->getNumberOfTriangles(); ++triangleIndex)
+        const Meshlets::Group& g = meshlets->getGroup(groupIndex);
+        for(size_t i = 0; i < g.meshlets.size(); ++i)
         {
-            const unsigned int* pTriangle = mesh->getTriangle(triangleIndex);
-            unsigned short index0 = (unsigned short)pTriangle[0];
-            unsigned short index1 = (unsigned short)pTriangle[1];
-            unsigned short index2 = (unsigned short)pTriangle[2];
-            fout.write((char* )(&index0), sizeof(index0));
-            fout.write((char* )(&index1), sizeof(index1));
-            fout.write((char* )(&index2), sizeof(index2));
+            const Meshlets::Meshlet& m = g.meshlets[i];
+            unsigned int values[4] = {m.vertexOffset, m.vertexCount, m.triangleOffset, m.triangleCount};
+            fout.write((const char *)values, sizeof(values));
         }
-       
-    }
-    else if (mesh->getMeshFormat().indexType.compare("UNSIGNED_BYTE")==0)
-    {
-        for(int triangleIndex = 0; triangleIndex < mesh->getNumberOfTriangles(); ++triangleIndex)
+        for(size_t i = 0; i < g.bounds.size(); ++i)
         {
-            const unsigned int* pTriangle = mesh->getTriangle(triangleIndex);
-            unsigned char index0 = (unsigned char)pTriangle[0];
-            unsigned char index1 = (unsigned char)pTriangle[1];
-            unsigned char index2 = (unsigned char)pTriangle[2];
-            fout.write((char* )(&index0), sizeof(index0));
-            fout.write((char* )(&index1), sizeof(index1));
-            fout.write((char* )(&index2), sizeof(index2));
+            const Meshlets::Bounds& b = g.bounds[i];
+            float values[11] = {b.center[0], b.center[1], b.center[2], b.radius,
+                                b.coneApex[0], b.coneApex[1], b.coneApex[2],
+                                b.coneAxis[0], b.coneAxis[1], b.coneAxis[2], b.coneCutoff};
+            fout.write((const char *)values, sizeof(values));
         }
+        if(g.vertices.empty() == false)
+            fout.write((const char *)(&g.vertices[0]), (std::streamsize)g.vertices.size()*sizeof(unsigned int));
+        if(g.triangles.empty() == false)
+            fout.write((const char *)(&g.triangles[0]), (std::streamsize)g.triangles.size());
+
+        const char padding[4] = {0, 0, 0, 0};
+        fout.write(padding, (4 - g.triangles.size() % 4) % 4);
     }
-    
+
     fout.flush();
     fout.close();
 }
@@ -711,3 +1032,194 @@ void MeshIO::getGroupIndices(Mesh* mesh, std::vector<std::string>& names, std::v
         gIndices.push_back(idx);
     }
 }
+
+bool MeshIO::readAttribute(std::istream& fin, int numVertices, int size, int stride, std::vector<float>& data)
+{
+    data.assign((size_t)numVertices*stride, 0.0f);
+    if(size < 1 || size > 4)
+        return false;
+    if(numVertices == 0)
+        return true;
+
+    if(size == stride)
+    {
+        fin.read((char *)(&data[0]), (std::streamsize)numVertices*size*sizeof(float));
+        return fin.good();
+    }
+
+    const int chunkVertices = 1 << 16;
+    std::vector<float> chunk((size_t)std::min(numVertices, chunkVertices)*size);
+
+    float* dst = &data[0];
+    for(int first = 0; first < numVertices; first += chunkVertices)
+    {
+        int count = std::min(chunkVertices, numVertices - first);
+        fin.read((char *)(&chunk[0]), (std::streamsize)count*size*sizeof(float));
+        if(fin.good() == false)
+            return false;
+
+        // Missing components are 0, a missing w is 1.
+        const float* src = &chunk[0];
+        switch(size)
+        {
+        case 3:
+            for(int i = 0; i < count; ++i, src += 3, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = 1.0f;
+            }
+            break;
+        case 2:
+            for(int i = 0; i < count; ++i, src += 2, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = 0.0f;
+                dst[3] = 1.0f;
+            }
+            break;
+        case 1:
+            for(int i = 0; i < count; ++i, src += 1, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = 0.0f;
+                dst[2] = 0.0f;
+                dst[3] = 1.0f;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+bool MeshIO::readIndices(std::istream& fin, int numIndices, const std::string& indexType,
+                         std::vector<unsigned int>& indices, unsigned int numVertices)
+{
+    indices.assign(numIndices, 0);
+    if(numIndices == 0)
+        return true;
+
+    if(indexType.compare("UNSIGNED_INT") == 0)
+    {
+        fin.read((char *)(&indices[0]), (std::streamsize)numIndices*sizeof(unsigned int));
+    }
+    else if(indexType.compare("UNSIGNED_SHORT") == 0)
+    {
+        std::vector<unsigned short> narrow(numIndices);
+        fin.read((char *)(&narrow[0]), (std::streamsize)numIndices*sizeof(unsigned short));
+        std::copy(narrow.begin(), narrow.end(), indices.begin());
+    }
+    else if(indexType.compare("UNSIGNED_BYTE") == 0)
+    {
+        std::vector<unsigned char> narrow(numIndices);
+        fin.read((char *)(&narrow[0]), numIndices);
+        std::copy(narrow.begin(), narrow.end(), indices.begin());
+    }
+    else if(indexType.compare("ENCODED") == 0)
+    {
+        unsigned int size = 0;
+        fin.read((char *)(&size), sizeof(size));
+        // At most a code byte and 16 data bytes per triangle.
+        if(size > 17 + (unsigned int)numIndices/3*17)
+            return false;
+        std::vector<unsigned char> buffer(size);
+        if(size > 0)
+            fin.read((char *)(&buffer[0]), size);
+        if(fin.good() == false || size == 0 ||
+           IndexCodec::decode(&buffer[0], size, &indices[0], numIndices, numVertices) == false)
+        {
+            indices.assign(numIndices, 0);
+            return false;
+        }
+    }
+    return fin.good();
+}
+
+void MeshIO::writeAttribute(std::ostream& fout, const float* data, int numVertices, int size, int stride)
+{
+    if(size < 1 || size > 4)
+        return;
+
+    if(size == stride)
+    {
+        fout.write((const char *)data, (std::streamsize)numVertices*size*sizeof(float));
+        return;
+    }
+
+    const int chunkVertices = 1 << 16;
+    std::vector<float> chunk((size_t)std::min(numVertices, chunkVertices)*size);
+
+    const float* src = data;
+    for(int first = 0; first < numVertices; first += chunkVertices)
+    {
+        int count = std::min(chunkVertices, numVertices - first);
+        float* dst = &chunk[0];
+        switch(size)
+        {
+        case 3:
+            for(int i = 0; i < count; ++i, src += 4, dst += 3)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            }
+            break;
+        case 2:
+            for(int i = 0; i < count; ++i, src += 4, dst += 2)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+            }
+            break;
+        case 1:
+            for(int i = 0; i < count; ++i, src += 4, dst += 1)
+            {
+                dst[0] = src[0];
+            }
+            break;
+        }
+        fout.write((const char *)(&chunk[0]), (std::streamsize)count*size*sizeof(float));
+    }
+}
+
+void MeshIO::writeIndices(std::ostream& fout, const unsigned int* indices, int numIndices, const std::string& indexType)
+{
+    if(indexType.compare("UNSIGNED_INT") == 0)
+    {
+        fout.write((const char *)indices, (std::streamsize)numIndices*sizeof(unsigned int));
+        return;
+    }
+    if(indexType.compare("ENCODED") == 0)
+    {
+        std::vector<unsigned char> buffer;
+        IndexCodec::encode(indices, numIndices, buffer);
+        fout.write((const char *)(&buffer[0]), (std::streamsize)buffer.size());
+        return;
+    }
+
+    const int chunkIndices = 1 << 18;
+    if(indexType.compare("UNSIGNED_SHORT") == 0)
+    {
+        std::vector<unsigned short> chunk(std::min(numIndices, chunkIndices));
+        for(int first = 0; first < numIndices; first += chunkIndices)
+        {
+            int count = std::min(chunkIndices, numIndices - first);
+            for(int i = 0; i < count; ++i)
+                chunk[i] = (unsigned short)indices[first+i];
+            fout.write((const char *)(&chunk[0]), (std::streamsize)count*sizeof(unsigned short));
+        }
+    }
+    else if(indexType.compare("UNSIGNED_BYTE") == 0)
+    {
+        std::vector<unsigned char> chunk(std::min(numIndices, chunkIndices));
+        for(int first = 0; first < numIndices; first += chunkIndices)
+        {
+            int count = std::min(chunkIndices, numIndices - first);
+            for(int i = 0; i < count; ++i)
+                chunk[i] = (unsigned char)indices[first+i];
+            fout.write((const char *)(&chunk[0]), count);
+        }
+    }
+}
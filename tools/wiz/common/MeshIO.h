@@ -35,6 +35,8 @@
 #define _MESHIO_H_
 
 #include "Mesh.h"
+#include "Modifier.h"
+#include "Meshlets.h"
 
 namespace assembly3d
 {
@@ -53,20 +55,63 @@ namespace assembly3d
             /**
              * @brief Loads a mesh from a file.
              *
+             * Quantized attributes are decoded to floats. Their types are
+             * kept in the mesh format, so saving encodes them again. The
+             * same holds for compressed attributes. Triangle strips are
+             * unpacked into lists, their groups keep the primitive type.
+             * Loading fails on unknown attribute types.
+             *
              * @param mesh Mesh object to write in.
              * @param file Path of the mesh file
              * @param binaryFile Path of the binary file.
              * @return True is load has been successful.
             */
             static bool load(Mesh* mesh, const char* file, const char* binaryFile);
+            /**
+             * @brief Loads a modifier from a file.
+             *
+             * The binary file holds the groups in declaration order. Each
+             * group stores its attribute blocks in declaration order
+             * followed by its vertex indices, like a mesh file.
+             *
+             * @param modifier Modifier object to write in.
+             * @param file Path of the modifier file.
+             * @param binaryFile Path of the binary file.
+             * @return True is load has been successful.
+            */
+            static bool loadModifier(Modifier* modifier, const char* file, const char* binaryFile);
             /**
              * @brief Saves the mesh to a file.
              *
+             * Attributes are encoded as their mesh format types say.
+             * SHORT_NORM and BYTE_NORM attributes are mapped to their
+             * current range, written as min and max. Attributes listed in
+             * compressedAttributes of the mesh format are written with
+             * VertexCodec. TRIANGLE_STRIP groups are written as strips if
+             * the index type has a restart index no vertex uses. Groups
+             * whose indices exceed a narrow index type are written relative
+             * to their lowest vertex, stored as baseVertex. If a group spans
+             * more vertices than the index type holds, the indices are
+             * written as UNSIGNED_INT.
+             *
              * @param mesh Mesh object to save.
              * @param outFilePath Output file path.
              * @param binaryFilePath Output binary file path.
             */
             static void saveFile(Mesh* mesh, const char* outFilePath, const char* binaryFilePath);
+            /**
+             * @brief Saves meshlets to a file next to their mesh.
+             *
+             * The binary file holds the groups in declaration order. Each
+             * group stores its meshlet table (4 UNSIGNED_INT each), its
+             * bounds (11 FLOAT each), its vertex indices (UNSIGNED_INT) and
+             * its triangles (3 UNSIGNED_BYTE each), padded to 4 bytes.
+             *
+             * @param meshlets Meshlets to save.
+             * @param outFilePath Output file path.
+             * @param binaryFilePath Output binary file path.
+            */
+            static void saveMeshlets(const Meshlets* meshlets, const char* outFilePath, const char* binaryFilePath);
             /**
              * @brief Dumps mesh to a .txt file for debugging.
              *
@@ -91,6 +136,60 @@ namespace assembly3d
              * @param gIndices Vector to write group indices in.
             */
             static void getGroupIndices(Mesh* mesh, std::vector<std::string>& names, std::vector<int>& gIndices);
+            /**
+             * @brief Reads an attribute block and lays it out with the given stride.
+             *
+             * If the stride equals the size the block is read directly,
+             * otherwise it is read in large chunks and padded to stride 4
+             * in one pass per chunk.
+             *
+             * @param fin Binary input stream, positioned at the block.
+             * @param numVertices Number of vertices in the block.
+             * @param size Number of floats per vertex in the file (1 to 4).
+             * @param stride Number of floats per vertex in memory (size or 4).
+             * @param data Vector to write the attribute in.
+             * @return False if the size is not 1 to 4 or the block is truncated.
+            */
+            static bool readAttribute(std::istream& fin, int numVertices, int size, int stride, std::vector<float>& data);
+            /**
+             * @brief Reads the index block and widens it to unsigned int.
+             *
+             * ENCODED blocks are decoded with IndexCodec.
+             *
+             * @param fin Binary input stream, positioned at the block.
+             * @param numIndices Number of indices to read.
+             * @param indexType Index type of the file.
+             * @param indices Vector to write the indices in.
+             * @param numVertices Number of vertices, ENCODED indices must be below.
+             * @return False if the block is truncated or an ENCODED block
+             * is malformed.
+            */
+            static bool readIndices(std::istream& fin, int numIndices, const std::string& indexType,
+                                    std::vector<unsigned int>& indices, unsigned int numVertices);
+            /**
+             * @brief Writes an attribute stripped to its declared size.
+             *
+             * Compact data is written directly. Stride-4 data is packed
+             * into a staging buffer and written in large chunks.
+             *
+             * @param fout Binary output stream.
+             * @param data Attribute data.
+             * @param numVertices Number of vertices to write.
+             * @param size Number of floats per vertex to write (1 to 4).
+             * @param stride Number of floats per vertex in memory (size or 4).
+            */
+            static void writeAttribute(std::ostream& fout, const float* data, int numVertices, int size, int stride);
+            /**
+             * @brief Writes indices narrowed to the given index type.
+             *
+             * ENCODED writes an IndexCodec block.
+             *
+             * @param fout Binary output stream.
+             * @param indices Indices to write.
+             * @param numIndices Number of indices.
+             * @param indexType Index type to write.
+            */
+            static void writeIndices(std::ostream& fout, const unsigned int* indices, int numIndices, const std::string& indexType);
         };
     }
 }
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshNormals.h"
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define A3D_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace assembly3d;
+
+namespace
+{
+    // Writes the unit normal and the length of the cross product.
+    inline void storeTriangleNormal(float* dst, float nx, float ny, float nz)
+    {
+        float tmpLength = sqrtf(nx * nx + ny * ny + nz * nz);
+        float length = tmpLength == 0.0f ? 0.0f : 1.0f / tmpLength;
+        dst[0] = nx * length;
+        dst[1] = ny * length;
+        dst[2] = nz * length;
+        dst[3] = tmpLength;
+    }
+
+    inline float getWeight(const float* positions, int stride, const unsigned int* indices,
+                           const float* triangleNormal, unsigned int triangle,
+                           unsigned int vertex, MeshNormals::Weighting weighting)
+    {
+        switch(weighting)
+        {
+        case MeshNormals::AREA_WEIGHTED:
+            return triangleNormal[3];
+        case MeshNormals::ANGLE_WEIGHTED:
+        {
+            const unsigned int* t = indices + triangle*3;
+            int k = t[0] == vertex ? 0 : (t[1] == vertex ? 1 : 2);
+            const float* a = positions + (size_t)t[k]*stride;
+            const float* b = positions + (size_t)t[(k+1)%3]*stride;
+            const float* c = positions + (size_t)t[(k+2)%3]*stride;
+            float dot = (b[0]-a[0])*(c[0]-a[0]) + (b[1]-a[1])*(c[1]-a[1]) + (b[2]-a[2])*(c[2]-a[2]);
+            // The cross product length of the corner's edges is twice
+            // the area, whatever the corner.
+            return atan2f(triangleNormal[3], dot);
+        }
+        default:
+            return 1.0f;
+        }
+    }
+
+    inline void normalizeNormal(float* n)
+    {
+        float tmpLength = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float length = tmpLength == 0.0f ? 0.0f : 1.0f / tmpLength;
+        n[0] *= length;
+        n[1] *= length;
+        n[2] *= length;
+        n[3] = 0.0f;
+    }
+}
+
+void MeshNormals::computeTriangleNormals(const float* positions, int stride,
+                                         const unsigned int* indices, int numTriangles,
+                                         std::vector<float>& normals)
+{
+    normals.resize((size_t)numTriangles*4);
+    if(numTriangles == 0)
+        return;
+    float* out = &normals[0];
+
+#ifdef A3D_USE_SSE
+    if(stride == 4)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i = 0; i < numTriangles; ++i)
+        {
+            const unsigned int* t = indices + i*3;
+            __m128 p0 = _mm_loadu_ps(positions + (size_t)t[0]*4);
+            __m128 e1 = _mm_sub_ps(_mm_loadu_ps(positions + (size_t)t[1]*4), p0);
+            __m128 e2 = _mm_sub_ps(_mm_loadu_ps(positions + (size_t)t[2]*4), p0);
+
+            // e1.yzx * e2.zxy - e1.zxy * e2.yzx
+            __m128 n = _mm_sub_ps(
+                _mm_mul_ps(_mm_shuffle_ps(e1, e1, _MM_SHUFFLE(3, 0, 2, 1)),
+                           _mm_shuffle_ps(e2, e2, _MM_SHUFFLE(3, 1, 0, 2))),
+                _mm_mul_ps(_mm_shuffle_ps(e1, e1, _MM_SHUFFLE(3, 1, 0, 2)),
+                           _mm_shuffle_ps(e2, e2, _MM_SHUFFLE(3, 0, 2, 1))));
+
+            float cross[4];
+            _mm_storeu_ps(cross, n);
+            storeTriangleNormal(out + (size_t)i*4, cross[0], cross[1], cross[2]);
+        }
+        return;
+    }
+#endif
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i = 0; i < numTriangles; ++i)
+    {
+        const unsigned int* t = indices + i*3;
+        const float* p0 = positions + (size_t)t[0]*stride;
+        const float* p1 = positions + (size_t)t[1]*stride;
+        const float* p2 = positions + (size_t)t[2]*stride;
+
+        float edge1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float edge2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+
+        storeTriangleNormal(out + (size_t)i*4,
+                            (edge1[1] * edge2[2]) - (edge1[2] * edge2[1]),
+                            (edge1[2] * edge2[0]) - (edge1[0] * edge2[2]),
+                            (edge1[0] * edge2[1]) - (edge1[1] * edge2[0]));
+    }
+}
+
+void MeshNormals::computeVertexNormals(const float* positions, int stride,
+                                       const unsigned int* indices,
+                                       const MeshAdjacency& adjacency,
+                                       const std::vector<float>& triangleNormals,
+                                       Weighting weighting, std::vector<float>& normals)
+{
+    const int numVertices = adjacency.getNumberOfVertices();
+    normals.assign((size_t)numVertices*4, 0.0f);
+    if(numVertices == 0 || triangleNormals.empty())
+        return;
+
+    const float* tn = &triangleNormals[0];
+    float* out = &normals[0];
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+    for(int v = 0; v < numVertices; ++v)
+    {
+        const unsigned int* triangles = adjacency.getVertexTriangles(v);
+        const int count = adjacency.getVertexTriangleCount(v);
+
+        float* n = out + (size_t)v*4;
+        for(int i = 0; i < count; ++i)
+        {
+            const float* normal = tn + (size_t)triangles[i]*4;
+            if(weighting == UNWEIGHTED)
+            {
+                n[0] += normal[0];
+                n[1] += normal[1];
+                n[2] += normal[2];
+            }
+            else
+            {
+                float w = getWeight(positions, stride, indices, normal, triangles[i], v, weighting);
+                n[0] += w * normal[0];
+                n[1] += w * normal[1];
+                n[2] += w * normal[2];
+            }
+        }
+        normalizeNormal(n);
+    }
+}
+
+void MeshNormals::computeCornerNormals(const float* positions, int stride,
+                                       const unsigned int* indices,
+                                       const MeshAdjacency& adjacency,
+                                       const std::vector<float>& triangleNormals,
+                                       Weighting weighting, float creaseAngle,
+                                       std::vector<float>& normals)
+{
+    const int numVertices = adjacency.getNumberOfVertices();
+    const int numTriangles = adjacency.getNumberOfTriangles();
+    normals.assign((size_t)numTriangles*12, 0.0f);
+    if(numTriangles == 0)
+        return;
+
+    const float cosCrease = cosf(creaseAngle);
+    const float* tn = &triangleNormals[0];
+    float* out = &normals[0];
+
+    // Every vertex writes the corners that use it, so the writes of two
+    // threads never overlap.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+    for(int v = 0; v < numVertices; ++v)
+    {
+        const unsigned int* triangles = adjacency.getVertexTriangles(v);
+        const int count = adjacency.getVertexTriangleCount(v);
+
+        for(int i = 0; i < count; ++i)
+        {
+            const unsigned int t = triangles[i];
+            const float* own = tn + (size_t)t*4;
+
+            // Zero-area triangles have no direction to compare against,
+            // they neither collect nor contribute to a crease group.
+            float n[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            if(own[3] != 0.0f)
+            {
+                for(int j = 0; j < count; ++j)
+                {
+                    const float* normal = tn + (size_t)triangles[j]*4;
+                    if(normal[3] == 0.0f ||
+                       own[0]*normal[0] + own[1]*normal[1] + own[2]*normal[2] < cosCrease)
+                        continue;
+
+                    float w = getWeight(positions, stride, indices, normal, triangles[j], v, weighting);
+                    n[0] += w * normal[0];
+                    n[1] += w * normal[1];
+                    n[2] += w * normal[2];
+                }
+            }
+
+            // Corners of zero-area triangles, or whose group cancelled
+            // out, take the smooth normal of the vertex.
+            if(n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f)
+            {
+                for(int j = 0; j < count; ++j)
+                {
+                    const float* normal = tn + (size_t)triangles[j]*4;
+                    if(normal[3] == 0.0f)
+                        continue;
+
+                    float w = getWeight(positions, stride, indices, normal, triangles[j], v, weighting);
+                    n[0] += w * normal[0];
+                    n[1] += w * normal[1];
+                    n[2] += w * normal[2];
+                }
+            }
+            normalizeNormal(n);
+
+            for(int k = 0; k < 3; ++k)
+            {
+                if(indices[t*3+k] != (unsigned int)v)
+                    continue;
+                float* dst = out + ((size_t)t*3+k)*4;
+                dst[0] = n[0];
+                dst[1] = n[1];
+                dst[2] = n[2];
+                dst[3] = 0.0f;
+            }
+        }
+    }
+}
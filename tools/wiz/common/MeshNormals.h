@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _MESHNORMALS_H_
+#define _MESHNORMALS_H_
+
+#include <vector>
+#include "MeshAdjacency.h"
+
+namespace assembly3d
+{
+    /**
+     * @brief Face and vertex normal generation.
+     *
+     * Triangle normals are computed in one parallel pass. Vertex and
+     * corner normals gather the normals of the triangles around each
+     * vertex through the adjacency, so every thread only writes the
+     * normals of its own vertices.
+     */
+    class MeshNormals
+    {
+    private:
+        MeshNormals();
+        ~MeshNormals();
+    public:
+
+        enum Weighting
+        {
+            UNWEIGHTED=0,   ///< Every triangle counts the same.
+            AREA_WEIGHTED,  ///< Triangles count by their area.
+            ANGLE_WEIGHTED  ///< Triangles count by their angle at the vertex.
+        };
+
+        /**
+         * @brief Computes unit triangle normals.
+         *
+         * @param positions Vertex positions.
+         * @param stride Number of floats from one position to the next.
+         * @param indices Triangle indices.
+         * @param numTriangles Number of triangles.
+         * @param normals Vector to write 4 floats per triangle in: the unit
+         * normal and twice the triangle area.
+         */
+        static void computeTriangleNormals(const float* positions, int stride,
+                                           const unsigned int* indices, int numTriangles,
+                                           std::vector<float>& normals);
+        /**
+         * @brief Computes unit vertex normals.
+         *
+         * @param positions Vertex positions.
+         * @param stride Number of floats from one position to the next.
+         * @param indices Triangle indices.
+         * @param adjacency Adjacency of the triangles.
+         * @param triangleNormals Result of computeTriangleNormals().
+         * @param weighting How the triangles around a vertex are weighted.
+         * @param normals Vector to write 4 floats per vertex in.
+         */
+        static void computeVertexNormals(const float* positions, int stride,
+                                         const unsigned int* indices,
+                                         const MeshAdjacency& adjacency,
+                                         const std::vector<float>& triangleNormals,
+                                         Weighting weighting, std::vector<float>& normals);
+        /**
+         * @brief Computes unit normals for every triangle corner.
+         *
+         * A corner only takes the triangles around its vertex whose
+         * normals differ by at most creaseAngle from its own triangle.
+         * Corners of a vertex that end up on the same side of all creases
+         * get bitwise equal normals.
+         *
+         * @param creaseAngle Largest smoothed angle in radians.
+         * @param normals Vector to write 4 floats per corner in, corner
+         * 3*triangle+k at offset 4*(3*triangle+k).
+         */
+        static void computeCornerNormals(const float* positions, int stride,
+                                         const unsigned int* indices,
+                                         const MeshAdjacency& adjacency,
+                                         const std::vector<float>& triangleNormals,
+                                         Weighting weighting, float creaseAngle,
+                                         std::vector<float>& normals);
+    };
+}
+
+#endif  // _MESHNORMALS_H_
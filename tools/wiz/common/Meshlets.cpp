@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "Meshlets.h"
+
+using namespace assembly3d;
+
+Meshlets::Meshlets()
+    : m_maxVertices(0),
+      m_maxTriangles(0)
+{
+}
+
+Meshlets::~Meshlets()
+{
+}
+
+void Meshlets::destroy()
+{
+    m_groups.clear();
+}
+
+void Meshlets::setLimits(int maxVertices, int maxTriangles)
+{
+    m_maxVertices = maxVertices;
+    m_maxTriangles = maxTriangles;
+}
+
+int Meshlets::getMaxVertices() const
+{
+    return m_maxVertices;
+}
+
+int Meshlets::getMaxTriangles() const
+{
+    return m_maxTriangles;
+}
+
+void Meshlets::addGroup(const Group& group)
+{
+    m_groups.push_back(group);
+}
+
+Meshlets::Group& Meshlets::getGroup(unsigned int index)
+{
+    return m_groups[index];
+}
+
+const Meshlets::Group& Meshlets::getGroup(unsigned int index) const
+{
+    return m_groups[index];
+}
+
+int Meshlets::getNumberOfGroups() const
+{
+    return static_cast<int>(m_groups.size());
+}
+
+int Meshlets::getNumberOfMeshlets() const
+{
+    size_t count = 0;
+    for(size_t i = 0; i < m_groups.size(); ++i)
+        count += m_groups[i].meshlets.size();
+    return static_cast<int>(count);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _MESHLETS_H_
+#define _MESHLETS_H_
+
+#include <vector>
+#include <string>
+
+namespace assembly3d
+{
+    /**
+     * @brief Triangle clusters of a mesh, one set per mesh group.
+     *
+     * Each meshlet references at most maxVertices mesh vertices through
+     * its own vertex list and stores its triangles as byte sized indices
+     * into that list. Offsets of a meshlet are relative to the arrays of
+     * its group.
+     */
+    class Meshlets
+    {
+    public:
+
+        /**
+         * @brief Ranges of one meshlet in the arrays of its group.
+         *
+         */
+        struct Meshlet
+        {
+            unsigned int vertexOffset;
+            unsigned int vertexCount;
+            unsigned int triangleOffset;    ///< In triangles, 3 bytes each.
+            unsigned int triangleCount;
+        };
+
+        /**
+         * @brief Culling bounds of one meshlet.
+         *
+         * The meshlet faces away from a camera at position p if
+         * dot(normalize(coneApex - p), coneAxis) >= coneCutoff. A cutoff
+         * of 1 never culls.
+         */
+        struct Bounds
+        {
+            float center[3];
+            float radius;
+            float coneApex[3];
+            float coneAxis[3];
+            float coneCutoff;
+        };
+
+        /**
+         * @brief Meshlets of one mesh group.
+         *
+         */
+        struct Group
+        {
+            std::string name;
+            std::vector<Meshlet> meshlets;
+            std::vector<Bounds> bounds;
+            std::vector<unsigned int> vertices;
+            std::vector<unsigned char> triangles;
+        };
+
+        Meshlets();
+        ~Meshlets();
+
+        /**
+         * @brief Clears all groups.
+         *
+        */
+        void destroy();
+        /**
+         * @brief Sets the size limits the meshlets were built with.
+         *
+         * @param maxVertices Largest number of vertices per meshlet.
+         * @param maxTriangles Largest number of triangles per meshlet.
+        */
+        void setLimits(int maxVertices, int maxTriangles);
+        int getMaxVertices() const;
+        int getMaxTriangles() const;
+        /**
+         * @brief Adds a group.
+         *
+         * @param group A group.
+        */
+        void addGroup(const Group& group);
+        /**
+         * @brief Gets a group for an index.
+         *
+         * @param index A group index.
+         * @return Group at index.
+        */
+        Group& getGroup(unsigned int index);
+        const Group& getGroup(unsigned int index) const;
+        /**
+         * @brief Gets total number of groups.
+         *
+        */
+        int getNumberOfGroups() const;
+        /**
+         * @brief Gets total number of meshlets of all groups.
+         *
+        */
+        int getNumberOfMeshlets() const;
+
+    private:
+        std::vector<Group> m_groups;
+        int m_maxVertices;
+        int m_maxTriangles;
+    };
+}
+
+#endif  // _MESHLETS_H_
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _MODIFIER_H_
+#define _MODIFIER_H_
+
+#include <vector>
+#include <string>
+
+namespace assembly3d
+{
+    /**
+     * @brief Sparse vertex attribute changes for a mesh.
+     *
+     * A modifier consists of groups. Each group addresses a set of
+     * vertices of the base mesh by index and carries one value per
+     * vertex for each of its attributes. Values are either deltas
+     * that are added to the base mesh (morph targets) or absolute
+     * values that replace it.
+     *
+     * Values are stored per component (structure of arrays), so a
+     * blend reads each component as one contiguous stream.
+     */
+    class Modifier
+    {
+    public:
+
+        enum BlendMode
+        {
+            DELTA=0,    ///< value = base + weight * delta
+            OVERRIDE    ///< value = base + weight * (target - base)
+        };
+
+        /**
+         * @brief Values of one attribute for the vertices of a group.
+         *
+         */
+        struct Target
+        {
+            std::string name;
+            int size;
+            std::vector<float> components[4];   ///< size arrays, one value per group vertex each.
+        };
+
+        /**
+         * @brief A set of vertices and their attribute values.
+         *
+         */
+        struct Group
+        {
+            std::string name;
+            BlendMode mode;
+            std::vector<unsigned int> vertices;
+            std::vector<Target> attributes;
+        };
+
+        Modifier();
+        ~Modifier();
+
+        /**
+         * @brief Clears all groups.
+         *
+        */
+        void destroy();
+        /**
+         * @brief Adds a group to the modifier.
+         *
+         * @param group A group.
+        */
+        void addGroup(const Group& group);
+        /**
+         * @brief Gets a group for an index.
+         *
+         * @param index A group index.
+         * @return Group at index.
+        */
+        Group& getGroup(unsigned int index);
+        const Group& getGroup(unsigned int index) const;
+        /**
+         * @brief Gets total number of groups.
+         *
+        */
+        int getNumberOfGroups() const;
+        /**
+         * @brief Checks that every group fits a mesh.
+         *
+         * @param numVertices Number of vertices of the mesh.
+         * @return True if all vertex indices are below numVertices.
+        */
+        bool isValidFor(int numVertices) const;
+        /**
+         * @brief Sets path of modifier file.
+         *
+         * @param path Modifier path string.
+        */
+        void setModifierPath(const char* path);
+        /**
+         * @brief Gets modifier path.
+         *
+         * @return const char *
+        */
+        const char* getModifierPath() const;
+
+    private:
+        std::vector<Group> m_groups;
+        std::string m_modifierPath;
+    };
+}
+
+#endif  // _MODIFIER_H_
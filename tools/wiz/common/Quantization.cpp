@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "Quantization.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace assembly3d;
+
+static const char* encodingNames[Quantization::UNKNOWN] = {"FLOAT", "HALF_FLOAT", "SHORT_NORM", "BYTE_NORM",
+                                                          "OCT_SHORT", "OCT_BYTE"};
+
+static int quantizeNormalized(float value, int maximum)
+{
+    value = std::max(-1.0f, std::min(1.0f, value));
+    return (int)floorf(value*static_cast<float>(maximum) + 0.5f);
+}
+
+static float dequantizeNormalized(int value, int maximum)
+{
+    return std::max(static_cast<float>(value) / static_cast<float>(maximum), -1.0f);
+}
+
+// Projects a unit vector onto the octahedron and unfolds the lower half.
+static void octahedralEncode(const float* v, float& x, float& y)
+{
+    float length = fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]);
+    if(length == 0.0f)
+    {
+        x = 0.0f;
+        y = 0.0f;
+        return;
+    }
+    x = v[0] / length;
+    y = v[1] / length;
+    if(v[2] < 0.0f)
+    {
+        float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+}
+
+static void octahedralDecode(float x, float y, float* v)
+{
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = std::max(-z, 0.0f);
+    x -= x >= 0.0f ? t : -t;
+    y -= y >= 0.0f ? t : -t;
+    float length = sqrtf(x*x + y*y + z*z);
+    v[0] = x / length;
+    v[1] = y / length;
+    v[2] = z / length;
+}
+
+Quantization::Encoding Quantization::getEncoding(const std::string& type)
+{
+    for(int i = 0; i < UNKNOWN; ++i)
+    {
+        if(type.compare(encodingNames[i]) == 0)
+            return static_cast<Encoding>(i);
+    }
+    return UNKNOWN;
+}
+
+const char* Quantization::getTypeName(Encoding encoding)
+{
+    if(encoding < FLOAT || encoding >= UNKNOWN)
+        return "";
+    return encodingNames[encoding];
+}
+
+bool Quantization::usesRange(Encoding encoding)
+{
+    return encoding == SHORT_NORM || encoding == BYTE_NORM;
+}
+
+int Quantization::getVertexSize(Encoding encoding, int size)
+{
+    switch(encoding)
+    {
+    case FLOAT:
+        return size*4;
+    case HALF_FLOAT:
+    case SHORT_NORM:
+        return size*2;
+    case BYTE_NORM:
+        return size;
+    case OCT_SHORT:
+        return (size == 4 ? 3 : 2)*2;
+    case OCT_BYTE:
+        return size == 4 ? 3 : 2;
+    default:
+        return 0;
+    }
+}
+
+int Quantization::getBlockSize(Encoding encoding, int size, int numVertices)
+{
+    int bytes = getVertexSize(encoding, size)*numVertices;
+    return (bytes + 3) & ~3;
+}
+
+void Quantization::computeRange(const float* data, int numVertices, int size, int stride,
+                                float* minimum, float* maximum)
+{
+    for(int c = 0; c < size; ++c)
+    {
+        minimum[c] = numVertices > 0 ? data[c] : 0.0f;
+        maximum[c] = minimum[c];
+    }
+    for(int i = 1; i < numVertices; ++i)
+    {
+        const float* v = data + (size_t)i*stride;
+        for(int c = 0; c < size; ++c)
+        {
+            minimum[c] = std::min(minimum[c], v[c]);
+            maximum[c] = std::max(maximum[c], v[c]);
+        }
+    }
+}
+
+// Maps the range to [-1, 1] per component.
+static void getRangeTransform(int size, const float* minimum, const float* maximum,
+                              float* center, float* extent)
+{
+    for(int c = 0; c < size; ++c)
+    {
+        center[c] = minimum && maximum ? 0.5f*(minimum[c] + maximum[c]) : 0.0f;
+        extent[c] = minimum && maximum ? 0.5f*(maximum[c] - minimum[c]) : 1.0f;
+    }
+}
+
+void Quantization::encode(Encoding encoding, const float* data, int numVertices, int size, int stride,
+                          const float* minimum, const float* maximum, std::vector<unsigned char>& block)
+{
+    block.assign(getBlockSize(encoding, size, numVertices), 0);
+    if(block.empty())
+        return;
+
+    float center[4];
+    float extent[4];
+    getRangeTransform(size, minimum, maximum, center, extent);
+
+    switch(encoding)
+    {
+    case FLOAT:
+    {
+        float* out = (float*)&block[0];
+        for(int i = 0; i < numVertices; ++i)
+            memcpy(out + (size_t)i*size, data + (size_t)i*stride, size*sizeof(float));
+        break;
+    }
+    case HALF_FLOAT:
+    {
+        unsigned short* out = (unsigned short*)&block[0];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i = 0; i < numVertices; ++i)
+        {
+            for(int c = 0; c < size; ++c)
+                out[(size_t)i*size+c] = floatToHalf(data[(size_t)i*stride+c]);
+        }
+        break;
+    }
+    case SHORT_NORM:
+    case BYTE_NORM:
+    {
+        const int bits = encoding == SHORT_NORM ? 32767 : 127;
+        short* outShort = (short*)&block[0];
+        signed char* outByte = (signed char*)&block[0];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i = 0; i < numVertices; ++i)
+        {
+            for(int c = 0; c < size; ++c)
+            {
+                float n = extent[c] > 0.0f ? (data[(size_t)i*stride+c] - center[c]) / extent[c] : 0.0f;
+                int q = quantizeNormalized(n, bits);
+                if(encoding == SHORT_NORM)
+                    outShort[(size_t)i*size+c] = (short)q;
+                else
+                    outByte[(size_t)i*size+c] = (signed char)q;
+            }
+        }
+        break;
+    }
+    case OCT_SHORT:
+    case OCT_BYTE:
+    {
+        const int bits = encoding == OCT_SHORT ? 32767 : 127;
+        const int components = size == 4 ? 3 : 2;
+        short* outShort = (short*)&block[0];
+        signed char* outByte = (signed char*)&block[0];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i = 0; i < numVertices; ++i)
+        {
+            const float* v = data + (size_t)i*stride;
+            float vector[3] = {v[0], size > 1 ? v[1] : 0.0f, size > 2 ? v[2] : 0.0f};
+            float e[3];
+            octahedralEncode(vector, e[0], e[1]);
+            e[2] = size == 4 ? v[3] : 0.0f;
+            for(int c = 0; c < components; ++c)
+            {
+                int q = quantizeNormalized(e[c], bits);
+                if(encoding == OCT_SHORT)
+                    outShort[(size_t)i*components+c] = (short)q;
+                else
+                    outByte[(size_t)i*components+c] = (signed char)q;
+            }
+        }
+        break;
+    }
+    default:
+        block.clear();
+        break;
+    }
+}
+
+void Quantization::decode(Encoding encoding, const unsigned char* block, int numVertices, int size, int stride,
+                          const float* minimum, const float* maximum, float* data)
+{
+    float center[4];
+    float extent[4];
+    getRangeTransform(size, minimum, maximum, center, extent);
+
+    // Missing components are 0, a missing w is 1.
+    for(int i = 0; i < numVertices && stride > size; ++i)
+    {
+        float* v = data + (size_t)i*stride;
+        for(int c = size; c < stride; ++c)
+            v[c] = c == 3 ? 1.0f : 0.0f;
+    }
+
+    switch(encoding)
+    {
+    case FLOAT:
+    {
+        const float* in = (const float*)block;
+        for(int i = 0; i < numVertices; ++i)
+            memcpy(data + (size_t)i*stride, in + (size_t)i*size, size*sizeof(float));
+        break;
+    }
+    case HALF_FLOAT:
+    {
+        const unsigned short* in = (const unsigned short*)block;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i = 0; i < numVertices; ++i)
+        {
+            for(int c = 0; c < size; ++c)
+                data[(size_t)i*stride+c] = halfToFloat(in[(size_t)i*size+c]);
+        }
+        break;
+    }
+    case SHORT_NORM:
+    case BYTE_NORM:
+    {
+        const int bits = encoding == SHORT_NORM ? 32767 : 127;
+        const short* inShort = (const short*)block;
+        const signed char* inByte = (const signed char*)block;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i = 0; i < numVertices; ++i)
+        {
+            for(int c = 0; c < size; ++c)
+            {
+                int q = encoding == SHORT_NORM ? inShort[(size_t)i*size+c] : inByte[(size_t)i*size+c];
+                data[(size_t)i*stride+c] = center[c] + dequantizeNormalized(q, bits)*extent[c];
+            }
+        }
+        break;
+    }
+    case OCT_SHORT:
+    case OCT_BYTE:
+    {
+        const int bits = encoding == OCT_SHORT ? 32767 : 127;
+        const int components = size == 4 ? 3 : 2;
+        const short* inShort = (const short*)block;
+        const signed char* inByte = (const signed char*)block;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i = 0; i < numVertices; ++i)
+        {
+            float e[3];
+            for(int c = 0; c < components; ++c)
+            {
+                int q = encoding == OCT_SHORT ? inShort[(size_t)i*components+c] : inByte[(size_t)i*components+c];
+                e[c] = dequantizeNormalized(q, bits);
+            }
+            float vector[3];
+            octahedralDecode(e[0], e[1], vector);
+            float* v = data + (size_t)i*stride;
+            for(int c = 0; c < size && c < 3; ++c)
+                v[c] = vector[c];
+            if(size == 4)
+                v[3] = e[2];
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+unsigned short Quantization::floatToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned int sign = (bits >> 16) & 0x8000;
+    unsigned int magnitude = bits & 0x7fffffff;
+
+    // Infinity and NaN, keeping NaN quiet.
+    if(magnitude >= 0x7f800000)
+        return (unsigned short)(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+    // Rounds to infinity from 65520 on.
+    if(magnitude >= 0x477ff000)
+        return (unsigned short)(sign | 0x7c00);
+    // Subnormal halfs are multiples of 2^-24.
+    if(magnitude < 0x38800000)
+    {
+        float f;
+        memcpy(&f, &magnitude, sizeof(f));
+        float scaled = f * 16777216.0f;
+        unsigned int h = (unsigned int)scaled;
+        float rest = scaled - (float)h;
+        if(rest > 0.5f || (rest == 0.5f && (h & 1)))
+            ++h;
+        return (unsigned short)(sign | h);
+    }
+
+    // Rebias the exponent from 127 to 15 and round the dropped 13 bits.
+    unsigned int h = (magnitude - 0x38000000) >> 13;
+    unsigned int rest = magnitude & 0x1fff;
+    if(rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+        ++h;
+    return (unsigned short)(sign | h);
+}
+
+float Quantization::halfToFloat(unsigned short value)
+{
+    unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+    unsigned int exponent = (value >> 10) & 0x1f;
+    unsigned int mantissa = value & 0x3ff;
+
+    unsigned int bits;
+    if(exponent == 0)
+    {
+        float f = static_cast<float>(mantissa) / 16777216.0f;
+        memcpy(&bits, &f, sizeof(bits));
+        bits |= sign;
+    }
+    else if(exponent == 31)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
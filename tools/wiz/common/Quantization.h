@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _QUANTIZATION_H_
+#define _QUANTIZATION_H_
+
+#include <vector>
+#include <string>
+
+namespace assembly3d
+{
+    /**
+     * @brief Storage encodings for vertex attributes.
+     *
+     * Meshes keep floats in memory, the encodings only apply to the
+     * binary file. SHORT_NORM and BYTE_NORM store normalized signed
+     * integers, mapped to a per attribute range [min, max] if one is
+     * given. OCT_SHORT and OCT_BYTE store unit vectors in two octahedral
+     * components, plus one normalized component for a w of size 4
+     * attributes. Every encoded attribute block is padded to 4 bytes.
+     */
+    class Quantization
+    {
+    private:
+        Quantization();
+        ~Quantization();
+    public:
+
+        enum Encoding
+        {
+            FLOAT=0,
+            HALF_FLOAT,
+            SHORT_NORM,
+            BYTE_NORM,
+            OCT_SHORT,
+            OCT_BYTE,
+            UNKNOWN
+        };
+
+        /**
+         * @brief Gets the encoding for an attribute type name.
+         *
+         * @param type Type name as in the mesh file.
+         * @return UNKNOWN if the name is not an encoding.
+         */
+        static Encoding getEncoding(const std::string& type);
+        /**
+         * @brief Gets the attribute type name of an encoding.
+         *
+         */
+        static const char* getTypeName(Encoding encoding);
+        /**
+         * @brief Tells if an encoding is mapped to a range.
+         *
+         */
+        static bool usesRange(Encoding encoding);
+        /**
+         * @brief Gets the number of bytes per vertex.
+         *
+         * @param encoding The encoding.
+         * @param size Number of components of the attribute.
+         */
+        static int getVertexSize(Encoding encoding, int size);
+        /**
+         * @brief Gets the number of bytes of an attribute block, padding included.
+         *
+         */
+        static int getBlockSize(Encoding encoding, int size, int numVertices);
+
+        /**
+         * @brief Computes the range of an attribute per component.
+         *
+         * @param data Attribute data.
+         * @param numVertices Number of vertices.
+         * @param size Number of components.
+         * @param stride Number of floats from one vertex to the next.
+         * @param minimum Receives size components.
+         * @param maximum Receives size components.
+         */
+        static void computeRange(const float* data, int numVertices, int size, int stride,
+                                 float* minimum, float* maximum);
+        /**
+         * @brief Encodes an attribute.
+         *
+         * @param encoding The encoding.
+         * @param data Attribute data.
+         * @param numVertices Number of vertices.
+         * @param size Number of components.
+         * @param stride Number of floats from one vertex to the next.
+         * @param minimum Lower end of the range per component, 0 for [-1, 1].
+         * @param maximum Upper end of the range per component, 0 for [-1, 1].
+         * @param block Receives the attribute block, padding included.
+         */
+        static void encode(Encoding encoding, const float* data, int numVertices, int size, int stride,
+                           const float* minimum, const float* maximum, std::vector<unsigned char>& block);
+        /**
+         * @brief Decodes an attribute.
+         *
+         * Missing components are 0, a missing w is 1, as for float data.
+         *
+         * @param block Attribute block as written by encode().
+         * @param data Receives numVertices*stride floats.
+         */
+        static void decode(Encoding encoding, const unsigned char* block, int numVertices, int size, int stride,
+                           const float* minimum, const float* maximum, float* data);
+
+        /**
+         * @brief Converts a float to IEEE half precision, rounding to nearest even.
+         *
+         */
+        static unsigned short floatToHalf(float value);
+        /**
+         * @brief Converts IEEE half precision to a float.
+         *
+         */
+        static float halfToFloat(unsigned short value);
+    };
+}
+
+#endif  // _QUANTIZATION_H_
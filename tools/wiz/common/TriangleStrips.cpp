@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "TriangleStrips.h"
+#include <cstring>
+
+using namespace assembly3d;
+
+// Number of upcoming triangles a strip may continue with.
+static const int windowSize = 16;
+
+namespace
+{
+    struct Window
+    {
+        unsigned int triangles[windowSize][3];
+        int count;
+
+        // Finds a triangle not in the used mask with the directed edge
+        // (v0, v1) and returns its third vertex.
+        int findEdge(unsigned int v0, unsigned int v1, unsigned int used, unsigned int& third) const
+        {
+            for(int i = 0; i < count; ++i)
+            {
+                if(used & (1u << i))
+                    continue;
+                const unsigned int* t = triangles[i];
+                for(int k = 0; k < 3; ++k)
+                {
+                    if(t[k] == v0 && t[(k+1)%3] == v1)
+                    {
+                        third = t[(k+2)%3];
+                        return i;
+                    }
+                }
+            }
+            return -1;
+        }
+
+        // Length of the strip starting with triangle i as (v0, v1, v2),
+        // counted within the window.
+        int followStrip(int i, unsigned int v1, unsigned int v2) const
+        {
+            unsigned int used = 1u << i;
+            unsigned int a = v1;
+            unsigned int b = v2;
+            int length = 3;
+            for(;;)
+            {
+                unsigned int c = 0;
+                int next = (length & 1) ? findEdge(b, a, used, c) : findEdge(a, b, used, c);
+                if(next < 0)
+                    return length;
+                used |= 1u << next;
+                a = b;
+                b = c;
+                ++length;
+            }
+        }
+
+        void remove(int i)
+        {
+            memmove(triangles[i], triangles[i+1], (count - i - 1)*sizeof(triangles[0]));
+            --count;
+        }
+    };
+}
+
+TriangleStrips::TriangleStrips()
+{
+}
+
+TriangleStrips::~TriangleStrips()
+{
+}
+
+void TriangleStrips::stripify(const unsigned int* indices, int numTriangles, unsigned int restartIndex,
+                              std::vector<unsigned int>& strip)
+{
+    strip.clear();
+    if(numTriangles <= 0)
+        return;
+    strip.reserve((size_t)numTriangles*2);
+
+    unsigned int maxVertex = 0;
+    for(int i = 0; i < numTriangles*3; ++i)
+    {
+        if(indices[i] > maxVertex)
+            maxVertex = indices[i];
+    }
+
+    // Triangles left per vertex. Strips start at the vertex with the
+    // fewest, so they run from the border inwards.
+    std::vector<unsigned int> valence((size_t)maxVertex + 1, 0);
+    for(int i = 0; i < numTriangles*3; ++i)
+        ++valence[indices[i]];
+
+    Window window;
+    window.count = 0;
+    int next = 0;
+
+    // Last two vertices of the current strip and its length.
+    unsigned int a = 0;
+    unsigned int b = 0;
+    int length = 0;
+
+    for(;;)
+    {
+        for(; window.count < windowSize && next < numTriangles; ++next)
+        {
+            memcpy(window.triangles[window.count], indices + next*3, sizeof(window.triangles[0]));
+            ++window.count;
+        }
+        if(window.count == 0)
+            break;
+
+        // The next strip triangle is (a, b, c), or (b, a, c) after an odd one.
+        unsigned int c = 0;
+        int found = -1;
+        if(length >= 2)
+            found = (length & 1) ? window.findEdge(b, a, 0, c) : window.findEdge(a, b, 0, c);
+
+        if(found >= 0)
+        {
+            strip.push_back(c);
+            a = b;
+            b = c;
+            ++length;
+        }
+        else
+        {
+            if(length > 0)
+                strip.push_back(restartIndex);
+
+            unsigned int corner = window.triangles[0][0];
+            for(int i = 0; i < window.count; ++i)
+            {
+                for(int k = 0; k < 3; ++k)
+                {
+                    if(valence[window.triangles[i][k]] < valence[corner])
+                        corner = window.triangles[i][k];
+                }
+            }
+
+            // Of the triangles at that vertex, start with the one and the
+            // orientation the strip runs longest from.
+            found = 0;
+            int first = 0;
+            int longest = 0;
+            for(int i = 0; i < window.count; ++i)
+            {
+                const unsigned int* t = window.triangles[i];
+                if(t[0] != corner && t[1] != corner && t[2] != corner)
+                    continue;
+                for(int k = 0; k < 3; ++k)
+                {
+                    int length = window.followStrip(i, t[(k+1)%3], t[(k+2)%3]);
+                    if(length > longest)
+                    {
+                        longest = length;
+                        found = i;
+                        first = k;
+                    }
+                }
+            }
+
+            const unsigned int* t = window.triangles[found];
+            strip.push_back(t[first]);
+            strip.push_back(t[(first+1)%3]);
+            strip.push_back(t[(first+2)%3]);
+            a = t[(first+1)%3];
+            b = t[(first+2)%3];
+            length = 3;
+        }
+
+        const unsigned int* t = window.triangles[found];
+        --valence[t[0]];
+        --valence[t[1]];
+        --valence[t[2]];
+        window.remove(found);
+    }
+}
+
+int TriangleStrips::unstripify(const unsigned int* strip, int numIndices, unsigned int restartIndex,
+                               std::vector<unsigned int>& indices)
+{
+    int numTriangles = 0;
+    unsigned int a = 0;
+    unsigned int b = 0;
+    int length = 0;
+    for(int i = 0; i < numIndices; ++i)
+    {
+        unsigned int v = strip[i];
+        if(v == restartIndex)
+        {
+            length = 0;
+            continue;
+        }
+        if(length >= 2)
+        {
+            indices.push_back((length & 1) ? b : a);
+            indices.push_back((length & 1) ? a : b);
+            indices.push_back(v);
+            ++numTriangles;
+        }
+        a = b;
+        b = v;
+        ++length;
+    }
+    return numTriangles;
+}
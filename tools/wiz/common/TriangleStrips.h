@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _TRIANGLESTRIPS_H_
+#define _TRIANGLESTRIPS_H_
+
+#include <vector>
+
+namespace assembly3d
+{
+    /**
+     * @brief Conversion between triangle lists and triangle strips.
+     *
+     * Strips are separated by a primitive restart index. Triangle k of a
+     * strip is (v[k], v[k+1], v[k+2]) for even k and (v[k+1], v[k], v[k+2])
+     * for odd k, so the winding is kept.
+     */
+    class TriangleStrips
+    {
+    private:
+        TriangleStrips();
+        ~TriangleStrips();
+    public:
+
+        /**
+         * @brief Turns a triangle list into strips.
+         *
+         * Follows the order of the list within a small window, so a list
+         * optimized for the vertex cache gives strips that are as well.
+         * Degenerate triangles are kept.
+         *
+         * @param indices Triangle list.
+         * @param numTriangles Number of triangles.
+         * @param restartIndex Separator between strips, no vertex index.
+         * @param strip Receives the strips.
+         */
+        static void stripify(const unsigned int* indices, int numTriangles, unsigned int restartIndex,
+                             std::vector<unsigned int>& strip);
+        /**
+         * @brief Turns strips into a triangle list.
+         *
+         * @param strip Strips separated by restartIndex.
+         * @param numIndices Number of strip indices.
+         * @param restartIndex Separator between strips.
+         * @param indices The triangles are appended to it.
+         * @return Number of triangles appended.
+         */
+        static int unstripify(const unsigned int* strip, int numIndices, unsigned int restartIndex,
+                              std::vector<unsigned int>& indices);
+    };
+}
+
+#endif  // _TRIANGLESTRIPS_H_
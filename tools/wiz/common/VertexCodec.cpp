@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "VertexCodec.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define A3D_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace assembly3d;
+
+static const unsigned char codecVersion = 1;
+static const int blockVertices = 256;
+static const int groupSize = 16;
+static const int maxVertexSize = 16;
+
+// Packed size of a group of 16 values for each of the four bit widths.
+static const int groupBytes[4] = {0, 4, 8, 16};
+
+static int getGroupWidth(const unsigned char* header, int group)
+{
+    return (header[group >> 2] >> ((group & 3) * 2)) & 3;
+}
+
+static unsigned char* packGroup(const unsigned char* values, int width, unsigned char* data)
+{
+    switch(width)
+    {
+    case 1:
+        for(int i = 0; i < 4; ++i)
+        {
+            const unsigned char* v = values + i*4;
+            data[i] = (unsigned char)((v[0] << 6) | (v[1] << 4) | (v[2] << 2) | v[3]);
+        }
+        break;
+    case 2:
+        for(int i = 0; i < 8; ++i)
+            data[i] = (unsigned char)((values[i*2] << 4) | values[i*2+1]);
+        break;
+    case 3:
+        memcpy(data, values, groupSize);
+        break;
+    }
+    return data + groupBytes[width];
+}
+
+#ifdef A3D_USE_SSE2
+
+static __m128i unpackGroup(const unsigned char* data, int width)
+{
+    switch(width)
+    {
+    case 1:
+    {
+        int packed;
+        memcpy(&packed, data, 4);
+        __m128i sel2 = _mm_cvtsi32_si128(packed);
+        __m128i sel22 = _mm_unpacklo_epi8(_mm_srli_epi16(sel2, 4), sel2);
+        __m128i sel2222 = _mm_unpacklo_epi8(_mm_srli_epi16(sel22, 2), sel22);
+        return _mm_and_si128(sel2222, _mm_set1_epi8(3));
+    }
+    case 2:
+    {
+        __m128i sel4 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+        __m128i sel44 = _mm_unpacklo_epi8(_mm_srli_epi16(sel4, 4), sel4);
+        return _mm_and_si128(sel44, _mm_set1_epi8(15));
+    }
+    case 3:
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    default:
+        return _mm_setzero_si128();
+    }
+}
+
+static const unsigned char* decodePlane(const unsigned char* header, const unsigned char* data,
+                                        int numGroups, unsigned char* plane, unsigned char& last)
+{
+    __m128i previous = _mm_set1_epi8((char)last);
+    for(int g = 0; g < numGroups; ++g)
+    {
+        int width = getGroupWidth(header, g);
+        __m128i zigzag = unpackGroup(data, width);
+        data += groupBytes[width];
+
+        __m128i delta = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(zigzag, 1), _mm_set1_epi8(0x7f)),
+                                      _mm_sub_epi8(_mm_setzero_si128(),
+                                                   _mm_and_si128(zigzag, _mm_set1_epi8(1))));
+
+        // Running sum over the 16 bytes, then add the last value.
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 1));
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 2));
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 4));
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 8));
+        __m128i values = _mm_add_epi8(delta, previous);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(plane + g*groupSize), values);
+
+        __m128i high = _mm_unpackhi_epi8(values, values);
+        previous = _mm_shuffle_epi32(_mm_unpackhi_epi16(high, high), 0xff);
+    }
+    last = (unsigned char)_mm_cvtsi128_si32(previous);
+    return data;
+}
+
+// Interleaves four planes of 16 vertices into 4 bytes per vertex.
+static void transposeGroup(const unsigned char* p0, const unsigned char* p1,
+                           const unsigned char* p2, const unsigned char* p3,
+                           unsigned char* vertices, int stride)
+{
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p2));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p3));
+
+    __m128i ab0 = _mm_unpacklo_epi8(a, b);
+    __m128i ab1 = _mm_unpackhi_epi8(a, b);
+    __m128i cd0 = _mm_unpacklo_epi8(c, d);
+    __m128i cd1 = _mm_unpackhi_epi8(c, d);
+
+    __m128i rows[4];
+    rows[0] = _mm_unpacklo_epi16(ab0, cd0);
+    rows[1] = _mm_unpackhi_epi16(ab0, cd0);
+    rows[2] = _mm_unpacklo_epi16(ab1, cd1);
+    rows[3] = _mm_unpackhi_epi16(ab1, cd1);
+
+    for(int r = 0; r < 4; ++r)
+    {
+        int w0 = _mm_cvtsi128_si32(rows[r]);
+        int w1 = _mm_cvtsi128_si32(_mm_shuffle_epi32(rows[r], 1));
+        int w2 = _mm_cvtsi128_si32(_mm_shuffle_epi32(rows[r], 2));
+        int w3 = _mm_cvtsi128_si32(_mm_shuffle_epi32(rows[r], 3));
+        memcpy(vertices, &w0, 4);
+        memcpy(vertices + stride, &w1, 4);
+        memcpy(vertices + 2*stride, &w2, 4);
+        memcpy(vertices + 3*stride, &w3, 4);
+        vertices += 4*stride;
+    }
+}
+
+#else
+
+static const unsigned char* decodePlane(const unsigned char* header, const unsigned char* data,
+                                        int numGroups, unsigned char* plane, unsigned char& last)
+{
+    unsigned char value = last;
+    for(int g = 0; g < numGroups; ++g)
+    {
+        int width = getGroupWidth(header, g);
+        unsigned char zigzag[groupSize];
+        switch(width)
+        {
+        case 0:
+            memset(zigzag, 0, groupSize);
+            break;
+        case 1:
+            for(int i = 0; i < groupSize; ++i)
+                zigzag[i] = (unsigned char)((data[i >> 2] >> (6 - (i & 3)*2)) & 3);
+            break;
+        case 2:
+            for(int i = 0; i < groupSize; ++i)
+                zigzag[i] = (unsigned char)((data[i >> 1] >> ((i & 1) ? 0 : 4)) & 15);
+            break;
+        case 3:
+            memcpy(zigzag, data, groupSize);
+            break;
+        }
+        data += groupBytes[width];
+
+        for(int i = 0; i < groupSize; ++i)
+        {
+            value = (unsigned char)(value + ((zigzag[i] >> 1) ^ (0u - (zigzag[i] & 1))));
+            plane[g*groupSize + i] = value;
+        }
+    }
+    last = value;
+    return data;
+}
+
+#endif
+
+VertexCodec::VertexCodec()
+{
+}
+
+VertexCodec::~VertexCodec()
+{
+}
+
+void VertexCodec::encode(const unsigned char* vertices, int numVertices, int vertexSize,
+                         std::vector<unsigned char>& buffer)
+{
+    std::vector<unsigned char> data;
+    data.reserve(sizeof(unsigned int) + 1 + (size_t)numVertices*vertexSize);
+    data.resize(sizeof(unsigned int));
+    data.push_back(codecVersion);
+
+    unsigned char last[maxVertexSize] = {0};
+    unsigned char zigzag[blockVertices];
+    unsigned char packed[groupSize];
+
+    for(int base = 0; base < numVertices; base += blockVertices)
+    {
+        const int count = numVertices - base < blockVertices ? numVertices - base : blockVertices;
+        const int numGroups = (count + groupSize - 1) / groupSize;
+
+        for(int k = 0; k < vertexSize; ++k)
+        {
+            for(int i = 0; i < numGroups*groupSize; ++i)
+            {
+                if(i < count)
+                {
+                    unsigned char v = vertices[(size_t)(base + i)*vertexSize + k];
+                    signed char delta = (signed char)(unsigned char)(v - last[k]);
+                    zigzag[i] = (unsigned char)(((unsigned char)delta << 1) ^ (delta >> 7));
+                    last[k] = v;
+                }
+                else
+                {
+                    zigzag[i] = 0;
+                }
+            }
+
+            size_t header = data.size();
+            data.resize(header + (numGroups + 3) / 4, 0);
+            for(int g = 0; g < numGroups; ++g)
+            {
+                unsigned char maxValue = 0;
+                for(int i = 0; i < groupSize; ++i)
+                {
+                    if(zigzag[g*groupSize + i] > maxValue)
+                        maxValue = zigzag[g*groupSize + i];
+                }
+                int width = maxValue == 0 ? 0 : maxValue < 4 ? 1 : maxValue < 16 ? 2 : 3;
+                data[header + (g >> 2)] |= (unsigned char)(width << ((g & 3) * 2));
+
+                unsigned char* end = packGroup(&zigzag[g*groupSize], width, packed);
+                data.insert(data.end(), packed, end);
+            }
+        }
+    }
+
+    unsigned int size = static_cast<unsigned int>(data.size() - sizeof(unsigned int));
+    memcpy(&data[0], &size, sizeof(unsigned int));
+    buffer.swap(data);
+}
+
+bool VertexCodec::decode(const unsigned char* buffer, size_t size, unsigned char* vertices,
+                         int numVertices, int vertexSize, int stride)
+{
+    if(vertexSize < 1 || vertexSize > maxVertexSize || numVertices < 0 ||
+       size < 1 || buffer[0] != codecVersion)
+        return false;
+
+    const unsigned char* data = buffer + 1;
+    const unsigned char* end = buffer + size;
+
+    unsigned char last[maxVertexSize] = {0};
+    unsigned char planes[maxVertexSize][blockVertices];
+
+    for(int base = 0; base < numVertices; base += blockVertices)
+    {
+        const int count = numVertices - base < blockVertices ? numVertices - base : blockVertices;
+        const int numGroups = (count + groupSize - 1) / groupSize;
+        const int headerSize = (numGroups + 3) / 4;
+
+        for(int k = 0; k < vertexSize; ++k)
+        {
+            if(end - data < headerSize)
+                return false;
+            const unsigned char* header = data;
+            data += headerSize;
+
+            ptrdiff_t planeSize = 0;
+            for(int g = 0; g < numGroups; ++g)
+                planeSize += groupBytes[getGroupWidth(header, g)];
+            if(end - data < planeSize)
+                return false;
+
+            data = decodePlane(header, data, numGroups, planes[k], last[k]);
+        }
+
+        unsigned char* dst = vertices + (size_t)base*stride;
+        int k = 0;
+#ifdef A3D_USE_SSE2
+        const int numFullGroups = count / groupSize;
+        for(; k + 4 <= vertexSize; k += 4)
+        {
+            for(int g = 0; g < numFullGroups; ++g)
+            {
+                int i = g*groupSize;
+                transposeGroup(&planes[k][i], &planes[k+1][i], &planes[k+2][i], &planes[k+3][i],
+                               dst + (size_t)i*stride + k, stride);
+            }
+            for(int i = numFullGroups*groupSize; i < count; ++i)
+            {
+                for(int j = k; j < k + 4; ++j)
+                    dst[(size_t)i*stride + j] = planes[j][i];
+            }
+        }
+#endif
+        for(; k < vertexSize; ++k)
+        {
+            for(int i = 0; i < count; ++i)
+                dst[(size_t)i*stride + k] = planes[k][i];
+        }
+    }
+
+    return data == end;
+}
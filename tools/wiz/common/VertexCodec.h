@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _VERTEXCODEC_H_
+#define _VERTEXCODEC_H_
+
+#include <vector>
+#include <cstddef>
+
+namespace assembly3d
+{
+    /**
+     * @brief Compression of vertex attribute streams.
+     *
+     * Vertices are handled in blocks of 256. Each byte of a vertex is
+     * replaced by its difference to the same byte of the previous vertex,
+     * and the differences are stored byte plane by byte plane. Every 16
+     * values of a plane are packed with 0, 2, 4 or 8 bits, told by a 2 bit
+     * header per 16 values. Ordering the vertices by first use and
+     * quantizing them first makes the differences small.
+     *
+     * The block starts with its size in bytes (UNSIGNED_INT, not counted)
+     * and a version byte.
+     */
+    class VertexCodec
+    {
+    private:
+        VertexCodec();
+        ~VertexCodec();
+    public:
+
+        /**
+         * @brief Encodes vertices.
+         *
+         * @param vertices Packed vertices.
+         * @param numVertices Number of vertices.
+         * @param vertexSize Number of bytes per vertex, 1 to 16.
+         * @param buffer Receives the block, size included.
+         */
+        static void encode(const unsigned char* vertices, int numVertices, int vertexSize,
+                           std::vector<unsigned char>& buffer);
+        /**
+         * @brief Decodes vertices.
+         *
+         * Writes vertexSize bytes per vertex and leaves the rest of the
+         * stride untouched, so float attributes can be decoded straight
+         * into the stride-4 mesh buffers.
+         *
+         * @param buffer Block as written by encode(), without its size.
+         * @param size Size of the block.
+         * @param vertices Receives the vertices.
+         * @param numVertices Number of vertices.
+         * @param vertexSize Number of bytes per vertex, 1 to 16.
+         * @param stride Number of bytes from one vertex to the next.
+         * @return False if the block is malformed.
+         */
+        static bool decode(const unsigned char* buffer, size_t size, unsigned char* vertices,
+                           int numVertices, int vertexSize, int stride);
+    };
+}
+
+#endif  // _VERTEXCODEC_H_
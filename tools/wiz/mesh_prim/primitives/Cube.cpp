@@ -231,7 +231,7 @@ void Cube::create(Mesh* mesh, bool positions, bool normals,
         mesh->addIndex(cube_indices[i]);
     }
     mesh->setNumTriangles(numTriangles);
-    Mesh::Group g = {(char*)"Cube", 0, numTriangles};
+    Mesh::Group g = {(char*)"Cube", 0, numTriangles, Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 }
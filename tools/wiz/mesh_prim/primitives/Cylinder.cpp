@@ -162,7 +162,7 @@ void Cylinder::create(Mesh* mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"Cylinder", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"Cylinder", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 }
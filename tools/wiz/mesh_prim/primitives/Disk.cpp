@@ -137,7 +137,7 @@ void Disk::create(Mesh* mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"Disk", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"Disk", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 
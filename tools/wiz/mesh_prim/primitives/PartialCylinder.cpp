@@ -166,7 +166,7 @@ void PartialCylinder::create(Mesh* mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"PartialCylinder", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"PartialCylinder", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 }
@@ -137,7 +137,7 @@ void PartialDisk::create(Mesh* mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"PartialDisk", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"PartialDisk", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 
@@ -154,6 +154,6 @@ void Plane::create(Mesh* mesh, bool positions, bool normals,
         mesh->addIndex(xy_indices[i]);
     }
     mesh->setNumTriangles(numTriangles);
-    Mesh::Group g = {(char*)"xy_plane", 0, 2};
+    Mesh::Group g = {(char*)"xy_plane", 0, 2, Mesh::TRIANGLES};
     mesh->addGroup(g);
 }
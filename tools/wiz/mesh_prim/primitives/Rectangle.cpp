@@ -133,7 +133,7 @@ void Rectangle::create(Mesh *mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"Rectangle", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"Rectangle", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 
@@ -139,7 +139,7 @@ void Sphere::create(Mesh* mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"Sphere", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"Sphere", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 }
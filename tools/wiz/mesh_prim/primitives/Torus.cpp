@@ -154,7 +154,7 @@ void Torus::create(Mesh* mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"Torus", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"Torus", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 }
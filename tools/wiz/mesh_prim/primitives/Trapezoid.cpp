@@ -136,7 +136,7 @@ void Trapezoid::create(Mesh* mesh, bool positions, bool normals,
 
     generateIndices(mesh);
 
-    Mesh::Group g = {(char*)"Trapezoid", 0, numberOfTriangles()};
+    Mesh::Group g = {(char*)"Trapezoid", 0, numberOfTriangles(), Mesh::TRIANGLES};
     mesh->addGroup(g);
 
 }
@@ -33,15 +33,31 @@
 
 #include "MeshWizIncludes.h"
 #include "BakeTool.h"
-#include "KDTree.h"
 #include <cmath>
-
-#define DOT2(v1,v2) (v1[0]*v2[0]+v1[1]*v2[1])
-#define DOT3(v1,v2) (v1[0]*v2[0]+v1[1]*v2[1]+v1[2]*v2[2])
+#include <algorithm>
+#include <limits>
 
 using namespace assembly3d;
 using namespace assembly3d::wiz;
 
+namespace
+{
+    // Orders triangles by the center of their bounding box on one axis.
+    struct CenterLess
+    {
+        CenterLess(const std::vector<float>& centers, int axis)
+            : m_centers(&centers[0]), m_axis(axis)
+        {
+        }
+        bool operator()(int lhs, int rhs) const
+        {
+            return m_centers[lhs*2 + m_axis] < m_centers[rhs*2 + m_axis];
+        }
+        const float* m_centers;
+        int m_axis;
+    };
+}
+
 BakeTool::BakeTool()
 {
 }
@@ -67,130 +83,191 @@ int BakeTool::isInBounds(Mesh::Attribute* texCoords, int numVertices)
 
 int BakeTool::checkUVOverlapping(Mesh *mesh)
 {
+    if(mesh->hasTexCoords() == false)
+        return 0;
+
+    // Degenerate triangles have no area to overlap with and are left out.
+    std::vector<UVTriangle> triangles;
+    triangles.reserve(mesh->getNumberOfTriangles());
+    for(int i = 0; i < mesh->getNumberOfTriangles(); ++i)
+    {
+        const unsigned int* triangle = mesh->getTriangle(i);
+
+        UVTriangle uvTriangle;
+        for(int k = 0; k < 3; ++k)
+        {
+            const float* pTexCoord = mesh->getTexCoord(triangle[k]);
+            uvTriangle.corners[k][0] = pTexCoord[0];
+            uvTriangle.corners[k][1] = pTexCoord[1];
+        }
+
+        const double (*c)[2] = uvTriangle.corners;
+        double area = (c[1][0]-c[0][0])*(c[2][1]-c[0][1]) - (c[1][1]-c[0][1])*(c[2][0]-c[0][0]);
+        if(!(area > 0.0 || area < 0.0))
+            continue;
+
+        for(int axis = 0; axis < 2; ++axis)
+        {
+            uvTriangle.min[axis] = static_cast<float>(std::min(c[0][axis], std::min(c[1][axis], c[2][axis])));
+            uvTriangle.max[axis] = static_cast<float>(std::max(c[0][axis], std::max(c[1][axis], c[2][axis])));
+        }
+        triangles.push_back(uvTriangle);
+    }
+    if(triangles.size() < 2)
+        return 0;
+
+    std::vector<float> centers(triangles.size()*2);
+    std::vector<int> order(triangles.size());
+    for(size_t i = 0; i < order.size(); ++i)
+    {
+        centers[i*2+0] = triangles[i].min[0] + triangles[i].max[0];
+        centers[i*2+1] = triangles[i].min[1] + triangles[i].max[1];
+        order[i] = static_cast<int>(i);
+    }
+
+    std::vector<BoxNode> nodes;
+    nodes.reserve(triangles.size());
+    buildBoxTree(nodes, order, triangles, centers, 0, static_cast<int>(order.size()));
+
+    // Every triangle looks for overlaps with higher indices only, so each
+    // pair is counted once and the queries are independent.
     int numOverlaps = 0;
+    const int numTriangles = static_cast<int>(triangles.size());
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:numOverlaps) schedule(dynamic, 1024)
+#endif
+    for(int i = 0; i < numTriangles; ++i)
+    {
+        numOverlaps += countOverlaps(nodes, order, triangles, i);
+    }
 
-    Mesh* meshCopy = new Mesh(*mesh);
+    return numOverlaps;
+}
 
-    for(int i = 0; i < meshCopy->getNumberOfTriangles(); ++i)
+int BakeTool::buildBoxTree(std::vector<BoxNode>& nodes, std::vector<int>& order,
+                           const std::vector<UVTriangle>& triangles,
+                           const std::vector<float>& centers, int begin, int end)
+{
+    static const int maxLeafSize = 4;
+
+    int index = static_cast<int>(nodes.size());
+    nodes.push_back(BoxNode());
+
+    BoxNode node;
+    node.min[0] = node.min[1] = std::numeric_limits<float>::max();
+    node.max[0] = node.max[1] = -std::numeric_limits<float>::max();
+    node.right = -1;
+    node.first = begin;
+    node.count = end - begin;
+    for(int i = begin; i < end; ++i)
     {
-        const unsigned int* triangle = meshCopy->getTriangle(i);
-
-        float* pTexCoord00 = meshCopy->getTexCoord(triangle[0]);
-        float* pTexCoord01 = meshCopy->getTexCoord(triangle[1]);
-        float* pTexCoord02 = meshCopy->getTexCoord(triangle[2]);
-
-        if(pTexCoord00[0] > 1.0f || pTexCoord00[0] < 0.0f ||
-           pTexCoord00[1] > 1.0f || pTexCoord00[1] < 0.0f ||
-           pTexCoord01[0] > 1.0f || pTexCoord01[0] < 0.0f ||
-           pTexCoord01[1] > 1.0f || pTexCoord01[1] < 0.0f ||
-           pTexCoord02[0] > 1.0f || pTexCoord02[0] < 0.0f ||
-           pTexCoord02[1] > 1.0f || pTexCoord02[1] < 0.0f)
+        const UVTriangle& triangle = triangles[order[i]];
+        for(int axis = 0; axis < 2; ++axis)
         {
-            float tmpTexCoord00[2] = {0.0f, 0.0f};
-            float tmpTexCoord01[2] = {0.0f, 0.0f};
-            float tmpTexCoord02[2] = {0.0f, 0.0f};
-            tmpTexCoord00[0] = fmodf(pTexCoord00[0], 1.0f);
-            tmpTexCoord00[1] = fmodf(pTexCoord00[1], 1.0f);
-            tmpTexCoord01[0] = fmodf(pTexCoord01[0], 1.0f);
-            tmpTexCoord01[1] = fmodf(pTexCoord01[1], 1.0f);
-            tmpTexCoord02[0] = fmodf(pTexCoord02[0], 1.0f);
-            tmpTexCoord02[1] = fmodf(pTexCoord02[1], 1.0f);
-            int numberFoTexCoords = meshCopy->getNumberOfVertices();
-            meshCopy->addTexCoord(tmpTexCoord00);
-            meshCopy->addTexCoord(tmpTexCoord01);
-            meshCopy->addTexCoord(tmpTexCoord02);
-            meshCopy->addIndex(numberFoTexCoords);
-            meshCopy->addIndex(numberFoTexCoords+1);
-            meshCopy->addIndex(numberFoTexCoords+2);
+            node.min[axis] = std::min(node.min[axis], triangle.min[axis]);
+            node.max[axis] = std::max(node.max[axis], triangle.max[axis]);
         }
     }
 
-    std::vector<Point> points;
-    generatePoints(meshCopy, points);
+    if(end - begin > maxLeafSize)
+    {
+        // Median split of the box centers along the longer side.
+        const int axis = (node.max[0]-node.min[0]) >= (node.max[1]-node.min[1]) ? 0 : 1;
+        const int middle = begin + (end - begin) / 2;
+        std::vector<int>::iterator first = order.begin();
+        std::nth_element(first + begin, first + middle, first + end,
+                         CenterLess(centers, axis));
 
-    KDTree<> kdtree;
-    kdtree.generate(points);
+        node.count = 0;
+        buildBoxTree(nodes, order, triangles, centers, begin, middle);
+        node.right = buildBoxTree(nodes, order, triangles, centers, middle, end);
+    }
+    nodes[index] = node;
+
+    return index;
+}
 
-    for(int i = 0; i < meshCopy->getNumberOfTriangles(); ++i)
+int BakeTool::countOverlaps(const std::vector<BoxNode>& nodes,
+                            const std::vector<int>& order,
+                            const std::vector<UVTriangle>& triangles,
+                            int index)
+{
+    const UVTriangle& triangle = triangles[index];
+
+    int numOverlaps = 0;
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while(stackSize > 0)
     {
-        float* pTexCoord00 = meshCopy->getTexCoord(points[i].triangle[0]);
-        float* pTexCoord01 = meshCopy->getTexCoord(points[i].triangle[1]);
-        float* pTexCoord02 = meshCopy->getTexCoord(points[i].triangle[2]);
+        const BoxNode& node = nodes[stack[--stackSize]];
 
-        std::vector<int> indices;
-        int numFound = kdtree.nearestQuery(points[i], 100, indices);
-        for(int j = 0; j < numFound; ++j)
+        // Boxes that only touch cannot hold overlapping triangles.
+        if(node.min[0] >= triangle.max[0] || node.max[0] <= triangle.min[0] ||
+           node.min[1] >= triangle.max[1] || node.max[1] <= triangle.min[1])
         {
+            continue;
+        }
 
-            for(unsigned int k = 0; k < 3; ++k)
+        if(node.count > 0)
+        {
+            for(int i = node.first; i < node.first + node.count; ++i)
             {
-                float* pTexCoord2 = meshCopy->getTexCoord(points[indices[j]].triangle[k]);
-                if(checkPointInTri(pTexCoord2, pTexCoord00, pTexCoord01, pTexCoord02))
+                const int other = order[i];
+                if(other <= index)
+                    continue;
+
+                const UVTriangle& otherTriangle = triangles[other];
+                if(otherTriangle.min[0] >= triangle.max[0] || otherTriangle.max[0] <= triangle.min[0] ||
+                   otherTriangle.min[1] >= triangle.max[1] || otherTriangle.max[1] <= triangle.min[1])
                 {
-                    numOverlaps++;
-                    break;
+                    continue;
                 }
+                if(trianglesOverlap(triangle, otherTriangle))
+                    ++numOverlaps;
             }
         }
+        else
+        {
+            // Median splits keep the depth far below the stack size.
+            stack[stackSize++] = node.right;
+            stack[stackSize++] = static_cast<int>(&node - &nodes[0]) + 1;
+        }
     }
-    SAFE_DELETE(meshCopy);
-
     return numOverlaps;
 }
 
-bool BakeTool::checkPointInTri(float* p, float* a, float* b, float* c)
+bool BakeTool::trianglesOverlap(const UVTriangle& lhs, const UVTriangle& rhs)
 {
-    // http://www.blackpawn.com/texts/pointinpoly/default.html
-
-    float v0[2] = {0.0f,0.0f};
-    float v1[2] = {0.0f,0.0f};
-    float v2[2] = {0.0f,0.0f};
-
-    // Compute vectors
-    v0[0] = c[0] - a[0];
-    v0[1] = c[1] - a[1];
-    v1[0] = b[0] - a[0];
-    v1[1] = b[1] - a[1];
-    v2[0] = p[0] - a[0];
-    v2[1] = p[1] - a[1];
-
-    // Compute dot products
-    float dot00 = DOT2(v0, v0);
-    float dot01 = DOT2(v0, v1);
-    float dot02 = DOT2(v0, v2);
-    float dot11 = DOT2(v1, v1);
-    float dot12 = DOT2(v1, v2);
-
-    // Compute barycentric coordinates
-    float invDenom = 1.0f / (dot00 * dot11 - dot01 * dot01);
-    float u = (dot11 * dot02 - dot01 * dot12) * invDenom;
-    float v = (dot00 * dot12 - dot01 * dot02) * invDenom;
-
-    // Check if point is in triangle
-    if((u > 0) && (v > 0) && (u + v < 1))
-        return true;
-    else
-        return false;
+    // Separating axis test, the edge normals of both triangles are the
+    // only candidates in 2D.
+    return isSeparatedByEdge(lhs, rhs) == false &&
+           isSeparatedByEdge(rhs, lhs) == false;
 }
 
-void BakeTool::generatePoints(assembly3d::Mesh *mesh, std::vector<Point>& points)
+bool BakeTool::isSeparatedByEdge(const UVTriangle& lhs, const UVTriangle& rhs)
 {
-    points.clear();
-    for(int i = 0; i < mesh->getNumberOfTriangles(); ++i)
+    for(int i = 0; i < 3; ++i)
     {
-        const unsigned int* triangle = mesh->getTriangle(i);
-        float* pTexCoord0 = mesh->getTexCoord(triangle[0]);
-        float* pTexCoord1 = mesh->getTexCoord(triangle[1]);
-        float* pTexCoord2 = mesh->getTexCoord(triangle[2]);
-
-        float centerX = (pTexCoord0[0] + pTexCoord1[0] + pTexCoord2[0]) / 3;
-        float centerY = (pTexCoord0[1] + pTexCoord1[1] + pTexCoord2[1]) / 3;
-        Point center(centerX, centerY, 0.0f);
-        center.triangle[0] = triangle[0];
-        center.triangle[1] = triangle[1];
-        center.triangle[2] = triangle[2];
-
-        points.push_back(center);
-    }
+        const double* a = lhs.corners[i];
+        const double* b = lhs.corners[(i+1)%3];
+        const double* c = lhs.corners[(i+2)%3];
+        const double edge[2] = {b[0] - a[0], b[1] - a[1]};
+
+        // Side of the edge the triangle lies on.
+        const double inside = edge[0]*(c[1] - a[1]) - edge[1]*(c[0] - a[0]);
 
+        bool separated = true;
+        for(int k = 0; k < 3 && separated; ++k)
+        {
+            const double* p = rhs.corners[k];
+            double side = edge[0]*(p[1] - a[1]) - edge[1]*(p[0] - a[0]);
+            if(inside < 0.0)
+                side = -side;
+            separated = side <= 0.0;
+        }
+        if(separated)
+            return true;
+    }
+    return false;
 }
@@ -35,10 +35,10 @@
 #define BAKETOOL_H
 
 #include "Mesh.h"
+#include <vector>
 
 namespace assembly3d
 {
-    class Point;
     namespace wiz
     {
 
@@ -49,10 +49,49 @@ namespace assembly3d
 
             int isInBounds(Mesh::Attribute* texCoords, int numVertices);
 
+            /**
+             * @brief Counts the pairs of triangles overlapping in texture space.
+             *
+             * Triangles sharing an edge or a vertex only touch and are not
+             * counted, neither are degenerate triangles.
+             *
+             * @param mesh The mesh to check.
+             * @return Number of overlapping triangle pairs.
+             */
             int checkUVOverlapping(Mesh* mesh);
         private:
-            bool checkPointInTri(float* p, float* a, float* b, float* c);
-            void generatePoints(Mesh* mesh, std::vector<Point>& points);
+            /**
+             * @brief Node of the bounding volume hierarchy over UV triangles.
+             *
+             * Inner nodes have their left child directly behind them.
+             */
+            struct BoxNode
+            {
+                float min[2];
+                float max[2];
+                int right;
+                int first;
+                int count;
+            };
+            /**
+             * @brief Texture space triangle and its bounding box.
+             */
+            struct UVTriangle
+            {
+                double corners[3][2];
+                float min[2];
+                float max[2];
+            };
+
+            int buildBoxTree(std::vector<BoxNode>& nodes, std::vector<int>& order,
+                             const std::vector<UVTriangle>& triangles,
+                             const std::vector<float>& centers, int begin, int end);
+            int countOverlaps(const std::vector<BoxNode>& nodes,
+                              const std::vector<int>& order,
+                              const std::vector<UVTriangle>& triangles,
+                              int index);
+            bool trianglesOverlap(const UVTriangle& lhs, const UVTriangle& rhs);
+            bool isSeparatedByEdge(const UVTriangle& lhs, const UVTriangle& rhs);
         };
     }
 }
@@ -60,3 +60,31 @@ void ConvertTool::convertIndicesToUnsignedByte(Mesh* m)
 {
     m->setIndexFormat("UNSIGNED_BYTE");
 }
+
+void ConvertTool::convertIndicesToEncoded(Mesh* m)
+{
+    m->setIndexFormat("ENCODED");
+}
+
+void ConvertTool::convertPrimitivesToTriangles(Mesh* m)
+{
+    for(int i = 0; i < m->getNumberOfGroups(); ++i)
+        m->getGroup(i).primitiveType = Mesh::TRIANGLES;
+}
+
+void ConvertTool::convertPrimitivesToTriangleStrips(Mesh* m)
+{
+    for(int i = 0; i < m->getNumberOfGroups(); ++i)
+        m->getGroup(i).primitiveType = Mesh::TRIANGLE_STRIP;
+}
+
+bool ConvertTool::setCompressedAttributes(Mesh* m, const std::vector<std::string>& names)
+{
+    for(size_t i = 0; i < names.size(); ++i)
+    {
+        if(m->getAttributeIndexWithName(names[i].c_str()) < 0)
+            return false;
+    }
+    m->getMeshFormat().compressedAttributes = names;
+    return true;
+}
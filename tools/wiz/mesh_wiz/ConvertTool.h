@@ -68,6 +68,32 @@ namespace assembly3d
              * @param m The mesh to work on.
              */
             void convertIndicesToUnsignedByte(Mesh* m);
+            /**
+             * @brief Changes index type to "ENCODED".
+             *
+             * @param m The mesh to work on.
+             */
+            void convertIndicesToEncoded(Mesh* m);
+            /**
+             * @brief Stores all groups as triangle lists.
+             *
+             * @param m The mesh to work on.
+             */
+            void convertPrimitivesToTriangles(Mesh* m);
+            /**
+             * @brief Stores all groups as triangle strips with restart indices.
+             *
+             * @param m The mesh to work on.
+             */
+            void convertPrimitivesToTriangleStrips(Mesh* m);
+            /**
+             * @brief Sets the vertex attributes stored compressed.
+             *
+             * @param m The mesh to work on.
+             * @param names Attribute names, none if empty.
+             * @return False if the mesh lacks one of the attributes.
+             */
+            bool setCompressedAttributes(Mesh* m, const std::vector<std::string>& names);
 
         };
     }
@@ -35,13 +35,86 @@
 #include "FrontFaceTool.h"
 #include <cmath>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 #include "TransformTool.h"
 
-#define PIf		3.1415926535897932384626433832795f
-
 using namespace assembly3d;
 using namespace assembly3d::wiz;
 
+namespace
+{
+    // FNV-1a over the bit patterns of a position, -0.0f hashed as 0.0f.
+    unsigned int hashPosition(const float* position)
+    {
+        unsigned int hash = 2166136261u;
+        for(int j = 0; j < 3; ++j)
+        {
+            float value = position[j];
+            if(value == 0.0f)
+                value = 0.0f;
+
+            unsigned int bits = 0;
+            memcpy(&bits, &value, sizeof(bits));
+
+            hash ^= bits;
+            hash *= 16777619u;
+        }
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    bool positionEquals(const float* lhs, const float* rhs)
+    {
+        return lhs[0] == rhs[0] && lhs[1] == rhs[1] && lhs[2] == rhs[2];
+    }
+
+    /**
+     * @brief Maps every index to the first vertex with the same position.
+     *
+     * @return Number of distinct positions.
+     */
+    int weldPositions(Mesh* mesh, const unsigned int* indices, int numIndices,
+                      std::vector<unsigned int>& welded)
+    {
+        const unsigned int numVertices = static_cast<unsigned int>(mesh->getNumberOfVertices());
+
+        // Open addressing table holding welded ids, at most half full.
+        unsigned int tableSize = 16;
+        while(tableSize < numVertices*2)
+            tableSize <<= 1;
+        std::vector<int> table(tableSize, -1);
+
+        std::vector<int> vertexToWelded(numVertices, -1);
+        std::vector<unsigned int> weldedToVertex;
+        welded.resize(numIndices);
+        for(int i = 0; i < numIndices; ++i)
+        {
+            unsigned int vertex = indices[i];
+            int id = vertexToWelded[vertex];
+            if(id < 0)
+            {
+                const float* position = mesh->getPosition(vertex);
+                unsigned int slot = hashPosition(position) & (tableSize-1);
+                while(table[slot] >= 0 &&
+                      positionEquals(mesh->getPosition(weldedToVertex[table[slot]]), position) == false)
+                {
+                    slot = (slot+1) & (tableSize-1);
+                }
+                if(table[slot] < 0)
+                {
+                    table[slot] = static_cast<int>(weldedToVertex.size());
+                    weldedToVertex.push_back(vertex);
+                }
+                id = table[slot];
+                vertexToWelded[vertex] = id;
+            }
+            welded[i] = static_cast<unsigned int>(id);
+        }
+        return static_cast<int>(weldedToVertex.size());
+    }
+}
+
 FrontFaceTool::FrontFaceTool()
 {
 }
@@ -62,6 +135,7 @@ void FrontFaceTool::flip(Mesh* mesh)
         pTriangle[1] = idx2;
         pTriangle[2] = idx1;
     }
+    mesh->invalidateAdjacency();
 
     int numVertices = mesh->getNumberOfVertices();
     for(int i = 0; i < numVertices; ++i)
@@ -145,9 +219,8 @@ bool FrontFaceTool::isConsistent(Mesh *mesh, std::vector<int>& verticesOutwards,
                              normal[1]*pNormal2[1] +
                              normal[2]*pNormal2[2];
 
-        float angle = (float)acos(std::min(dotVec1Vec2, 1.0f));
-
-        if(angle <= (PIf / 2))
+        // Same as an angle of at most PI/2, without the acos.
+        if(dotVec1Vec2 >= 0.0f)
         {
             verticesOutwards.push_back(i);
         }
@@ -177,4 +250,141 @@ void FrontFaceTool::changeWinding(Mesh* mesh)
         pTriangle[1] = idx2;
         pTriangle[2] = idx1;
     }
+    mesh->invalidateAdjacency();
+}
+
+bool FrontFaceTool::orientTriangles(Mesh* mesh, std::string& resultMsg)
+{
+    const int numTriangles = mesh->getNumberOfTriangles();
+    if(numTriangles == 0)
+    {
+        resultMsg = "No triangles to orient.";
+        return false;
+    }
+    const unsigned int* indices = mesh->getIndicesPointer();
+
+    // UV and normal seams duplicate vertices, so the edges are built on
+    // welded positions. Otherwise a seam would cut a closed surface into
+    // open components and the volume test would never run.
+    std::vector<unsigned int> welded;
+    int numWelded = weldPositions(mesh, indices, numTriangles*3, welded);
+    MeshAdjacency adjacency;
+    adjacency.build(&welded[0], numTriangles, numWelded);
+
+    // flip[t] tells if triangle t has to be flipped to match the first
+    // triangle of its component.
+    std::vector<int> component(numTriangles, -1);
+    std::vector<char> flip(numTriangles, 0);
+    std::vector<int> queue;
+    queue.reserve(numTriangles);
+
+    int numComponents = 0;
+    int numConflicts = 0;
+    int numFlipped = 0;
+
+    for(int seed = 0; seed < numTriangles; ++seed)
+    {
+        if(component[seed] >= 0)
+            continue;
+
+        queue.clear();
+        queue.push_back(seed);
+        component[seed] = numComponents;
+
+        bool closed = true;
+        for(size_t head = 0; head < queue.size(); ++head)
+        {
+            int t = queue[head];
+            for(int k = 0; k < 3; ++k)
+            {
+                unsigned int halfEdge = t*3 + k;
+                int edge = adjacency.getEdge(halfEdge);
+                if(adjacency.getEdgeHalfEdgeCount(edge) == 1)
+                    closed = false;
+
+                int opposite = adjacency.getOppositeHalfEdge(halfEdge);
+                if(opposite < 0)
+                    continue;
+
+                unsigned int v0, v1;
+                adjacency.getEdgeVertices(edge, v0, v1);
+                if(v0 == v1)
+                    continue;
+
+                // Both half-edges starting at the same vertex means both
+                // triangles run the edge in the same direction.
+                int u = opposite / 3;
+                char sameDirection = welded[halfEdge] == welded[opposite] ? 1 : 0;
+                char uFlip = flip[t] ^ sameDirection;
+                if(component[u] < 0)
+                {
+                    component[u] = numComponents;
+                    flip[u] = uFlip;
+                    queue.push_back(u);
+                }
+                else if(flip[u] != uFlip)
+                {
+                    ++numConflicts;
+                }
+            }
+        }
+
+        // Choose the outside of the component.
+        int numMarked = 0;
+        for(size_t i = 0; i < queue.size(); ++i)
+            numMarked += flip[queue[i]];
+
+        bool invert = false;
+        if(closed)
+        {
+            double volume = 0.0;
+            for(size_t i = 0; i < queue.size(); ++i)
+            {
+                int t = queue[i];
+                const float* p0 = mesh->getPosition(indices[t*3+0]);
+                const float* p1 = mesh->getPosition(indices[t*3+1]);
+                const float* p2 = mesh->getPosition(indices[t*3+2]);
+                double det = p0[0] * ((double)p1[1]*p2[2] - (double)p1[2]*p2[1]) +
+                             p0[1] * ((double)p1[2]*p2[0] - (double)p1[0]*p2[2]) +
+                             p0[2] * ((double)p1[0]*p2[1] - (double)p1[1]*p2[0]);
+                volume += flip[t] ? -det : det;
+            }
+            invert = volume < 0.0 || (volume == 0.0 && 2*numMarked > (int)queue.size());
+        }
+        else
+        {
+            invert = 2*numMarked > (int)queue.size();
+        }
+
+        for(size_t i = 0; i < queue.size(); ++i)
+        {
+            int t = queue[i];
+            flip[t] ^= invert ? 1 : 0;
+            numFlipped += flip[t];
+        }
+
+        ++numComponents;
+    }
+
+    for(int t = 0; t < numTriangles; ++t)
+    {
+        if(flip[t])
+        {
+            unsigned int* pTriangle = mesh->getTriangle(t);
+            std::swap(pTriangle[1], pTriangle[2]);
+        }
+    }
+    if(numFlipped > 0)
+        mesh->invalidateAdjacency();
+
+    std::stringstream strStr;
+    strStr << numComponents << " connected components.\n";
+    strStr << "Flipped " << numFlipped << " triangles.";
+    // Every conflicting edge is seen from both of its triangles.
+    numConflicts /= 2;
+    if(numConflicts > 0)
+        strStr << "\n" << numConflicts << " edges could not be oriented consistently (non-orientable surface).";
+    resultMsg = strStr.str();
+
+    return numFlipped > 0;
 }
@@ -69,6 +69,22 @@ namespace assembly3d
 			
 			void changeWinding(Mesh* mesh);
 
+            /**
+             * @brief Makes the triangle winding consistent over shared edges.
+             *
+             * Every connected component is traversed breadth-first over
+             * its manifold edges and neighbouring triangles are flipped
+             * to traverse the shared edge in opposite directions. Closed
+             * components are then turned outwards by the sign of their
+             * volume, open ones keep the winding most of their triangles
+             * already had. Normals are left untouched.
+             *
+             * @param mesh The mesh to work on.
+             * @param resultMsg Veriable to write status message in
+             * @return True if triangles have been flipped.
+             */
+            bool orientTriangles(Mesh* mesh, std::string& resultMsg);
+
         };
     }
 }
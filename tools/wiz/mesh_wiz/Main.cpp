@@ -34,6 +34,7 @@
 #include "MeshWizIncludes.h"
 #include "A3DUtils.h"
 #include <tclap/CmdLine.h>
+#include <sstream>
 #include "Mesh.h"
 #include "MeshIO.h"
 #include "ToolManager.h"
@@ -96,6 +97,9 @@ int main (int argc, char* argv[])
 											 "Applies transformation only to texture coordinates.");
 		
 		TCLAP::SwitchArg centerAllArg("", "center-all", "Centers mesh to all axes.", false);
+		TCLAP::SwitchArg transformStackArg("", "transform-stack",
+										   "Composes all transformations into one matrix and applies it in one pass.",
+										   false);
 		
 		TCLAP::ValueArg<std::string> axesArg("", "axes", "Remaps main axes.", false, "", "x/y/z");
 		
@@ -106,12 +110,32 @@ int main (int argc, char* argv[])
 		conversionIndexTypeToAllowed.push_back("int");
 		conversionIndexTypeToAllowed.push_back("short");
 		conversionIndexTypeToAllowed.push_back("byte");
+		conversionIndexTypeToAllowed.push_back("encoded");
 		TCLAP::ValuesConstraint<std::string> conversionIndexTypeToAllowedVals( conversionIndexTypeToAllowed );
 		TCLAP::ValueArg<std::string> convertIndexTypeToArg("", "convert-index-type-to",
 														   "Converts index type between UNSIGNED_INT , "\
-														   "UNSIGNED_SHORT and UNSIGNED_BYTE.",
+														   "UNSIGNED_SHORT, UNSIGNED_BYTE and ENCODED, a compressed "\
+														   "index stream. Run --optimize-indices and --optimize-vertices "\
+														   "for the best compression.",
 														   false, "", &conversionIndexTypeToAllowedVals);
 				
+		std::vector<std::string> conversionPrimitiveTypeToAllowed;
+		conversionPrimitiveTypeToAllowed.push_back("triangles");
+		conversionPrimitiveTypeToAllowed.push_back("strips");
+		TCLAP::ValuesConstraint<std::string> conversionPrimitiveTypeToAllowedVals( conversionPrimitiveTypeToAllowed );
+		TCLAP::ValueArg<std::string> convertPrimitiveTypeToArg("", "convert-primitive-type-to",
+															   "Stores the groups as triangle lists or as triangle "\
+															   "strips separated by primitive restart indices (the "\
+															   "largest value of the index type). Run --optimize-indices "\
+															   "first for long strips.",
+															   false, "", &conversionPrimitiveTypeToAllowedVals);
+		
+		TCLAP::ValueArg<std::string> compressAttributesArg("", "compress-attributes",
+														   "Stores the given vertex attributes, all or none of them "\
+														   "compressed with delta and bit-packing. Best after "\
+														   "--optimize-vertices and --quantize.",
+														   false, "", "all|none|attribute/attribute/...");
+		
 		//---------------------------------------------------------------------------------------------------------
 		// Optimization
 		//---------------------------------------------------------------------------------------------------------
@@ -128,6 +152,32 @@ int main (int argc, char* argv[])
 												  "given attribute with a possible deviation epsilon.",
 												  false, "", "attribute/epsilon");
 		
+		TCLAP::ValueArg<std::string> simplifyArg("", "simplify",
+												 "Reduces the triangles to the given ratio by edge collapses. Stops early "\
+												 "when the error, relative to the mesh size, would exceed max-error "\
+												 "(default 0.01). UV seams, group boundaries and open borders are kept.",
+												 false, "", "ratio/max-error");
+		
+		TCLAP::ValueArg<std::string> simplifyLodsArg("", "simplify-lods",
+													 "Keeps the mesh and adds levels of detail, each simplified by the "\
+													 "--simplify ratio from the one before, as groups <group>_lod<n> or "\
+													 "as files <name>_lod<n>.",
+													 false, "", "count/groups|files");
+		
+		TCLAP::ValueArg<std::string> buildMeshletsArg("", "build-meshlets",
+													  "Partitions every group into meshlets of at most max-vertices "\
+													  "(up to 256) and max-triangles, with bounding spheres and normal "\
+													  "cones for culling, saved to <name>.meshlets.xml/.dat. Typical "\
+													  "limits are 64/124.",
+													  false, "", "max-vertices/max-triangles");
+		
+		TCLAP::ValueArg<std::string> quantizeArg("", "quantize",
+												 "Stores every vertex attribute in the smallest encoding (HALF_FLOAT, "\
+												 "SHORT_NORM, BYTE_NORM, OCT_SHORT or OCT_BYTE) whose error stays "\
+												 "within max-error, relative to the mesh size for positions and "\
+												 "absolute for the other attributes. FLOAT if none does.",
+												 false, "", "max-error");
+		
 		//---------------------------------------------------------------------------------------------------------
 		// Rename
 		//---------------------------------------------------------------------------------------------------------
@@ -146,12 +196,41 @@ int main (int argc, char* argv[])
 											   "otherwise inwards.",
 											   false);
 		
+		TCLAP::SwitchArg orientFrontFacesArg("", "orient-front-faces",
+											 "Makes the triangle winding consistent over shared edges and "\
+											 "turns closed parts outwards.",
+											 false);
+		
+		TCLAP::ValueArg<std::string> generateNormalsArg("", "generate-normals",
+														"Replaces the normals with generated ones. Weighting is area, angle or "\
+														"none. Vertices are split where triangles meet at more than the crease "\
+														"angle in degrees (default 180, no splitting).",
+														false, "", "weighting/crease-angle");
+		
+		TCLAP::ValueArg<std::string> generateTangentsArg("", "generate-tangents",
+														 "Replaces the tangents with ones generated from normals and texture "\
+														 "coordinates. 'bitangents' also writes bitangents. Vertices are split "\
+														 "where the texture is mirrored.",
+														 false, "", "tangents|bitangents");
+		
 		TCLAP::SwitchArg validateAndChangeArg("", "validate-and-change",
 											  "Validates and changes mesh.", false);
 		
 		TCLAP::ValueArg<std::string> mergeArg("", "merge-mesh", "Merges two meshes",
 											  false, "", "mesh-to-merge");
 		
+		//---------------------------------------------------------------------------------------------------------
+		// Modifiers
+		//---------------------------------------------------------------------------------------------------------
+		TCLAP::MultiArg<std::string> modifierArg("", "modifier",
+												 "Blends a modifier onto the mesh before any other change. "\
+												 "Can be given multiple times.",
+												 false, "modifier-file");
+		
+		TCLAP::ValueArg<std::string> modifierWeightsArg("", "modifier-weights",
+														"Weights of the modifiers in the order given. Missing weights are 1.",
+														false, "", "w1/w2/...");
+		
 		//---------------------------------------------------------------------------------------------------------
 		// Other
 		//---------------------------------------------------------------------------------------------------------
@@ -160,22 +239,41 @@ int main (int argc, char* argv[])
 		TCLAP::SwitchArg infoArg("i", "info", "Prints the mesh info.", false);
 		
 		TCLAP::SwitchArg dumpArg("", "dump-txt", "Dumps the mesh to a text file.", false);
+		
+		TCLAP::SwitchArg compactStorageArg("", "compact-storage",
+										   "Keeps vertex attributes at their declared size in memory instead of padding them to 4 floats.",
+										   false);
 		//---------------------------------------------------------------------------------------------------------
 		// Adding args to cmd
 		//---------------------------------------------------------------------------------------------------------
 		cmd.add(infoArg);
 		cmd.add(dumpArg);
 		cmd.add(quiteArg);
+		cmd.add(compactStorageArg);
 		cmd.add(binaryOutputArg);
 		cmd.add(inputArg);
 		cmd.add(outputArg);
+		cmd.add(modifierWeightsArg);
+		cmd.add(modifierArg);
 		cmd.add(textureTransformArg);
 		cmd.add(flipWindingArg);
 		cmd.add(flipArg);
 		cmd.add(makeNormalsConsistent);
+		cmd.add(orientFrontFacesArg);
+		cmd.add(generateNormalsArg);
+		cmd.add(generateTangentsArg);
+		cmd.add(quantizeArg);
+		cmd.add(buildMeshletsArg);
+		cmd.add(simplifyLodsArg);
+		cmd.add(simplifyArg);
 		cmd.add(stitchEpsArg);
 		cmd.add(stitchArg);
+		cmd.add(optimizeIndicesArg);
+		cmd.add(optimizeVerticesArg);
+		cmd.add(compressAttributesArg);
+		cmd.add(convertPrimitiveTypeToArg);
 		cmd.add(convertIndexTypeToArg);
+		cmd.add(transformStackArg);
 		cmd.add(centerAllArg);
 		cmd.add(centerArg);
 		cmd.add(resizeArg);
@@ -249,6 +347,7 @@ int main (int argc, char* argv[])
 		
 		//---------------------------------------------------------------------------------------------------------
 		Mesh mesh;
+		mesh.setCompactStorage(compactStorageArg.getValue());
 		if(MeshIO::load(&mesh, inputfile.c_str(), binaryInFileName.c_str()) == false)
 		{
 			std::cerr << "Error: Loading '" << inputfile << "', failed!" << std::endl;
@@ -315,12 +414,59 @@ int main (int argc, char* argv[])
 		
 		//---------------------------------------------------------------------------------------------------------
 		
+		// Modifiers address the vertices of the loaded mesh, so they are
+		// applied before anything reorders or removes vertices.
+		if(modifierArg.isSet())
+		{
+			std::vector<float> weights;
+			if(modifierWeightsArg.isSet())
+				StringUtils::getValuesFromCmdString(modifierWeightsArg.getValue(), weights);
+			
+			const std::vector<std::string>& modifierPaths = modifierArg.getValue();
+			std::vector<Modifier*> modifiers;
+			bool modifiersLoaded = true;
+			for(size_t i = 0; i < modifierPaths.size() && modifiersLoaded; ++i)
+			{
+				std::string modifierBinaryPath = FileUtils::getBinaryFileName(modifierPaths[i].c_str(), ".xml", ".dat");
+				Modifier* modifier = new Modifier();
+				modifiers.push_back(modifier);
+				if(MeshIO::loadModifier(modifier, modifierPaths[i].c_str(), modifierBinaryPath.c_str()) == false)
+				{
+					std::cerr << "Error: Loading modifier '" << modifierPaths[i] << "', failed!" << std::endl;
+					modifiersLoaded = false;
+				}
+			}
+			
+			bool modifiersApplied = modifiersLoaded && toolMgr.applyModifiers(modifiers, weights);
+			if(modifiersLoaded && modifiersApplied == false)
+				std::cerr << "Error: A modifier references vertices the mesh does not have!" << std::endl;
+			
+			for(size_t i = 0; i < modifiers.size(); ++i)
+				delete modifiers[i];
+			
+			if(modifiersApplied == false)
+				return 1;
+			modelChanged = true;
+		}
+		
+		//---------------------------------------------------------------------------------------------------------
+		
 		if(convertIndexTypeToArg.isSet())
 		{
 			if(toolMgr.convertIndexType(convertIndexTypeToArg.getValue().c_str()) == false)
 			{
-				std::cerr << "Error: To many vertices. It is not possible to have indices of the type '";
-				std::cerr << convertIndexTypeToArg.getValue() << "'" << std::endl;
+				std::cerr << "Error: Unknown index type '" << convertIndexTypeToArg.getValue() << "'" << std::endl;
+				return 1;
+			}
+			modelChanged = true;
+		}
+		
+		if(convertPrimitiveTypeToArg.isSet())
+		{
+			if(toolMgr.convertPrimitiveType(convertPrimitiveTypeToArg.getValue().c_str()) == false)
+			{
+				std::cerr << "Error: The index type '" << mesh.getMeshFormat().indexType;
+				std::cerr << "' has no restart index for strips" << std::endl;
 				return 1;
 			}
 			modelChanged = true;
@@ -329,6 +475,11 @@ int main (int argc, char* argv[])
 		//---------------------------------------------------------------------------------------------------------
 		bool transformTexCoords = textureTransformArg.getValue();
 		
+		if(transformStackArg.getValue())
+		{
+			toolMgr.beginTransformStack();
+		}
+		
 		if(translateArg.isSet())
 		{
 			std::string args = translateArg.getValue();
@@ -471,6 +622,66 @@ int main (int argc, char* argv[])
 		
 		//---------------------------------------------------------------------------------------------------------
 		
+		float simplifyRatio = 1.0f;
+		float simplifyError = 0.01f;
+		int numLods = 0;
+		bool lodFiles = false;
+		if(simplifyArg.isSet())
+		{
+			std::vector<std::string> values = StringUtils::tokenize(simplifyArg.getValue(), "/");
+			if(values.size() >= 1)
+				StringUtils::getValueFromCmdString(values[0], simplifyRatio);
+			if(values.size() >= 2)
+				StringUtils::getValueFromCmdString(values[1], simplifyError);
+			if(values.empty() || values.size() > 2 || simplifyRatio < 0.0f || simplifyRatio > 1.0f ||
+			   simplifyError <= 0.0f)
+			{
+				std::cerr << "Error: Wrong simplify values '" << simplifyArg.getValue() << "'" << std::endl;
+				return 1;
+			}
+			
+			if(simplifyLodsArg.isSet())
+			{
+				values = StringUtils::tokenize(simplifyLodsArg.getValue(), "/");
+				float count = 0.0f;
+				if(values.size() == 2)
+					StringUtils::getValueFromCmdString(values[0], count);
+				numLods = (int)count;
+				lodFiles = values.size() == 2 && values[1].compare("files") == 0;
+				if(numLods < 1 || (lodFiles == false && values[1].compare("groups") != 0))
+				{
+					std::cerr << "Error: Wrong level of detail values '" << simplifyLodsArg.getValue() << "'" << std::endl;
+					return 1;
+				}
+				// Files are simplified from the final mesh, right before saving.
+				if(lodFiles == false)
+					toolMgr.appendLodGroups(numLods, simplifyRatio, simplifyError);
+			}
+			else
+			{
+				toolMgr.simplify(simplifyRatio, simplifyError);
+			}
+			modelChanged = true;
+		}
+		else if(simplifyLodsArg.isSet())
+		{
+			std::cerr << "Error: --simplify-lods needs --simplify" << std::endl;
+			return 1;
+		}
+		
+		if(optimizeIndicesArg.isSet())
+		{
+			toolMgr.optimizeIndices();
+			modelChanged = true;
+		}
+		if(optimizeVerticesArg.isSet())
+		{
+			toolMgr.optimizeVertices();
+			modelChanged = true;
+		}
+		
+		//---------------------------------------------------------------------------------------------------------
+		
 		if(centerArg.isSet())
 		{
 			std::string args = centerArg.getValue();
@@ -494,8 +705,46 @@ int main (int argc, char* argv[])
 			toolMgr.center(1, 1, 1);
 			modelChanged = true;
 		}
+		toolMgr.endTransformStack();
 		
 		//---------------------------------------------------------------------------------------------------------
+		if(orientFrontFacesArg.isSet())
+		{
+			if(toolMgr.orientFrontFaces())
+			{
+				modelChanged = true;
+			}
+		}
+		if(generateNormalsArg.isSet())
+		{
+			std::string args = generateNormalsArg.getValue();
+			std::vector<std::string> values = StringUtils::tokenize(args, "/");
+			float creaseAngle = 180.0f;
+			if(values.size() == 2)
+				StringUtils::getValueFromCmdString(values[1], creaseAngle);
+			
+			if(values.empty() || toolMgr.generateNormals(values[0].c_str(), creaseAngle) == false)
+			{
+				std::cerr << "Error: Unknown normal weighting '" << args << "'" << std::endl;
+				return 1;
+			}
+			modelChanged = true;
+		}
+		if(generateTangentsArg.isSet())
+		{
+			std::string value = generateTangentsArg.getValue();
+			if(value.compare("tangents") != 0 && value.compare("bitangents") != 0)
+			{
+				std::cerr << "Error: Unknown tangent option '" << value << "'" << std::endl;
+				return 1;
+			}
+			if(toolMgr.generateTangents(value.compare("bitangents") == 0) == false)
+			{
+				std::cerr << "Error: Generating tangents needs normals and texture coordinates" << std::endl;
+				return 1;
+			}
+			modelChanged = true;
+		}
 		if(makeNormalsConsistent.isSet())
 		{
 			if(toolMgr.makeNormalsConsistent())
@@ -528,14 +777,23 @@ int main (int argc, char* argv[])
 			}
 			std::string mergeMeshBinaryPath = FileUtils::getBinaryFileName(mergeMeshPath.c_str(), ".xml", ".dat");
 			Mesh* second = new Mesh();
+			second->setCompactStorage(mesh.isCompactStorage());
 			
-			MeshIO::load(second, mergeMeshPath.c_str(), mergeMeshBinaryPath.c_str());
+			if(MeshIO::load(second, mergeMeshPath.c_str(), mergeMeshBinaryPath.c_str()) == false)
+			{
+				std::cerr << "Error: Loading mesh to merge '" << mergeMeshPath << "', failed!" << std::endl;
+				delete second; second = 0;
+				return 1;
+			}
 			toolMgr.mergeMeshes(second);
 			delete second; second = 0;
 			modelChanged = true;
 		}
 		//---------------------------------------------------------------------------------------------------------
 		
+		if(toolMgr.partitionIndices())
+			modelChanged = true;
+		
 		if(dumpArg.isSet())
 		{
 			std::string debugOutputFile;
@@ -547,6 +805,93 @@ int main (int argc, char* argv[])
 			std::cout << "Dump mesh to text file" << std::endl;
 		}
 		
+		if(quantizeArg.isSet())
+		{
+			float maxError = -1.0f;
+			StringUtils::getValueFromCmdString(quantizeArg.getValue(), maxError);
+			if(maxError < 0.0f)
+			{
+				std::cerr << "Error: Wrong max error '" << quantizeArg.getValue() << "'" << std::endl;
+				return 1;
+			}
+			toolMgr.quantize(maxError);
+			modelChanged = true;
+		}
+		
+		if(compressAttributesArg.isSet())
+		{
+			std::vector<std::string> names;
+			if(compressAttributesArg.getValue().compare("all") == 0)
+				names = mesh.getMeshFormat().attributeName;
+			else if(compressAttributesArg.getValue().compare("none") != 0)
+				names = StringUtils::tokenize(compressAttributesArg.getValue(), "/");
+			if(toolMgr.compressAttributes(names) == false)
+			{
+				std::cerr << "Error: Unknown attribute in '" << compressAttributesArg.getValue() << "'" << std::endl;
+				return 1;
+			}
+			modelChanged = true;
+		}
+		
+		if(lodFiles)
+		{
+			std::vector<Mesh*> lods;
+			toolMgr.createLodMeshes(numLods, simplifyRatio, simplifyError, lods);
+			
+			// Without an extension the suffix goes at the end of the name.
+			size_t pos = outputfile.find(".mesh.xml");
+			if(pos == std::string::npos)
+				pos = outputfile.find(".xml");
+			if(pos == std::string::npos)
+				pos = outputfile.size();
+			for(size_t i = 0; i < lods.size(); ++i)
+			{
+				ToolManager lodMgr(lods[i], false);
+				if(optimizeIndicesArg.isSet())
+					lodMgr.optimizeIndices();
+				if(optimizeVerticesArg.isSet())
+					lodMgr.optimizeVertices();
+				lodMgr.partitionIndices();
+				
+				std::stringstream lodName;
+				lodName << outputfile.substr(0, pos) << "_lod" << i+1 << outputfile.substr(pos);
+				std::string lodFile = lodName.str();
+				std::string lodBinaryFile = lodFile.substr(0, lodFile.rfind(".xml")) + ".dat";
+				
+				MeshIO::saveFile(lods[i], lodFile.c_str(), lodBinaryFile.c_str());
+				delete lods[i];
+			}
+		}
+		
+		if(buildMeshletsArg.isSet())
+		{
+			std::vector<std::string> values = StringUtils::tokenize(buildMeshletsArg.getValue(), "/");
+			float maxVertices = 0.0f;
+			float maxTriangles = 0.0f;
+			if(values.size() == 2)
+			{
+				StringUtils::getValueFromCmdString(values[0], maxVertices);
+				StringUtils::getValueFromCmdString(values[1], maxTriangles);
+			}
+			if(maxVertices < 3.0f || maxVertices > 256.0f || maxTriangles < 1.0f)
+			{
+				std::cerr << "Error: Wrong meshlet limits '" << buildMeshletsArg.getValue() << "'" << std::endl;
+				return 1;
+			}
+			
+			Meshlets meshlets;
+			toolMgr.buildMeshlets((int)maxVertices, (int)maxTriangles, &meshlets);
+			
+			size_t pos = outputfile.find(".mesh.xml");
+			if(pos == std::string::npos)
+				pos = outputfile.find(".xml");
+			std::string meshletsFile = outputfile.substr(0, pos) + ".meshlets.xml";
+			std::string meshletsBinaryFile = outputfile.substr(0, pos) + ".meshlets.dat";
+			MeshIO::saveMeshlets(&meshlets, meshletsFile.c_str(), meshletsBinaryFile.c_str());
+			// The meshlets refer to the vertices of the saved mesh.
+			modelChanged = true;
+		}
+		
 		if(modelChanged)
 		{
 			MeshIO::saveFile(&mesh, outputfile.c_str(), binaryOutFileName.c_str());
@@ -47,26 +47,26 @@ void MeshTool::merge(Mesh *first, Mesh *second)
     for(int i = 0; i < second->getNumberOfVertices(); ++i)
     {
         float* pos = second->getPosition(i);
-        first->addPosition(pos);
+        first->addPosition(pos, second->getStride(Mesh::POSITION));
         if(first->hasNormals() && second->hasNormals())
         {
             float* normal = second->getNormal(i);
-            first->addNormal(normal);
+            first->addNormal(normal, second->getStride(Mesh::NORMAL));
         }
         if(first->hasTexCoords() && second->hasTexCoords())
         {
             float* texCoord = second->getTexCoord(i);
-            first->addTexCoord(texCoord);
+            first->addTexCoord(texCoord, second->getStride(Mesh::TEXCOORD));
         }
         if(first->hasTangents() && second->hasTangents())
         {
             float* tangent = second->getTangent(i);
-            first->addTangent(tangent);
+            first->addTangent(tangent, second->getStride(Mesh::TANGENT));
         }
         if(first->hasBitangents() && second->hasBitangents())
         {
             float* bitangent = second->getBitangent(i);
-            first->addTangent(bitangent);
+            first->addBitangent(bitangent, second->getStride(Mesh::BITANGENT));
         }
     }
     unsigned int numIndices= first->getNumberOfTriangles()*3;
@@ -89,6 +89,7 @@ void MeshTool::merge(Mesh *first, Mesh *second)
         memcpy(g.name, tmpGroupName.c_str(), tmpGroupName.size());
 
         g.triangleCount = second->getGroup(i).triangleCount;
+        g.primitiveType = second->getGroup(i).primitiveType;
 
         g.startIndex = second->getGroup(i).startIndex + numIndices;
 
@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshWizIncludes.h"
+#include "MeshletTool.h"
+#include <cmath>
+#include <cfloat>
+
+using namespace assembly3d;
+using namespace assembly3d::wiz;
+
+// Tightest sphere is not needed, Ritter's two passes are close enough
+// for culling.
+static void computeBoundingSphere(Mesh* mesh, const unsigned int* vertices, int count,
+                                  float* center, float& radius)
+{
+
+    // Most distant pair of the extreme points along the axes.
+    int minimum[3] = {0, 0, 0};
+    int maximum[3] = {0, 0, 0};
+    for(int i = 1; i < count; ++i)
+    {
+        const float* p = mesh->getPosition(vertices[i]);
+        for(int a = 0; a < 3; ++a)
+        {
+            if(p[a] < mesh->getPosition(vertices[minimum[a]])[a])
+                minimum[a] = i;
+            if(p[a] > mesh->getPosition(vertices[maximum[a]])[a])
+                maximum[a] = i;
+        }
+    }
+    int axis = 0;
+    float largest = -1.0f;
+    for(int a = 0; a < 3; ++a)
+    {
+        const float* p0 = mesh->getPosition(vertices[minimum[a]]);
+        const float* p1 = mesh->getPosition(vertices[maximum[a]]);
+        float d = (p1[0]-p0[0])*(p1[0]-p0[0]) + (p1[1]-p0[1])*(p1[1]-p0[1]) + (p1[2]-p0[2])*(p1[2]-p0[2]);
+        if(d > largest)
+        {
+            largest = d;
+            axis = a;
+        }
+    }
+    const float* p0 = mesh->getPosition(vertices[minimum[axis]]);
+    const float* p1 = mesh->getPosition(vertices[maximum[axis]]);
+    center[0] = 0.5f*(p0[0] + p1[0]);
+    center[1] = 0.5f*(p0[1] + p1[1]);
+    center[2] = 0.5f*(p0[2] + p1[2]);
+    radius = 0.5f*sqrtf(largest);
+
+    // Grow to the points outside.
+    for(int i = 0; i < count; ++i)
+    {
+        const float* p = mesh->getPosition(vertices[i]);
+        float d[3] = {p[0]-center[0], p[1]-center[1], p[2]-center[2]};
+        float distance = sqrtf(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+        if(distance > radius)
+        {
+            float grown = 0.5f*(radius + distance);
+            float shift = (grown - radius) / distance;
+            center[0] += d[0]*shift;
+            center[1] += d[1]*shift;
+            center[2] += d[2]*shift;
+            radius = grown;
+        }
+    }
+}
+
+// Normal cone with its apex behind all triangle planes, so culling only
+// depends on the camera position.
+static void computeNormalCone(Mesh* mesh, const unsigned int* vertices,
+                              const unsigned char* triangles, int numTriangles,
+                              Meshlets::Bounds& bounds)
+{
+    std::vector<float> normals((size_t)numTriangles*3);
+    std::vector<const float*> corners((size_t)numTriangles);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    int numValid = 0;
+    for(int t = 0; t < numTriangles; ++t)
+    {
+        const float* a = mesh->getPosition(vertices[triangles[t*3+0]]);
+        const float* b = mesh->getPosition(vertices[triangles[t*3+1]]);
+        const float* c = mesh->getPosition(vertices[triangles[t*3+2]]);
+        float e1[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+        float e2[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+        float n[3] = {e1[1]*e2[2] - e1[2]*e2[1],
+                      e1[2]*e2[0] - e1[0]*e2[2],
+                      e1[0]*e2[1] - e1[1]*e2[0]};
+        float length = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        if(length == 0.0f)
+            continue;
+
+        float* normal = &normals[(size_t)numValid*3];
+        normal[0] = n[0] / length;
+        normal[1] = n[1] / length;
+        normal[2] = n[2] / length;
+        corners[numValid] = a;
+        axis[0] += normal[0];
+        axis[1] += normal[1];
+        axis[2] += normal[2];
+        ++numValid;
+    }
+
+    bounds.coneApex[0] = bounds.center[0];
+    bounds.coneApex[1] = bounds.center[1];
+    bounds.coneApex[2] = bounds.center[2];
+    bounds.coneAxis[0] = 0.0f;
+    bounds.coneAxis[1] = 0.0f;
+    bounds.coneAxis[2] = 0.0f;
+    bounds.coneCutoff = 1.0f;
+
+    float length = sqrtf(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    if(numValid == 0 || length == 0.0f)
+        return;
+    axis[0] /= length;
+    axis[1] /= length;
+    axis[2] /= length;
+    bounds.coneAxis[0] = axis[0];
+    bounds.coneAxis[1] = axis[1];
+    bounds.coneAxis[2] = axis[2];
+
+    float minDot = 1.0f;
+    for(int t = 0; t < numValid; ++t)
+    {
+        const float* n = &normals[(size_t)t*3];
+        minDot = std::min(minDot, n[0]*axis[0] + n[1]*axis[1] + n[2]*axis[2]);
+    }
+    // Wider than ~84 degrees, the apex would run off too far to be useful.
+    if(minDot <= 0.1f)
+        return;
+
+    float maxT = 0.0f;
+    for(int t = 0; t < numValid; ++t)
+    {
+        const float* n = &normals[(size_t)t*3];
+        const float* p = corners[t];
+        float dc = (bounds.center[0]-p[0])*n[0] + (bounds.center[1]-p[1])*n[1] + (bounds.center[2]-p[2])*n[2];
+        float dn = axis[0]*n[0] + axis[1]*n[1] + axis[2]*n[2];
+        maxT = std::max(maxT, dc / dn);
+    }
+    bounds.coneApex[0] = bounds.center[0] - axis[0]*maxT;
+    bounds.coneApex[1] = bounds.center[1] - axis[1]*maxT;
+    bounds.coneApex[2] = bounds.center[2] - axis[2]*maxT;
+    bounds.coneCutoff = sqrtf(1.0f - minDot*minDot);
+}
+
+// Greedy partition of the triangles [begin, end). live counts the unused
+// triangles around each vertex. Taking triangles whose vertices have few
+// of them left first, and starting the next meshlet at the border of the
+// last one, avoids leaving small islands behind.
+static void partitionGroup(Mesh* mesh, const MeshAdjacency& adjacency, const std::vector<float>& centroids,
+                           int begin, int end, int maxVertices, int maxTriangles,
+                           std::vector<char>& used, std::vector<char>& queued,
+                           std::vector<int>& localIndex, std::vector<int>& live,
+                           Meshlets::Group& group)
+{
+    const unsigned int* indices = mesh->getIndicesPointer();
+    for(int i = begin*3; i < end*3; ++i)
+        live[indices[i]] = 0;
+    for(int i = begin*3; i < end*3; ++i)
+        ++live[indices[i]];
+
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> meshletVertices;
+    float sum[3];
+    int numMeshletTriangles = 0;
+
+    int cursor = begin;
+    int seed = -1;
+    while(true)
+    {
+        if(seed < 0)
+        {
+            while(cursor < end && used[cursor])
+                ++cursor;
+            if(cursor == end)
+                break;
+            seed = cursor;
+        }
+
+        Meshlets::Meshlet meshlet;
+        meshlet.vertexOffset = static_cast<unsigned int>(group.vertices.size());
+        meshlet.triangleOffset = static_cast<unsigned int>(group.triangles.size()/3);
+        meshletVertices.clear();
+        candidates.clear();
+        sum[0] = sum[1] = sum[2] = 0.0f;
+        numMeshletTriangles = 0;
+
+        int next = seed;
+        while(next >= 0)
+        {
+            // Add the triangle.
+            used[next] = 1;
+            const unsigned int* t = indices + next*3;
+            for(int k = 0; k < 3; ++k)
+            {
+                unsigned int v = t[k];
+                --live[v];
+                if(localIndex[v] < 0)
+                {
+                    localIndex[v] = static_cast<int>(meshletVertices.size());
+                    meshletVertices.push_back(v);
+
+                    const unsigned int* triangles = adjacency.getVertexTriangles(v);
+                    int count = adjacency.getVertexTriangleCount(v);
+                    for(int i = 0; i < count; ++i)
+                    {
+                        unsigned int u = triangles[i];
+                        if((int)u >= begin && (int)u < end && used[u] == 0 && queued[u] == 0)
+                        {
+                            queued[u] = 1;
+                            candidates.push_back(u);
+                        }
+                    }
+                }
+                group.triangles.push_back(static_cast<unsigned char>(localIndex[v]));
+            }
+            sum[0] += centroids[next*3+0];
+            sum[1] += centroids[next*3+1];
+            sum[2] += centroids[next*3+2];
+            ++numMeshletTriangles;
+            if(numMeshletTriangles == maxTriangles)
+                break;
+
+            // Pick the triangle adding the fewest vertices, then the one
+            // with the fewest unused triangles left around its vertices,
+            // then the one closest to the meshlet.
+            const float count = static_cast<float>(numMeshletTriangles);
+            float center[3] = {sum[0] / count, sum[1] / count, sum[2] / count};
+            next = -1;
+            int bestExtra = 4;
+            int bestLive = 0;
+            float bestDistance = FLT_MAX;
+            size_t i = 0;
+            while(i < candidates.size())
+            {
+                unsigned int u = candidates[i];
+                if(used[u])
+                {
+                    queued[u] = 0;
+                    candidates[i] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                const unsigned int* c = indices + u*3;
+                int extra = (localIndex[c[0]] < 0) + (localIndex[c[1]] < 0) + (localIndex[c[2]] < 0);
+                int liveCount = live[c[0]] + live[c[1]] + live[c[2]];
+                const float* p = &centroids[u*3];
+                float d = (p[0]-center[0])*(p[0]-center[0]) + (p[1]-center[1])*(p[1]-center[1]) +
+                          (p[2]-center[2])*(p[2]-center[2]);
+                if(extra < bestExtra || (extra == bestExtra && (liveCount < bestLive ||
+                   (liveCount == bestLive && d < bestDistance))))
+                {
+                    next = static_cast<int>(u);
+                    bestExtra = extra;
+                    bestLive = liveCount;
+                    bestDistance = d;
+                }
+                ++i;
+            }
+            if(next >= 0 && (int)meshletVertices.size() + bestExtra > maxVertices)
+                next = -1;
+        }
+
+        // The next meshlet starts at the most enclosed triangle left on
+        // the border.
+        seed = -1;
+        int seedLive = 0;
+        for(size_t i = 0; i < candidates.size(); ++i)
+        {
+            unsigned int u = candidates[i];
+            queued[u] = 0;
+            if(used[u])
+                continue;
+            const unsigned int* c = indices + u*3;
+            int liveCount = live[c[0]] + live[c[1]] + live[c[2]];
+            if(seed < 0 || liveCount < seedLive)
+            {
+                seed = static_cast<int>(u);
+                seedLive = liveCount;
+            }
+        }
+        for(size_t i = 0; i < meshletVertices.size(); ++i)
+            localIndex[meshletVertices[i]] = -1;
+
+        group.vertices.insert(group.vertices.end(), meshletVertices.begin(), meshletVertices.end());
+        meshlet.vertexCount = static_cast<unsigned int>(meshletVertices.size());
+        meshlet.triangleCount = static_cast<unsigned int>(numMeshletTriangles);
+        group.meshlets.push_back(meshlet);
+    }
+}
+
+MeshletTool::MeshletTool()
+{
+}
+
+MeshletTool::~MeshletTool()
+{
+}
+
+void MeshletTool::buildMeshlets(Mesh* mesh, int maxVertices, int maxTriangles, Meshlets* meshlets)
+{
+    meshlets->destroy();
+    meshlets->setLimits(maxVertices, maxTriangles);
+
+    const int numVertices = mesh->getNumberOfVertices();
+    const int numTriangles = mesh->getNumberOfTriangles();
+    const int numGroups = mesh->getNumberOfGroups();
+    if(numTriangles == 0)
+        return;
+
+    const MeshAdjacency& adjacency = mesh->getAdjacency();
+    const unsigned int* indices = mesh->getIndicesPointer();
+
+    std::vector<float> centroids((size_t)numTriangles*3);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int t = 0; t < numTriangles; ++t)
+    {
+        const float* a = mesh->getPosition(indices[t*3+0]);
+        const float* b = mesh->getPosition(indices[t*3+1]);
+        const float* c = mesh->getPosition(indices[t*3+2]);
+        for(int j = 0; j < 3; ++j)
+            centroids[(size_t)t*3+j] = (a[j] + b[j] + c[j]) / 3.0f;
+    }
+
+    // Groups own disjoint triangle ranges, so they are partitioned in
+    // parallel. Vertices shared by groups need one table per thread.
+    std::vector<Meshlets::Group> groups(numGroups);
+    std::vector<char> used(numTriangles, 0);
+    std::vector<char> queued(numTriangles, 0);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        std::vector<int> localIndex(numVertices, -1);
+        std::vector<int> live(numVertices, 0);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for(int g = 0; g < numGroups; ++g)
+        {
+            const Mesh::Group& meshGroup = mesh->getGroup(g);
+            groups[g].name = meshGroup.name;
+            int begin = meshGroup.startIndex/3;
+            partitionGroup(mesh, adjacency, centroids, begin, begin + meshGroup.triangleCount,
+                           maxVertices, maxTriangles, used, queued, localIndex, live, groups[g]);
+        }
+    }
+
+    for(int g = 0; g < numGroups; ++g)
+    {
+        Meshlets::Group& group = groups[g];
+        const int count = static_cast<int>(group.meshlets.size());
+        group.bounds.resize(count);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+        for(int i = 0; i < count; ++i)
+        {
+            const Meshlets::Meshlet& meshlet = group.meshlets[i];
+            Meshlets::Bounds& bounds = group.bounds[i];
+            const unsigned int* vertices = &group.vertices[meshlet.vertexOffset];
+            computeBoundingSphere(mesh, vertices, meshlet.vertexCount, bounds.center, bounds.radius);
+            computeNormalCone(mesh, vertices, &group.triangles[meshlet.triangleOffset*3],
+                              meshlet.triangleCount, bounds);
+        }
+        meshlets->addGroup(group);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _MESHLETTOOL_H_
+#define _MESHLETTOOL_H_
+
+#include "Mesh.h"
+#include "Meshlets.h"
+
+namespace assembly3d
+{
+    namespace wiz
+    {
+        /**
+         * @brief Class for partitioning meshes into meshlets.
+         *
+        */
+        class MeshletTool
+        {
+        public:
+            MeshletTool();
+            ~MeshletTool();
+
+            /**
+             * @brief Partitions the triangles of every group into meshlets.
+             *
+             * Meshlets grow greedily over shared vertices. The next triangle
+             * is the one adding the fewest vertices, then the one closest
+             * to the meshlet. A meshlet ends when the next triangle does
+             * not fit or none is connected. Triangles keep their winding.
+             *
+             * @param mesh The mesh to partition.
+             * @param maxVertices Largest number of vertices per meshlet, at most 256.
+             * @param maxTriangles Largest number of triangles per meshlet.
+             * @param meshlets Receives one group per mesh group.
+             */
+            void buildMeshlets(Mesh* mesh, int maxVertices, int maxTriangles, Meshlets* meshlets);
+        };
+    }
+}
+
+#endif  // _MESHLETTOOL_H_
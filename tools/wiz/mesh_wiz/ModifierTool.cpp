@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshWizIncludes.h"
+#include "ModifierTool.h"
+#include "TransformTool.h"
+#include <algorithm>
+
+using namespace assembly3d;
+using namespace assembly3d::wiz;
+
+// Blends the values of one group attribute into the mesh data. The values
+// are read as one stream per component, the mesh data is only touched at
+// the group's vertices.
+template<int size>
+static void blendDelta(float* data, int stride, const unsigned int* vertices, int count,
+                       const std::vector<float>* components, float weight)
+{
+    const float* c[size];
+    for(int j = 0; j < size; ++j)
+        c[j] = &components[j][0];
+
+    for(int i = 0; i < count; ++i)
+    {
+        float* v = data + (size_t)vertices[i]*stride;
+        for(int j = 0; j < size; ++j)
+            v[j] += weight * c[j][i];
+    }
+}
+
+template<int size>
+static void blendOverride(float* data, int stride, const unsigned int* vertices, int count,
+                          const std::vector<float>* components, float weight)
+{
+    const float* c[size];
+    for(int j = 0; j < size; ++j)
+        c[j] = &components[j][0];
+
+    for(int i = 0; i < count; ++i)
+    {
+        float* v = data + (size_t)vertices[i]*stride;
+        for(int j = 0; j < size; ++j)
+            v[j] += weight * (c[j][i] - v[j]);
+    }
+}
+
+template<int size>
+static void blendTarget(float* data, int stride, const unsigned int* vertices, int count,
+                        const std::vector<float>* components, float weight,
+                        Modifier::BlendMode mode)
+{
+    if(mode == Modifier::OVERRIDE)
+        blendOverride<size>(data, stride, vertices, count, components, weight);
+    else
+        blendDelta<size>(data, stride, vertices, count, components, weight);
+}
+
+ModifierTool::ModifierTool()
+{
+}
+
+ModifierTool::~ModifierTool()
+{
+}
+
+bool ModifierTool::blend(Mesh* mesh, const std::vector<Modifier*>& modifiers,
+                         const std::vector<float>& weights)
+{
+    for(size_t m = 0; m < modifiers.size(); ++m)
+    {
+        if(modifiers[m]->isValidFor(mesh->getNumberOfVertices()) == false)
+            return false;
+    }
+
+    bool positionsChanged = false;
+    for(size_t m = 0; m < modifiers.size(); ++m)
+    {
+        const Modifier& modifier = *modifiers[m];
+        const float weight = m < weights.size() ? weights[m] : 1.0f;
+        if(weight == 0.0f)
+            continue;
+
+        for(int i = 0; i < modifier.getNumberOfGroups(); ++i)
+        {
+            const Modifier::Group& g = modifier.getGroup(i);
+            const int count = static_cast<int>(g.vertices.size());
+            if(count == 0)
+                continue;
+
+            for(size_t j = 0; j < g.attributes.size(); ++j)
+            {
+                const Modifier::Target& target = g.attributes[j];
+                Mesh::AttributeType type;
+                if(getAttributeType(mesh, target.name, type) == false)
+                    continue;
+
+                Mesh::Attribute attribute = mesh->getAttribute(type);
+                switch(std::min(target.size, attribute.size))
+                {
+                case 1:
+                    blendTarget<1>(attribute.data, attribute.stride, &g.vertices[0], count,
+                                   target.components, weight, g.mode);
+                    break;
+                case 2:
+                    blendTarget<2>(attribute.data, attribute.stride, &g.vertices[0], count,
+                                   target.components, weight, g.mode);
+                    break;
+                case 3:
+                    blendTarget<3>(attribute.data, attribute.stride, &g.vertices[0], count,
+                                   target.components, weight, g.mode);
+                    break;
+                case 4:
+                    blendTarget<4>(attribute.data, attribute.stride, &g.vertices[0], count,
+                                   target.components, weight, g.mode);
+                    break;
+                }
+
+                if(type == Mesh::POSITION)
+                    positionsChanged = true;
+            }
+        }
+    }
+
+    // Directions are normalized after all modifiers, so deltas add up
+    // before the length is restored.
+    for(size_t m = 0; m < modifiers.size(); ++m)
+    {
+        const Modifier& modifier = *modifiers[m];
+        for(int i = 0; i < modifier.getNumberOfGroups(); ++i)
+        {
+            const Modifier::Group& g = modifier.getGroup(i);
+            for(size_t j = 0; j < g.attributes.size(); ++j)
+            {
+                Mesh::AttributeType type;
+                if(getAttributeType(mesh, g.attributes[j].name, type) == false ||
+                   type == Mesh::POSITION || type == Mesh::TEXCOORD)
+                    continue;
+
+                Mesh::Attribute attribute = mesh->getAttribute(type);
+                const int size = std::min(attribute.size, 3);
+                for(size_t k = 0; k < g.vertices.size(); ++k)
+                    TransformTool::normalize(attribute.data + (size_t)g.vertices[k]*attribute.stride, size);
+            }
+        }
+    }
+
+    if(positionsChanged)
+    {
+        mesh->invalidateNormals();
+        mesh->calculateBounds();
+    }
+
+    return true;
+}
+
+bool ModifierTool::getAttributeType(Mesh* mesh, const std::string& name,
+                                    Mesh::AttributeType& type)
+{
+    if(name.compare("POSITION") == 0 && mesh->hasPositions())
+        type = Mesh::POSITION;
+    else if(name.compare("NORMAL") == 0 && mesh->hasNormals())
+        type = Mesh::NORMAL;
+    else if(name.compare("TEXCOORD") == 0 && mesh->hasTexCoords())
+        type = Mesh::TEXCOORD;
+    else if(name.compare("TANGENT") == 0 && mesh->hasTangents())
+        type = Mesh::TANGENT;
+    else if(name.compare("BITANGENT") == 0 && mesh->hasBitangents())
+        type = Mesh::BITANGENT;
+    else
+        return false;
+    return true;
+}
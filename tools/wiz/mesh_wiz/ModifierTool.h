@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _MODIFIERTOOL_H_
+#define _MODIFIERTOOL_H_
+
+#include "Mesh.h"
+#include "Modifier.h"
+
+namespace assembly3d
+{
+    namespace wiz
+    {
+        /**
+         * @brief Class for blending modifiers onto a mesh.
+         *
+        */
+        class ModifierTool
+        {
+        public:
+            ModifierTool();
+            ~ModifierTool();
+
+            /**
+             * @brief Blends weighted modifiers onto a mesh.
+             *
+             * Only the vertices referenced by the modifier groups are
+             * touched. Delta groups add up independent of their order,
+             * override groups are applied in the order given. Normals,
+             * tangents and bitangents are normalized once after all
+             * modifiers have been applied. Attributes the mesh does not
+             * have are skipped.
+             *
+             * @param mesh The mesh to work on.
+             * @param modifiers Modifiers to apply.
+             * @param weights One weight per modifier.
+             * @return False if a modifier references a vertex the mesh does not have.
+             */
+            bool blend(Mesh* mesh, const std::vector<Modifier*>& modifiers,
+                       const std::vector<float>& weights);
+
+        private:
+            /**
+             * @brief Maps an attribute name to the mesh attribute.
+             *
+             * @return False if the name is not a mesh attribute or the mesh does not have it.
+             */
+            static bool getAttributeType(Mesh* mesh, const std::string& name,
+                                         Mesh::AttributeType& type);
+        };
+    }
+}
+
+#endif  // _MODIFIERTOOL_H_
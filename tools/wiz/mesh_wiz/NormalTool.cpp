@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshWizIncludes.h"
+#include "NormalTool.h"
+
+#define PIf		3.1415926535897932384626433832795f
+
+using namespace assembly3d;
+using namespace assembly3d::wiz;
+
+// Zero normals, padded like Mesh::addNormal does.
+static void allocateNormals(std::vector<float>& normals, int numVertices, int stride)
+{
+    normals.assign((size_t)numVertices*stride, 0.0f);
+    for(int i = 0; i < numVertices && stride > 3; ++i)
+        normals[(size_t)i*stride+3] = 1.0f;
+}
+
+NormalTool::NormalTool()
+{
+}
+
+NormalTool::~NormalTool()
+{
+}
+
+int NormalTool::generateNormals(Mesh* mesh, MeshNormals::Weighting weighting, float creaseAngle)
+{
+    if(mesh->hasPositions() == false)
+        return 0;
+
+    if(mesh->hasNormals() == false)
+    {
+        mesh->addAttribute("NORMAL", 3, "FLOAT");
+        mesh->hasNormals(true);
+    }
+
+    const int numVertices = mesh->getNumberOfVertices();
+    const int numTriangles = mesh->getNumberOfTriangles();
+    const MeshAdjacency& adjacency = mesh->getAdjacency();
+    const float* positions = mesh->getPositionsPointer();
+    const int positionStride = mesh->getStride(Mesh::POSITION);
+    const unsigned int* indices = numTriangles > 0 ? mesh->getIndicesPointer() : 0;
+
+    std::vector<float> triangleNormals;
+    MeshNormals::computeTriangleNormals(positions, positionStride, indices, numTriangles,
+                                        triangleNormals);
+
+    const int normalStride = mesh->getStride(Mesh::NORMAL);
+    std::vector<float> normals;
+
+    if(creaseAngle >= 180.0f)
+    {
+        std::vector<float> vertexNormals;
+        MeshNormals::computeVertexNormals(positions, positionStride, indices, adjacency,
+                                          triangleNormals, weighting, vertexNormals);
+
+        allocateNormals(normals, numVertices, normalStride);
+        for(int i = 0; i < numVertices; ++i)
+        {
+            for(int j = 0; j < 3; ++j)
+                normals[(size_t)i*normalStride+j] = vertexNormals[(size_t)i*4+j];
+        }
+        mesh->setNormals(normals);
+        return 0;
+    }
+
+    std::vector<float> cornerNormals;
+    MeshNormals::computeCornerNormals(positions, positionStride, indices, adjacency,
+                                      triangleNormals, weighting, creaseAngle * PIf / 180.0f,
+                                      cornerNormals);
+
+    // Every vertex keeps its index for the normal of its first corner.
+    // Corners with a different normal get a copy of the vertex per normal.
+    std::vector<unsigned int> newToOld(numVertices);
+    for(int i = 0; i < numVertices; ++i)
+        newToOld[i] = i;
+
+    std::vector<unsigned int> newIndices(indices, indices + numTriangles*3);
+    std::vector<int> copies;
+    for(int v = 0; v < numVertices; ++v)
+    {
+        const unsigned int* triangles = adjacency.getVertexTriangles(v);
+        const int count = adjacency.getVertexTriangleCount(v);
+
+        copies.clear();
+        for(int i = 0; i < count; ++i)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                int corner = triangles[i]*3 + k;
+                if(indices[corner] != (unsigned int)v)
+                    continue;
+
+                const float* n = &cornerNormals[(size_t)corner*4];
+                int vertex = -1;
+                for(size_t c = 0; c < copies.size() && vertex < 0; ++c)
+                {
+                    const float* other = &cornerNormals[(size_t)copies[c]*4];
+                    if(n[0] == other[0] && n[1] == other[1] && n[2] == other[2])
+                        vertex = (int)newIndices[copies[c]];
+                }
+                if(vertex < 0)
+                {
+                    if(copies.empty())
+                    {
+                        vertex = v;
+                    }
+                    else
+                    {
+                        vertex = (int)newToOld.size();
+                        newToOld.push_back(v);
+                    }
+                    copies.push_back(corner);
+                }
+                newIndices[corner] = vertex;
+            }
+        }
+    }
+
+    const int numNewVertices = static_cast<int>(newToOld.size());
+    allocateNormals(normals, numNewVertices, normalStride);
+    for(int corner = 0; corner < numTriangles*3; ++corner)
+    {
+        float* dst = &normals[(size_t)newIndices[corner]*normalStride];
+        const float* src = &cornerNormals[(size_t)corner*4];
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+
+    if(numNewVertices > numVertices)
+    {
+        mesh->remapVertices(newToOld);
+        mesh->setIndices(newIndices);
+    }
+    mesh->setNormals(normals);
+
+    return numNewVertices - numVertices;
+}
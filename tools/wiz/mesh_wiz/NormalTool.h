@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _NORMALTOOL_H_
+#define _NORMALTOOL_H_
+
+#include "Mesh.h"
+#include "MeshNormals.h"
+
+namespace assembly3d
+{
+    namespace wiz
+    {
+        /**
+         * @brief Class for generating vertex normals.
+         *
+        */
+        class NormalTool
+        {
+        public:
+            NormalTool();
+            ~NormalTool();
+
+            /**
+             * @brief Replaces the vertex normals with generated ones.
+             *
+             * Adds the normal attribute if the mesh has none. With a
+             * crease angle below 180 degrees, vertices whose triangles
+             * meet at sharper angles are split, one copy per smooth side.
+             *
+             * @param mesh The mesh to work on.
+             * @param weighting How the triangles around a vertex are weighted.
+             * @param creaseAngle Largest smoothed angle in degrees.
+             * @return Number of vertices added by splitting.
+             */
+            int generateNormals(Mesh* mesh, MeshNormals::Weighting weighting, float creaseAngle);
+        };
+    }
+}
+
+#endif  // _NORMALTOOL_H_
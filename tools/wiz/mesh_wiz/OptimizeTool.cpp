@@ -33,10 +33,52 @@
 
 #include "MeshWizIncludes.h"
 #include "OptimizeTool.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <queue>
 
 using namespace assembly3d;
 using namespace assembly3d::wiz;
 
+// Scoring values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+static float getVertexScore(int cachePosition, int liveTriangles, int cacheSize)
+{
+    if(liveTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if(cachePosition >= 0)
+    {
+        if(cachePosition < 3)
+        {
+            // The last triangle's vertices get a fixed score, so that
+            // strips are not favoured over fans.
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            float scaler = 1.0f / static_cast<float>(cacheSize - 3);
+            score = powf(1.0f - static_cast<float>(cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+    score += VALENCE_BOOST_SCALE * powf((float)liveTriangles, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+// Score of a triangle whose vertices are all out of the cache.
+static float getTriangleScore(const unsigned int* triangle, const std::vector<int>& liveTriangles, int cacheSize)
+{
+    return getVertexScore(-1, liveTriangles[triangle[0]], cacheSize) +
+           getVertexScore(-1, liveTriangles[triangle[1]], cacheSize) +
+           getVertexScore(-1, liveTriangles[triangle[2]], cacheSize);
+}
+
 OptimizeTool::OptimizeTool()
 {
     
@@ -54,381 +96,494 @@ bool OptimizeTool::isInRange(float lhs, float rhs, float eps)
         return true;
 }
 
-bool OptimizeTool::vertexPosEquals(const Vertex& lhs, const Vertex& rhs, float eps)
+const float* OptimizeTool::getAttributePointer(Mesh* m, Mesh::AttributeType a)
 {
-    if(isInRange(lhs.position[0], rhs.position[0], eps) &&
-       isInRange(lhs.position[1], rhs.position[1], eps) &&
-       isInRange(lhs.position[2], rhs.position[2], eps) &&
-	   isInRange(lhs.position[3], rhs.position[3], eps))
-    {
-        return true;
-    }
-    else
+    switch(a)
     {
-        return false;
+    case Mesh::POSITION:
+        return m->hasPositions() ? m->getPositionsPointer() : 0;
+    case Mesh::NORMAL:
+        return m->hasNormals() ? m->getNormalsPointer() : 0;
+    case Mesh::TEXCOORD:
+        return m->hasTexCoords() ? m->getTexCoordsPointer() : 0;
+    case Mesh::TANGENT:
+        return m->hasTangents() ? m->getTangentsPointer() : 0;
+    case Mesh::BITANGENT:
+        return m->hasBitangents() ? m->getBitangentsPointer() : 0;
     }
+    return 0;
 }
 
-bool OptimizeTool::vertexNormalEquals(const Vertex& lhs, const Vertex& rhs, float eps)
+int OptimizeTool::getCellCoordinate(float value, float invCellSize)
 {
-    if(isInRange(lhs.normal[0], rhs.normal[0], eps) &&
-       isInRange(lhs.normal[1], rhs.normal[1], eps) &&
-       isInRange(lhs.normal[2], rhs.normal[2], eps) &&
-	   isInRange(lhs.normal[3], rhs.normal[3], eps))
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    float cell = floorf(value * invCellSize);
+
+    // NaN and far out values land in the outermost cells, which keeps
+    // the neighbour arithmetic in int range.
+    if(!(cell == cell))
+        return 0;
+    if(cell > 1073741824.0f)
+        return 1 << 30;
+    if(cell < -1073741824.0f)
+        return -(1 << 30);
+    return static_cast<int>(cell);
 }
-bool OptimizeTool::vertexTexCoordEquals(const Vertex& lhs, const Vertex& rhs, float eps)
+
+unsigned int OptimizeTool::hashCell(const int key[3], unsigned int exactHash)
 {
-    if(isInRange(lhs.texCoord[0], rhs.texCoord[0], eps) &&
-       isInRange(lhs.texCoord[1], rhs.texCoord[1], eps) &&
-	   isInRange(lhs.texCoord[2], rhs.texCoord[2], eps) &&
-       isInRange(lhs.texCoord[3], rhs.texCoord[3], eps))
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    unsigned int hash = exactHash;
+    hash ^= static_cast<unsigned int>(key[0]) * 73856093u;
+    hash ^= static_cast<unsigned int>(key[1]) * 19349663u;
+    hash ^= static_cast<unsigned int>(key[2]) * 83492791u;
+    hash ^= hash >> 15;
+    hash *= 2246822519u;
+    hash ^= hash >> 13;
+    return hash;
 }
 
-bool OptimizeTool::vertexTangentEquals(const Vertex& lhs, const Vertex& rhs, float eps)
+void OptimizeTool::getEnabledAttributes(Mesh* m, std::vector<AttributeData>& attributes)
 {
-    if(isInRange(lhs.tangent[0], rhs.tangent[0], eps) &&
-       isInRange(lhs.tangent[1], rhs.tangent[1], eps) &&
-       isInRange(lhs.tangent[2], rhs.tangent[2], eps) &&
-	   isInRange(lhs.tangent[3], rhs.tangent[3], eps))
-    {
-        return true;
-    }
-    else
+    static const Mesh::AttributeType types[5] = {Mesh::POSITION, Mesh::NORMAL, Mesh::TEXCOORD,
+                                                 Mesh::TANGENT, Mesh::BITANGENT};
+
+    attributes.clear();
+    for(int i = 0; i < 5; ++i)
     {
-        return false;
+        // Positions are always compared, present or not.
+        const float* data = types[i] == Mesh::POSITION ? m->getPositionsPointer()
+                                                       : getAttributePointer(m, types[i]);
+        if(data != 0)
+        {
+            AttributeData attribute = {data, m->getStride(types[i])};
+            attributes.push_back(attribute);
+        }
     }
 }
-bool OptimizeTool::vertexBitangentEquals(const Vertex& lhs, const Vertex& rhs, float eps)
+
+unsigned int OptimizeTool::hashVertex(const std::vector<AttributeData>& attributes,
+                                      unsigned int index)
 {
-    if(isInRange(lhs.bitangent[0], rhs.bitangent[0], eps) &&
-       isInRange(lhs.bitangent[1], rhs.bitangent[1], eps) &&
-       isInRange(lhs.bitangent[2], rhs.bitangent[2], eps) &&
-	   isInRange(lhs.bitangent[3], rhs.bitangent[3], eps))
-    {
-        return true;
-    }
-    else
+    // FNV-1a over the 32 bit patterns of all enabled components.
+    unsigned int hash = 2166136261u;
+    for(size_t i = 0; i < attributes.size(); ++i)
     {
-        return false;
+        const int stride = attributes[i].stride;
+        const float* data = &attributes[i].data[index*stride];
+        for(int j = 0; j < stride; ++j)
+        {
+            float value = data[j];
+            if(value == 0.0f)
+                value = 0.0f;
+
+            unsigned int bits = 0;
+            memcpy(&bits, &value, sizeof(bits));
+
+            hash ^= bits;
+            hash *= 16777619u;
+        }
     }
+    hash ^= hash >> 16;
+    return hash;
 }
 
-int OptimizeTool::findFirstIndexEqualsEps(std::vector<Vertex> verts, Vertex v, Mesh::AttributeType a, float e)
+bool OptimizeTool::vertexEquals(const std::vector<AttributeData>& attributes,
+                                unsigned int lhs, unsigned int rhs)
 {
-    float epsilon[5] = {0.0f};
-    switch(a)
+    for(size_t i = 0; i < attributes.size(); ++i)
     {
-    case Mesh::POSITION:
-        epsilon[0] = e;
-        break;
-    case Mesh::NORMAL:
-        epsilon[1] = e;
-        break;
-    case Mesh::TEXCOORD:
-        epsilon[2] = e;
-        break;
-    case Mesh::TANGENT:
-        epsilon[3] = e;
-        break;
-    case Mesh::BITANGENT:
-        epsilon[4] = e;
-        break;
+        const int stride = attributes[i].stride;
+        const float* l = &attributes[i].data[lhs*stride];
+        const float* r = &attributes[i].data[rhs*stride];
+        for(int j = 0; j < stride; ++j)
+        {
+            if(l[j] != r[j])
+                return false;
+        }
     }
+    return true;
+}
 
-    for(unsigned int i = 0; i < verts.size(); ++i)
-    {
+void OptimizeTool::stitch(Mesh *m)
+{
+    std::vector<AttributeData> attributes;
+    getEnabledAttributes(m, attributes);
+
+    unsigned int numVertices = static_cast<unsigned int>(m->getNumberOfVertices());
+    unsigned int numIndices = static_cast<unsigned int>(m->getNumberOfTriangles()*3);
+
+    // Open addressing table holding new vertex indices, at most half full.
+    unsigned int tableSize = 16;
+    while(tableSize < numVertices*2)
+        tableSize <<= 1;
+    std::vector<int> table(tableSize, -1);
+
+    // Every original vertex is hashed once; later corners reuse the result.
+    std::vector<int> oldToNew(numVertices, -1);
+    std::vector<unsigned int> newToOld;
+    std::vector<unsigned int> newIndices(numIndices);
 
-        if(vertexPosEquals(verts[i], v, epsilon[0]) &&
-           vertexNormalEquals(verts[i], v, epsilon[1]) &&
-           vertexTexCoordEquals(verts[i], v, epsilon[2]) &&
-           vertexTangentEquals(verts[i], v, epsilon[3]) &&
-           vertexBitangentEquals(verts[i], v, epsilon[4]))
+    const unsigned int* indices = numIndices > 0 ? m->getIndicesPointer() : 0;
+    for(unsigned int i = 0; i < numIndices; ++i)
+    {
+        unsigned int oldIndex = indices[i];
+        int index = oldToNew[oldIndex];
+        if(index < 0)
         {
-            return i;
+            unsigned int slot = hashVertex(attributes, oldIndex) & (tableSize-1);
+            while(table[slot] >= 0 &&
+                  vertexEquals(attributes, newToOld[table[slot]], oldIndex) == false)
+            {
+                slot = (slot+1) & (tableSize-1);
+            }
+            if(table[slot] < 0)
+            {
+                table[slot] = static_cast<int>(newToOld.size());
+                newToOld.push_back(oldIndex);
+            }
+            index = table[slot];
+            oldToNew[oldIndex] = index;
         }
+        newIndices[i] = index;
     }
-    return -1;
 
+    m->remapVertices(newToOld);
+    m->setIndices(newIndices);
 }
 
-bool OptimizeTool::vertexEquals(const Vertex& lhs, const Vertex& rhs)
+void OptimizeTool::stitch(Mesh *m, Mesh::AttributeType a, float epsilon)
 {
-    bool positionEqual = false;
-    bool normalEqual = false;
-    bool texureEqual = false;
-    bool tangentEqual = false;
-    bool bitangentEqual = false;
-
-    if(lhs.position[0] == rhs.position[0] &&
-       lhs.position[1] == rhs.position[1] &&
-       lhs.position[2] == rhs.position[2] &&
-	   lhs.position[3] == rhs.position[3])
-    {
-        positionEqual = true;
-    }
-    else
-    {
-        positionEqual = false;
-    }
-    if(lhs.normal[0] == rhs.normal[0] &&
-       lhs.normal[1] == rhs.normal[1] &&
-       lhs.normal[2] == rhs.normal[2] &&
-	   lhs.normal[3] == rhs.normal[3])
-    {
-        normalEqual = true;
-    }
-    else
-    {
-        normalEqual = false;
-    }
-    if(lhs.texCoord[0] == rhs.texCoord[0] &&
-       lhs.texCoord[1] == rhs.texCoord[1] &&
-	   lhs.texCoord[2] == rhs.texCoord[2] &&
-       lhs.texCoord[3] == rhs.texCoord[3])
-    {
-        texureEqual = true;
-    }
-    else
-    {
-        texureEqual = false;
-    }
-    if(lhs.tangent[0] == rhs.tangent[0] &&
-       lhs.tangent[1] == rhs.tangent[1] &&
-       lhs.tangent[2] == rhs.tangent[2] &&
-	   lhs.tangent[3] == rhs.tangent[3])
-    {
-        tangentEqual = true;
-    }
-    else
-    {
-        tangentEqual = false;
-    }
-    if(lhs.bitangent[0] == rhs.bitangent[0] &&
-       lhs.bitangent[1] == rhs.bitangent[1] &&
-       lhs.bitangent[2] == rhs.bitangent[2] &&
-	   lhs.bitangent[3] == rhs.bitangent[3])
-    {
-        bitangentEqual = true;
-    }
-    else
-    {
-        bitangentEqual = false;
-    }
-
-    if(positionEqual && normalEqual && texureEqual &&
-       tangentEqual && bitangentEqual)
-    {
-        return true;
-    }
-    else
+    // Without a tolerance (or without the attribute, which then compares
+    // as all zeros) this is the exact stitch.
+    const float* fuzzy = getAttributePointer(m, a);
+    if(fuzzy == 0 || epsilon <= 0.0f)
     {
-        return false;
+        stitch(m);
+        return;
     }
-}
 
-int OptimizeTool::findFirstIndexEquals(std::vector<Vertex> verts, Vertex v)
-{
+    const int stride = m->getStride(a);
 
-    for(unsigned int i = 0; i < verts.size(); ++i)
+    std::vector<AttributeData> exact;
+    getEnabledAttributes(m, exact);
+    for(size_t i = 0; i < exact.size(); ++i)
     {
-
-        if(vertexEquals(verts[i], v))
+        if(exact[i].data == fuzzy)
         {
-            return i;
+            exact.erase(exact.begin() + i);
+            break;
         }
     }
-    return -1;
-}
 
+    unsigned int numVertices = static_cast<unsigned int>(m->getNumberOfVertices());
+    unsigned int numIndices = static_cast<unsigned int>(m->getNumberOfTriangles()*3);
 
-void OptimizeTool::stitch(Mesh *m)
-{
-    std::vector<Vertex> origVertices;
-    getVertices(m, origVertices);
-    std::vector<Vertex> newVertices;
-    std::vector<unsigned int> newIndices;
+    // Cells are slightly larger than epsilon, so every vertex within
+    // epsilon of another one lies in the same or a neighbouring cell.
+    float invCellSize = 1.0f / (epsilon * 1.0001f);
 
-    newIndices.reserve((size_t)(m->getNumberOfTriangles()*3));
-    for(int i = 0; i < m->getNumberOfTriangles(); ++i)
-    {
-        const unsigned int* pTriangle = m->getTriangle(i);
-        newIndices.push_back(pTriangle[0]);
-        newIndices.push_back(pTriangle[1]);
-        newIndices.push_back(pTriangle[2]);
-    }
+    unsigned int tableSize = 16;
+    while(tableSize < numVertices*2)
+        tableSize <<= 1;
+    std::vector<int> table(tableSize, -1);
+    std::vector<GridCell> cells;
 
-    for(int i = 0; i < m->getNumberOfTriangles(); ++i)
+    std::vector<int> oldToNew(numVertices, -1);
+    std::vector<unsigned int> newToOld;
+    std::vector<int> next;
+    std::vector<unsigned int> newIndices(numIndices);
+
+    const unsigned int* indices = numIndices > 0 ? m->getIndicesPointer() : 0;
+    for(unsigned int i = 0; i < numIndices; ++i)
     {
-        const unsigned int* pTriangle = m->getTriangle(i);
-        for(int j = 0; j < 3; ++j)
+        unsigned int oldIndex = indices[i];
+        int index = oldToNew[oldIndex];
+        if(index < 0)
         {
-            Vertex v = origVertices[pTriangle[j]];
+            const float* value = &fuzzy[oldIndex*stride];
+            unsigned int exactHash = hashVertex(exact, oldIndex);
+            int key[3] = {0, 0, 0};
+            for(int k = 0; k < stride && k < 3; ++k)
+                key[k] = getCellCoordinate(value[k], invCellSize);
+
+            // Greedy first match: the lowest welded index within epsilon
+            // over all 27 neighbouring cells.
+            for(int dz = -1; dz <= 1; ++dz)
+            for(int dy = -1; dy <= 1; ++dy)
+            for(int dx = -1; dx <= 1; ++dx)
+            {
+                int neighbour[3] = {key[0]+dx, key[1]+dy, key[2]+dz};
+                unsigned int slot = hashCell(neighbour, exactHash) & (tableSize-1);
+                for(; table[slot] >= 0; slot = (slot+1) & (tableSize-1))
+                {
+                    const GridCell& cell = cells[table[slot]];
+                    if(cell.exactHash != exactHash || cell.key[0] != neighbour[0] ||
+                       cell.key[1] != neighbour[1] || cell.key[2] != neighbour[2])
+                    {
+                        continue;
+                    }
+                    for(int j = cell.head; j >= 0 && (index < 0 || j < index); j = next[j])
+                    {
+                        const float* other = &fuzzy[newToOld[j]*stride];
+                        bool inRange = true;
+                        for(int k = 0; k < stride && inRange; ++k)
+                            inRange = isInRange(other[k], value[k], epsilon);
+                        if(inRange && vertexEquals(exact, newToOld[j], oldIndex))
+                        {
+                            index = j;
+                            break;
+                        }
+                    }
+                    break;
+                }
+            }
 
-            int index = findFirstIndexEquals(newVertices, v);
             if(index < 0)
             {
-                index = static_cast<int>(newVertices.size());
-                newVertices.push_back(v);
+                index = static_cast<int>(newToOld.size());
+                newToOld.push_back(oldIndex);
+                next.push_back(-1);
+
+                unsigned int slot = hashCell(key, exactHash) & (tableSize-1);
+                for(; table[slot] >= 0; slot = (slot+1) & (tableSize-1))
+                {
+                    const GridCell& cell = cells[table[slot]];
+                    if(cell.exactHash == exactHash && cell.key[0] == key[0] &&
+                       cell.key[1] == key[1] && cell.key[2] == key[2])
+                    {
+                        break;
+                    }
+                }
+                if(table[slot] < 0)
+                {
+                    GridCell cell = {{key[0], key[1], key[2]}, exactHash, index, index};
+                    table[slot] = static_cast<int>(cells.size());
+                    cells.push_back(cell);
+                }
+                else
+                {
+                    GridCell& cell = cells[table[slot]];
+                    next[cell.tail] = index;
+                    cell.tail = index;
+                }
             }
-            newIndices[i*3+j] = index;
+            oldToNew[oldIndex] = index;
         }
+        newIndices[i] = index;
     }
 
-    m->clearVertices();
-    for(std::vector<Vertex>::iterator it = newVertices.begin(); it != newVertices.end(); ++it)
-    {
-        m->addPosition(it->position);
-		if(m->hasNormals())
-		{
-			m->addNormal(it->normal);
-		}
-		if(m->hasTexCoords())
-		{
-			m->addTexCoord(it->texCoord);
-		}
-		if(m->hasTangents())
-		{
-			m->addTangent(it->tangent);
-		}
-		if(m->hasBitangents())
-		{
-			m->addBitangent(it->bitangent);
-		}
+    m->remapVertices(newToOld);
+    m->setIndices(newIndices);
+}
+
+void OptimizeTool::optimizeIndices(Mesh* m, int cacheSize)
+{
+    int numVertices = m->getNumberOfVertices();
+    int numTriangles = m->getNumberOfTriangles();
+    if(numTriangles == 0)
+        return;
 
+    // Groups are reordered in place one after the other. Every group only
+    // looks at its own triangles, which keep their ids until the group is
+    // written, so the adjacency stays usable until the end.
+    const MeshAdjacency& adjacency = m->getAdjacency();
+
+    std::vector<int> liveTriangles(numVertices, 0);
+    std::vector<int> cachePosition(numVertices, -1);
+
+    if(m->getNumberOfGroups() == 0)
+    {
+        optimizeTriangleRange(m, 0, numTriangles, adjacency,
+                              liveTriangles, cachePosition, cacheSize);
     }
-    m->clearIndices();
-    for(std::vector<unsigned int>::iterator it = newIndices.begin(); it != newIndices.end(); ++it)
+    for(int i = 0; i < m->getNumberOfGroups(); ++i)
     {
-        m->addIndex(*it);
+        const Mesh::Group& g = m->getGroup(i);
+        int begin = g.startIndex/3;
+        optimizeTriangleRange(m, begin, begin + g.triangleCount, adjacency,
+                              liveTriangles, cachePosition, cacheSize);
     }
-
+    m->invalidateAdjacency();
 }
 
-void OptimizeTool::stitch(Mesh *m, Mesh::AttributeType a, float epsilon)
+void OptimizeTool::optimizeTriangleRange(Mesh* m, int begin, int end,
+                                         const MeshAdjacency& adjacency,
+                                         std::vector<int>& liveTriangles,
+                                         std::vector<int>& cachePosition,
+                                         int cacheSize)
 {
-    std::vector<Vertex> origVertices;
-    getVertices(m, origVertices);
+    int numTriangles = end - begin;
+    if(numTriangles <= 0)
+        return;
 
-    std::vector<Vertex> newVertices;
-    std::vector<unsigned int> newIndices;
+    unsigned int* indices = m->getIndicesPointer() + begin*3;
 
-    newIndices.reserve((size_t)(m->getNumberOfTriangles()*3));
-    for(int i = 0; i < m->getNumberOfTriangles(); ++i)
-    {
-        const unsigned int* pTriangle = m->getTriangle(i);
-        newIndices.push_back(pTriangle[0]);
-        newIndices.push_back(pTriangle[1]);
-        newIndices.push_back(pTriangle[2]);
-    }
+    for(int i = 0; i < numTriangles*3; ++i)
+        ++liveTriangles[indices[i]];
+
+    // Scores of the triangles outside the cache only depend on the live
+    // triangle counts, which only go down and so only raise the scores.
+    // The heap gets a new entry whenever such a score changes; stale
+    // entries are skipped when popped.
+    std::priority_queue<std::pair<float, int> > fallback;
+    for(int i = 0; i < numTriangles; ++i)
+        fallback.push(std::make_pair(getTriangleScore(&indices[i*3], liveTriangles, cacheSize), i));
+
+    std::vector<char> emitted(numTriangles, 0);
+    std::vector<unsigned int> output;
+    output.reserve(numTriangles*3);
 
-    for(int i = 0; i < m->getNumberOfTriangles(); ++i)
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> newCache;
+    cache.reserve(cacheSize+3);
+    newCache.reserve(cacheSize+3);
+
+    int best = -1;
+    for(int n = 0; n < numTriangles; ++n)
     {
-        const unsigned int* pTriangle = m->getTriangle(i);
-        for(int j = 0; j < 3; ++j)
+        while(best < 0)
         {
-            Vertex v = origVertices[pTriangle[j]];
+            // Nothing adjacent to the cache left, take the best remaining
+            // triangle.
+            std::pair<float, int> top = fallback.top();
+            fallback.pop();
+            if(emitted[top.second] == 0 &&
+               top.first == getTriangleScore(&indices[top.second*3], liveTriangles, cacheSize))
+            {
+                best = top.second;
+            }
+        }
 
-            int index = findFirstIndexEqualsEps(newVertices, v, a, epsilon);
-            if(index < 0)
+        const unsigned int* triangle = &indices[best*3];
+        output.push_back(triangle[0]);
+        output.push_back(triangle[1]);
+        output.push_back(triangle[2]);
+        emitted[best] = 1;
+
+        newCache.clear();
+        for(int k = 0; k < 3; ++k)
+        {
+            --liveTriangles[triangle[k]];
+            if(std::find(newCache.begin(), newCache.end(), triangle[k]) == newCache.end())
+                newCache.push_back(triangle[k]);
+        }
+        for(int k = 0; k < 3; ++k)
+        {
+            const unsigned int* triangles = adjacency.getVertexTriangles(triangle[k]);
+            const int numVertexTriangles = adjacency.getVertexTriangleCount(triangle[k]);
+            for(int j = 0; j < numVertexTriangles; ++j)
             {
-                index = static_cast<int>(newVertices.size());
-                newVertices.push_back(v);
+                int t = static_cast<int>(triangles[j]) - begin;
+                if(t >= 0 && t < numTriangles && emitted[t] == 0)
+                    fallback.push(std::make_pair(getTriangleScore(&indices[t*3], liveTriangles, cacheSize), t));
             }
-            newIndices[i*3+j] = index;
         }
+        for(size_t k = 0; k < cache.size(); ++k)
+        {
+            unsigned int v = cache[k];
+            if(v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache.push_back(v);
+        }
+
+        for(size_t k = 0; k < newCache.size(); ++k)
+            cachePosition[newCache[k]] = k < (size_t)cacheSize ? static_cast<int>(k) : -1;
+
+        // Rescore the triangles around every vertex whose position changed
+        // and pick the best one that still touches the cache.
+        best = -1;
+        float bestScore = -1.0f;
+        for(size_t k = 0; k < newCache.size(); ++k)
+        {
+            unsigned int v = newCache[k];
+            const unsigned int* triangles = adjacency.getVertexTriangles(v);
+            const int numVertexTriangles = adjacency.getVertexTriangleCount(v);
+            for(int j = 0; j < numVertexTriangles; ++j)
+            {
+                int t = static_cast<int>(triangles[j]) - begin;
+                if(t < 0 || t >= numTriangles || emitted[t])
+                    continue;
+
+                const unsigned int* other = &indices[t*3];
+                float score = 0.0f;
+                for(int c = 0; c < 3; ++c)
+                    score += getVertexScore(cachePosition[other[c]], liveTriangles[other[c]], cacheSize);
+
+                if(cachePosition[v] >= 0 && score > bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+
+        if(newCache.size() > (size_t)cacheSize)
+            newCache.resize(cacheSize);
+        cache.swap(newCache);
     }
 
-    m->clearVertices();
-    for(std::vector<Vertex>::iterator it = newVertices.begin(); it != newVertices.end(); ++it)
+    for(size_t k = 0; k < cache.size(); ++k)
+        cachePosition[cache[k]] = -1;
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeTool::optimizeVertices(Mesh* m)
+{
+    unsigned int numVertices = static_cast<unsigned int>(m->getNumberOfVertices());
+    unsigned int numIndices = static_cast<unsigned int>(m->getNumberOfTriangles()*3);
+    if(numIndices == 0)
+        return;
+
+    unsigned int* indices = m->getIndicesPointer();
+
+    std::vector<int> oldToNew(numVertices, -1);
+    std::vector<unsigned int> newToOld;
+    newToOld.reserve(numVertices);
+
+    for(unsigned int i = 0; i < numIndices; ++i)
     {
-        m->addPosition(it->position);
-		if(m->hasNormals())
-		{
-			m->addNormal(it->normal);
-		}
-		if(m->hasTexCoords())
-		{
-			m->addTexCoord(it->texCoord);
-		}
-		if(m->hasTangents())
-		{
-			m->addTangent(it->tangent);
-		}
-		if(m->hasBitangents())
-		{
-			m->addBitangent(it->bitangent);
-		}
+        unsigned int oldIndex = indices[i];
+        if(oldToNew[oldIndex] < 0)
+        {
+            oldToNew[oldIndex] = static_cast<int>(newToOld.size());
+            newToOld.push_back(oldIndex);
+        }
+        indices[i] = oldToNew[oldIndex];
     }
-    m->clearIndices();
-    for(std::vector<unsigned int>::iterator it = newIndices.begin(); it != newIndices.end(); ++it)
+    for(unsigned int i = 0; i < numVertices; ++i)
     {
-        m->addIndex(*it);
+        if(oldToNew[i] < 0)
+            newToOld.push_back(i);
     }
 
+    m->remapVertices(newToOld);
 }
 
-void OptimizeTool::getVertices(assembly3d::Mesh *m,
-                               std::vector<OptimizeTool::Vertex>& vertices)
+void OptimizeTool::analyzeVertexCache(Mesh* m, int cacheSize, float& acmr, float& atvr)
 {
-    vertices.clear();
-    for(int i = 0; i < m->getNumberOfVertices(); ++i)
-    {
-        Vertex vert = {{0.0f,0.0f,0.0f,0.0f},
-                       {0.0f,0.0f,0.0f,0.0f},
-                       {0.0f,0.0f,0.0f,0.0f},
-                       {0.0f,0.0f,0.0f,0.0f},
-                       {0.0f,0.0f,0.0f,0.0f}};
-
-        vert.position[0] = m->getPosition(i)[0];
-        vert.position[1] = m->getPosition(i)[1];
-        vert.position[2] = m->getPosition(i)[2];
-		vert.position[3] = m->getPosition(i)[3];
-
-		if(m->hasNormals())
-		{
-			vert.normal[0] = m->getNormal(i)[0];
-			vert.normal[1] = m->getNormal(i)[1];
-			vert.normal[2] = m->getNormal(i)[2];
-			vert.normal[3] = m->getNormal(i)[3];
-		}
-
-		if(m->hasTexCoords())
-		{
-			vert.texCoord[0] = m->getTexCoord(i)[0];
-			vert.texCoord[1] = m->getTexCoord(i)[1];
-			vert.texCoord[2] = m->getTexCoord(i)[2];
-			vert.texCoord[3] = m->getTexCoord(i)[3];
-		}
-		if(m->hasTangents())
-		{
-			vert.tangent[0] = m->getTangent(i)[0];
-			vert.tangent[1] = m->getTangent(i)[1];
-			vert.tangent[2] = m->getTangent(i)[2];
-			vert.tangent[3] = m->getTangent(i)[3];
-		}
-
-		if(m->hasBitangents())
-		{
-			vert.bitangent[0] = m->getBitangent(i)[0];
-			vert.bitangent[1] = m->getBitangent(i)[1];
-			vert.bitangent[2] = m->getBitangent(i)[2];
-			vert.bitangent[3] = m->getBitangent(i)[3];
-		}
-        vertices.push_back(vert);
+    int numVertices = m->getNumberOfVertices();
+    int numIndices = m->getNumberOfTriangles()*3;
+
+    acmr = 0.0f;
+    atvr = 0.0f;
+    if(numIndices == 0 || numVertices == 0)
+        return;
+
+    // A vertex is in the FIFO if fewer than cacheSize misses happened
+    // since it was last loaded.
+    const unsigned int* indices = m->getIndicesPointer();
+    std::vector<unsigned int> timestamp(numVertices, 0);
+    unsigned int time = cacheSize + 1;
+    int misses = 0;
+    for(int i = 0; i < numIndices; ++i)
+    {
+        unsigned int v = indices[i];
+        if(time - timestamp[v] > (unsigned int)cacheSize)
+        {
+            timestamp[v] = time++;
+            ++misses;
+        }
     }
-}
 
+    acmr = static_cast<float>(misses) / static_cast<float>(numIndices/3);
+    atvr = static_cast<float>(misses) / static_cast<float>(numVertices);
+}
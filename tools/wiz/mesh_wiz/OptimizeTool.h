@@ -47,6 +47,11 @@ namespace assembly3d
         class OptimizeTool
         {
         public:
+            /**
+             * @brief Vertex cache size optimizeIndices scores for by default.
+             */
+            static const int VERTEX_CACHE_SIZE = 32;
+
             OptimizeTool();
             ~OptimizeTool();
 
@@ -64,39 +69,104 @@ namespace assembly3d
              * @param epsilon
              */
             void stitch(Mesh* m, Mesh::AttributeType a, float epsilon);
+            /**
+             * @brief Reorders triangles for the post-transform vertex cache.
+             *
+             * Uses Tom Forsyth's linear-speed vertex cache optimisation on
+             * every group separately, so group ranges stay valid.
+             *
+             * @param m The mesh to work on.
+             * @param cacheSize Size of the simulated LRU cache.
+             */
+            void optimizeIndices(Mesh* m, int cacheSize=VERTEX_CACHE_SIZE);
+            /**
+             * @brief Reorders vertices for the GPU pre-transform cache.
+             *
+             * Renumbers vertices in the order the index stream first uses
+             * them. Unreferenced vertices are kept at the end.
+             *
+             * @param m The mesh to work on.
+             */
+            void optimizeVertices(Mesh* m);
+            /**
+             * @brief Simulates a FIFO vertex cache over the index stream.
+             *
+             * @param m The mesh to analyze.
+             * @param cacheSize Size of the simulated FIFO cache.
+             * @param acmr Average cache miss ratio (misses per triangle).
+             * @param atvr Average transformed vertex ratio (misses per vertex).
+             */
+            void analyzeVertexCache(Mesh* m, int cacheSize, float& acmr, float& atvr);
 
         protected:
         private:
-            struct Vertex
+            /**
+             * @brief Cell of the epsilon grid used by the epsilon stitch.
+             *
+             * Welded vertices are chained in ascending order, so the first
+             * match found in a cell is the lowest index of that cell.
+             */
+            struct GridCell
             {
-                float position[4];
-                float normal[4];
-                float texCoord[4];
-                float tangent[4];
-                float bitangent[4];
+                int key[3];
+                unsigned int exactHash;
+                int head;
+                int tail;
+            };
+            /**
+             * @brief Data pointer of an enabled attribute and its stride.
+             */
+            struct AttributeData
+            {
+                const float* data;
+                int stride;
             };
-
-            void getVertices(Mesh *m, std::vector<OptimizeTool::Vertex>& vertices);
 
             bool isInRange(float lhs, float rhs, float eps);
 
-            bool vertexPosEquals(const OptimizeTool::Vertex& lhs,
-                                 const OptimizeTool::Vertex& rhs, float eps);
-            bool vertexNormalEquals(const OptimizeTool::Vertex& lhs,
-                                    const OptimizeTool::Vertex& rhs, float eps);
-            bool vertexTexCoordEquals(const OptimizeTool::Vertex& lhs,
-                                      const OptimizeTool::Vertex& rhs, float eps);
-            bool vertexTangentEquals(const OptimizeTool::Vertex& lhs,
-                                     const OptimizeTool::Vertex& rhs, float eps);
-            bool vertexBitangentEquals(const OptimizeTool::Vertex& lhs,
-                                       const OptimizeTool::Vertex& rhs, float eps);
-            int findFirstIndexEqualsEps(std::vector<OptimizeTool::Vertex> verts,
-                                        OptimizeTool::Vertex v,
-                                        Mesh::AttributeType a, float e);
-            bool vertexEquals(const OptimizeTool::Vertex& lhs,
-                              const OptimizeTool::Vertex& rhs);
-            int findFirstIndexEquals(std::vector<OptimizeTool::Vertex> verts,
-                                     OptimizeTool::Vertex v);
+            /**
+             * @brief Reorders the triangles [begin, end) of the mesh.
+             *
+             * @param m The mesh to work on.
+             * @param begin First triangle of the range.
+             * @param end One past the last triangle of the range.
+             * @param adjacency Adjacency of the whole mesh.
+             * @param liveTriangles Zeroed scratch buffer, one entry per vertex.
+             * @param cachePosition Scratch buffer filled with -1, one entry per vertex.
+             * @param cacheSize Size of the simulated LRU cache.
+             */
+            void optimizeTriangleRange(Mesh* m, int begin, int end,
+                                       const MeshAdjacency& adjacency,
+                                       std::vector<int>& liveTriangles,
+                                       std::vector<int>& cachePosition,
+                                       int cacheSize);
+
+            /**
+             * @brief Gets the data pointer of an enabled attribute.
+             *
+             * @return Data pointer or 0 if the mesh has no such attribute.
+             */
+            const float* getAttributePointer(Mesh* m, Mesh::AttributeType a);
+            int getCellCoordinate(float value, float invCellSize);
+            unsigned int hashCell(const int key[3], unsigned int exactHash);
+
+            /**
+             * @brief Collects the data pointers of all enabled attributes.
+             *
+             * @param m The mesh to read from.
+             * @param attributes Vector to write the data pointers and strides in.
+             */
+            void getEnabledAttributes(Mesh* m, std::vector<AttributeData>& attributes);
+            /**
+             * @brief Hashes the bit patterns of a vertex's enabled attributes.
+             *
+             * -0.0f is hashed as 0.0f, so that vertices comparing equal
+             * always hash equal.
+             */
+            unsigned int hashVertex(const std::vector<AttributeData>& attributes,
+                                    unsigned int index);
+            bool vertexEquals(const std::vector<AttributeData>& attributes,
+                              unsigned int lhs, unsigned int rhs);
 
         };
     }
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshWizIncludes.h"
+#include "PartitionTool.h"
+#include <cstring>
+#include <sstream>
+
+using namespace assembly3d;
+using namespace assembly3d::wiz;
+
+PartitionTool::PartitionTool()
+{
+}
+
+PartitionTool::~PartitionTool()
+{
+}
+
+bool PartitionTool::partition(Mesh* mesh, int maxVertices, std::string& resultMsg)
+{
+    const int numGroups = mesh->getNumberOfGroups();
+    const int numVertices = mesh->getNumberOfVertices();
+    const unsigned int* indices = mesh->getNumberOfTriangles() > 0 ? mesh->getIndicesPointer() : 0;
+
+    bool fits = true;
+    for(int i = 0; i < numGroups && fits; ++i)
+    {
+        const Mesh::Group& g = mesh->getGroup(i);
+        if(g.triangleCount <= 0)
+            continue;
+        unsigned int lowest = indices[g.startIndex];
+        unsigned int highest = indices[g.startIndex];
+        for(int k = 1; k < g.triangleCount*3; ++k)
+        {
+            lowest = std::min(lowest, indices[g.startIndex + k]);
+            highest = std::max(highest, indices[g.startIndex + k]);
+        }
+        fits = (int)(highest - lowest) < maxVertices;
+    }
+    if(fits || maxVertices < 3)
+        return false;
+
+    // part[v] is the part the old vertex v was last copied to, local[v]
+    // its new index there.
+    std::vector<int> part(numVertices, -1);
+    std::vector<unsigned int> local(numVertices, 0);
+    std::vector<char> used(numVertices, 0);
+    std::vector<unsigned int> newToOld;
+    std::vector<unsigned int> newIndices;
+    std::vector<Mesh::Group> newGroups;
+    std::vector<int> sourceGroups;
+    newIndices.reserve(mesh->getNumberOfTriangles()*3);
+
+    int currentPart = 0;
+    size_t partBegin = 0;
+    int numUsed = 0;
+    for(int i = 0; i < numGroups; ++i)
+    {
+        Mesh::Group g = mesh->getGroup(i);
+        const unsigned int* first = indices + g.startIndex;
+        const int triangleCount = g.triangleCount;
+
+        g.startIndex = static_cast<int>(newIndices.size());
+        g.triangleCount = 0;
+        for(int t = 0; t < triangleCount; ++t)
+        {
+            const unsigned int* tri = first + t*3;
+            int added = 0;
+            for(int k = 0; k < 3; ++k)
+            {
+                if(part[tri[k]] != currentPart && (k == 0 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+                    ++added;
+            }
+            if(newToOld.size() - partBegin + added > (size_t)maxVertices)
+            {
+                if(g.triangleCount > 0)
+                {
+                    newGroups.push_back(g);
+                    sourceGroups.push_back(i);
+                    g.startIndex = static_cast<int>(newIndices.size());
+                    g.triangleCount = 0;
+                }
+                ++currentPart;
+                partBegin = newToOld.size();
+            }
+
+            for(int k = 0; k < 3; ++k)
+            {
+                const unsigned int v = tri[k];
+                if(part[v] != currentPart)
+                {
+                    part[v] = currentPart;
+                    local[v] = static_cast<unsigned int>(newToOld.size());
+                    newToOld.push_back(v);
+                    if(used[v] == 0)
+                    {
+                        used[v] = 1;
+                        ++numUsed;
+                    }
+                }
+                newIndices.push_back(local[v]);
+            }
+            ++g.triangleCount;
+        }
+        if(g.triangleCount > 0 || triangleCount <= 0)
+        {
+            newGroups.push_back(g);
+            sourceGroups.push_back(i);
+        }
+    }
+
+    // Parts of a split group are named <name>_<part>, so group names stay
+    // unique.
+    for(size_t first = 0, last = 0; first < newGroups.size(); first = last)
+    {
+        while(last < newGroups.size() && sourceGroups[last] == sourceGroups[first])
+            ++last;
+        if(last - first == 1)
+            continue;
+
+        for(size_t k = first; k < last; ++k)
+        {
+            std::stringstream name;
+            name << newGroups[k].name << "_" << k - first;
+            std::string tmpGroupName = name.str();
+
+            newGroups[k].name = new char[tmpGroupName.length()+1];
+            newGroups[k].name[tmpGroupName.length()] = 0;
+            memcpy(newGroups[k].name, tmpGroupName.c_str(), tmpGroupName.size());
+        }
+    }
+
+    mesh->remapVertices(newToOld);
+    mesh->setIndices(newIndices);
+    mesh->setGroups(newGroups);
+
+    std::stringstream msg;
+    msg << numGroups << " groups split into " << newGroups.size() << " groups of at most "
+        << maxVertices << " vertices, " << newToOld.size() - numUsed << " vertices copied";
+    resultMsg = msg.str();
+
+    return true;
+}
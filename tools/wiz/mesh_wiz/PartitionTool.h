@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _PARTITIONTOOL_H_
+#define _PARTITIONTOOL_H_
+
+#include <string>
+#include "Mesh.h"
+
+namespace assembly3d
+{
+    namespace wiz
+    {
+        /**
+         * @brief Class for splitting groups to fit narrow index types.
+         *
+        */
+        class PartitionTool
+        {
+        public:
+            PartitionTool();
+            ~PartitionTool();
+
+            /**
+             * @brief Splits groups into parts of at most maxVertices vertices.
+             *
+             * Does nothing if every group already spans fewer vertices.
+             * Otherwise the vertices are reordered into consecutive ranges,
+             * one per part, in the order the triangles use them. Vertices
+             * used by several parts are duplicated, unused ones dropped.
+             * A group spread over several parts is split into groups
+             * named <name>_0, <name>_1 and so on. The triangle order is
+             * kept.
+             *
+             * @param mesh The mesh to work on.
+             * @param maxVertices Largest number of vertices of a part.
+             * @param resultMsg Receives the number of groups and copied vertices.
+             * @return True if the mesh has been partitioned.
+             */
+            bool partition(Mesh* mesh, int maxVertices, std::string& resultMsg);
+        };
+    }
+}
+
+#endif  // _PARTITIONTOOL_H_
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshWizIncludes.h"
+#include "QuantizeTool.h"
+#include "Quantization.h"
+#include <cmath>
+#include <sstream>
+
+using namespace assembly3d;
+using namespace assembly3d::wiz;
+
+// Largest difference of any component after encoding and decoding.
+static float measureError(Quantization::Encoding encoding, const Mesh::Attribute& attribute, int size,
+                          std::vector<unsigned char>& block, std::vector<float>& decoded)
+{
+    float minimum[4];
+    float maximum[4];
+    bool ranged = Quantization::usesRange(encoding);
+    if(ranged)
+        Quantization::computeRange(attribute.data, attribute.count, size, attribute.stride, minimum, maximum);
+
+    Quantization::encode(encoding, attribute.data, attribute.count, size, attribute.stride,
+                         ranged ? minimum : 0, ranged ? maximum : 0, block);
+    decoded.resize((size_t)attribute.count*attribute.stride);
+    Quantization::decode(encoding, &block[0], attribute.count, size, attribute.stride,
+                         ranged ? minimum : 0, ranged ? maximum : 0, &decoded[0]);
+
+    float error = 0.0f;
+    for(int i = 0; i < attribute.count; ++i)
+    {
+        for(int c = 0; c < size; ++c)
+        {
+            size_t k = (size_t)i*attribute.stride + c;
+            float difference = fabsf(decoded[k] - attribute.data[k]);
+            // NaN never fits.
+            if((difference <= error) == false)
+                error = difference;
+        }
+    }
+    return error;
+}
+
+QuantizeTool::QuantizeTool()
+{
+}
+
+QuantizeTool::~QuantizeTool()
+{
+}
+
+void QuantizeTool::quantize(Mesh* mesh, float maxError, std::string& resultMsg)
+{
+    const char* attributeNames[5] = {"POSITION", "NORMAL", "TEXCOORD", "TANGENT", "BITANGENT"};
+    const Mesh::AttributeType attributeTypes[5] = {Mesh::POSITION, Mesh::NORMAL, Mesh::TEXCOORD,
+                                                   Mesh::TANGENT, Mesh::BITANGENT};
+    Mesh::MeshFormat& format = mesh->getMeshFormat();
+    const int numVertices = mesh->getNumberOfVertices();
+
+    std::stringstream strStr;
+    std::vector<unsigned char> block;
+    std::vector<float> decoded;
+    int sizeBefore = 0;
+    int sizeAfter = 0;
+    for(int i = 0; i < 5; ++i)
+    {
+        int idx = mesh->getAttributeIndexWithName(attributeNames[i]);
+        if(idx < 0)
+            continue;
+
+        const int size = std::min(format.attributeSize[idx], 4);
+        Mesh::Attribute attribute = mesh->getAttribute(attributeTypes[i]);
+        attribute.count = numVertices;
+
+        float scale = 1.0f;
+        if(attributeTypes[i] == Mesh::POSITION)
+        {
+            float minimum[4];
+            float maximum[4];
+            Quantization::computeRange(attribute.data, numVertices, size, attribute.stride, minimum, maximum);
+            float diagonal = 0.0f;
+            for(int c = 0; c < size; ++c)
+                diagonal += (maximum[c] - minimum[c])*(maximum[c] - minimum[c]);
+            scale = diagonal > 0.0f ? sqrtf(diagonal) : 1.0f;
+        }
+
+        // Cheapest first, octahedral encodings only for directions.
+        std::vector<Quantization::Encoding> candidates;
+        candidates.push_back(Quantization::BYTE_NORM);
+        if(size >= 3 && attributeTypes[i] != Mesh::POSITION && attributeTypes[i] != Mesh::TEXCOORD)
+        {
+            candidates.push_back(Quantization::OCT_BYTE);
+            candidates.push_back(Quantization::OCT_SHORT);
+        }
+        candidates.push_back(Quantization::SHORT_NORM);
+        candidates.push_back(Quantization::HALF_FLOAT);
+        for(size_t a = 1; a < candidates.size(); ++a)
+        {
+            for(size_t b = a; b > 0 && Quantization::getVertexSize(candidates[b], size) <
+                                        Quantization::getVertexSize(candidates[b-1], size); --b)
+                std::swap(candidates[b], candidates[b-1]);
+        }
+
+        Quantization::Encoding chosen = Quantization::FLOAT;
+        float error = 0.0f;
+        for(size_t c = 0; c < candidates.size() && numVertices > 0; ++c)
+        {
+            float e = measureError(candidates[c], attribute, size, block, decoded) / scale;
+            if(e <= maxError)
+            {
+                chosen = candidates[c];
+                error = e;
+                break;
+            }
+        }
+
+        format.attributeType[idx] = Quantization::getTypeName(chosen);
+        sizeBefore += Quantization::getBlockSize(Quantization::FLOAT, size, numVertices);
+        sizeAfter += Quantization::getBlockSize(chosen, size, numVertices);
+        strStr << attributeNames[i] << ": " << Quantization::getTypeName(chosen) << ", error " << error << "\n";
+    }
+    strStr << "Vertex data " << sizeBefore << " -> " << sizeAfter << " bytes";
+    resultMsg = strStr.str();
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _QUANTIZETOOL_H_
+#define _QUANTIZETOOL_H_
+
+#include <string>
+#include "Mesh.h"
+
+namespace assembly3d
+{
+    namespace wiz
+    {
+        /**
+         * @brief Class for choosing the storage encodings of vertex attributes.
+         *
+        */
+        class QuantizeTool
+        {
+        public:
+            QuantizeTool();
+            ~QuantizeTool();
+
+            /**
+             * @brief Sets every attribute to its smallest encoding within an error bound.
+             *
+             * Each encoding is tried by encoding and decoding the data. For
+             * positions the error is relative to the bounding box diagonal,
+             * for the other attributes it is absolute.
+             *
+             * @param mesh The mesh to work on.
+             * @param maxError Largest error per component.
+             * @param resultMsg Receives the chosen encodings.
+             */
+            void quantize(Mesh* mesh, float maxError, std::string& resultMsg);
+        };
+    }
+}
+
+#endif  // _QUANTIZETOOL_H_
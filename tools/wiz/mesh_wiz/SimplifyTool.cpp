@@ -0,0 +1,900 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshWizIncludes.h"
+#include "SimplifyTool.h"
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <queue>
+#include <algorithm>
+#include <iterator>
+
+using namespace assembly3d;
+using namespace assembly3d::wiz;
+
+namespace
+{
+    // Position, texture coordinate and normal.
+    const int MAX_DIMENSION = 8;
+    const int PACKED_SIZE = MAX_DIMENSION*(MAX_DIMENSION+1)/2;
+
+    // Attribute scales against positions normalized to a unit diagonal.
+    const float TEXCOORD_WEIGHT = 1.0f;
+    const float NORMAL_WEIGHT = 0.5f;
+    // Weight of the planes keeping open borders in place.
+    const double BORDER_WEIGHT = 10.0;
+
+    /**
+     * @brief Quadric over positions and attributes, upper triangle of A packed by rows.
+     *
+     * Error of a point x is x^T A x + 2 b^T x + c, weight is the summed
+     * triangle area.
+     */
+    struct Quadric
+    {
+        float a[PACKED_SIZE];
+        float b[MAX_DIMENSION];
+        float c;
+        float weight;
+    };
+
+    void clearQuadric(Quadric& q)
+    {
+        memset(&q, 0, sizeof(Quadric));
+    }
+
+    void addQuadric(Quadric& q, const Quadric& r)
+    {
+        for(int i = 0; i < PACKED_SIZE; ++i)
+            q.a[i] += r.a[i];
+        for(int i = 0; i < MAX_DIMENSION; ++i)
+            q.b[i] += r.b[i];
+        q.c += r.c;
+        q.weight += r.weight;
+    }
+
+    template<int N>
+    double evaluateQuadric(const Quadric& q, const float* x)
+    {
+        double result = q.c;
+        int k = 0;
+        for(int i = 0; i < N; ++i)
+        {
+            double r = q.b[i] + 0.5 * q.a[k++] * x[i];
+            for(int j = i+1; j < N; ++j)
+                r += (double)q.a[k++] * x[j];
+            result += 2.0 * r * x[i];
+        }
+        return result;
+    }
+
+    double evaluateQuadric(const Quadric& q, const float* x, int n)
+    {
+        switch(n)
+        {
+        case 3: return evaluateQuadric<3>(q, x);
+        case 5: return evaluateQuadric<5>(q, x);
+        case 6: return evaluateQuadric<6>(q, x);
+        default: return evaluateQuadric<8>(q, x);
+        }
+    }
+
+    // Quadric of the distance to the plane spanned by the triangle in n
+    // dimensions, weighted by its area in position space.
+    void addTriangleQuadric(Quadric& q, const float* p0, const float* p1, const float* p2, int n)
+    {
+        double e1[MAX_DIMENSION];
+        double e2[MAX_DIMENSION];
+        double l1 = 0.0;
+        for(int i = 0; i < n; ++i)
+        {
+            e1[i] = (double)p1[i] - p0[i];
+            e2[i] = (double)p2[i] - p0[i];
+            l1 += e1[i]*e1[i];
+        }
+
+        double cross[3] = {e1[1]*e2[2] - e1[2]*e2[1],
+                           e1[2]*e2[0] - e1[0]*e2[2],
+                           e1[0]*e2[1] - e1[1]*e2[0]};
+        double area = 0.5 * sqrt(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+        if(area <= 0.0 || l1 <= 0.0)
+            return;
+
+        l1 = sqrt(l1);
+        double d = 0.0;
+        for(int i = 0; i < n; ++i)
+        {
+            e1[i] /= l1;
+            d += e1[i]*e2[i];
+        }
+        double l2 = 0.0;
+        for(int i = 0; i < n; ++i)
+        {
+            e2[i] -= d*e1[i];
+            l2 += e2[i]*e2[i];
+        }
+        if(l2 <= 0.0)
+            return;
+        l2 = sqrt(l2);
+
+        double pe1 = 0.0, pe2 = 0.0, pp = 0.0;
+        for(int i = 0; i < n; ++i)
+        {
+            e2[i] /= l2;
+            pe1 += p0[i]*e1[i];
+            pe2 += p0[i]*e2[i];
+            pp += (double)p0[i]*p0[i];
+        }
+
+        int k = 0;
+        for(int i = 0; i < n; ++i)
+        {
+            for(int j = i; j < n; ++j)
+                q.a[k++] += (float)(area * ((i == j ? 1.0 : 0.0) - e1[i]*e1[j] - e2[i]*e2[j]));
+            q.b[i] += (float)(area * (pe1*e1[i] + pe2*e2[i] - p0[i]));
+        }
+        q.c += (float)(area * (pp - pe1*pe1 - pe2*pe2));
+        q.weight += (float)area;
+    }
+
+    // Quadric of the distance to a plane in position space.
+    void addPlaneQuadric(Quadric& q, const double* normal, double d, double weight, int n)
+    {
+        int k = 0;
+        for(int i = 0; i < 3; ++i)
+        {
+            for(int j = i; j < n; ++j, ++k)
+            {
+                if(j < 3)
+                    q.a[k] += (float)(weight * normal[i]*normal[j]);
+            }
+            q.b[i] += (float)(weight * d*normal[i]);
+        }
+        q.c += (float)(weight * d*d);
+    }
+
+    struct PositionLess
+    {
+        explicit PositionLess(const float* positions) : p(positions) {}
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            return std::lexicographical_compare(p + a*3, p + a*3 + 3, p + b*3, p + b*3 + 3);
+        }
+        const float* p;
+    };
+
+    struct Candidate
+    {
+        float cost;
+        unsigned int vertex;
+        unsigned int target;
+        unsigned int version;
+
+        // Smallest cost first in std::priority_queue.
+        bool operator<(const Candidate& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    /**
+     * @brief Collapse state of one mesh, can be run repeatedly for a chain
+     * of levels.
+     */
+    class Simplifier
+    {
+    public:
+        explicit Simplifier(Mesh* mesh);
+
+        float run(int targetTriangles, float maxError);
+        int getNumberOfTriangles() const { return m_numLiveTriangles; }
+        /**
+         * @brief Remaining triangles, group by group.
+         */
+        void getIndices(std::vector<unsigned int>& indices, std::vector<int>& groupCounts) const;
+
+    private:
+        double getCost(unsigned int v, unsigned int u) const;
+        bool findCandidate(unsigned int v, Candidate& candidate) const;
+        bool findValidCandidate(unsigned int v, Candidate& candidate);
+        bool isValidCollapse(unsigned int v, unsigned int u);
+        void gatherNeighbours(unsigned int v, std::vector<unsigned int>& neighbours) const;
+        int countSharedTriangles(unsigned int v, unsigned int u) const;
+        void collapse(unsigned int v, unsigned int u);
+
+        const float* getPoint(unsigned int v) const { return &m_points[(size_t)v*m_dimension]; }
+
+        int m_dimension;
+        int m_numLiveTriangles;
+        float m_error;
+
+        std::vector<float> m_points;
+        std::vector<unsigned int> m_indices;
+        std::vector<char> m_liveTriangles;
+        std::vector<float> m_triangleNormals;
+        std::vector<std::pair<int, int> > m_groupRanges;
+
+        std::vector<Quadric> m_quadrics;
+        std::vector<std::vector<unsigned int> > m_vertexTriangles;
+        std::vector<char> m_locked;
+        std::vector<char> m_border;
+        std::vector<char> m_removed;
+        std::vector<unsigned int> m_versions;
+
+        std::priority_queue<Candidate> m_queue;
+
+        // Scratch space of the serial collapse loop.
+        std::vector<unsigned int> m_neighbours;
+        std::vector<unsigned int> m_targetNeighbours;
+        std::vector<unsigned int> m_common;
+        std::vector<std::pair<double, unsigned int> > m_costs;
+    };
+
+    Simplifier::Simplifier(Mesh* mesh)
+        : m_dimension(3),
+          m_numLiveTriangles(mesh->getNumberOfTriangles()),
+          m_error(0.0f)
+    {
+        const int numVertices = mesh->getNumberOfVertices();
+        const int numTriangles = mesh->getNumberOfTriangles();
+        const bool texCoords = mesh->hasTexCoords();
+        const bool normals = mesh->hasNormals();
+        if(texCoords)
+            m_dimension += 2;
+        if(normals)
+            m_dimension += 3;
+
+        if(numTriangles > 0)
+            m_indices.assign(mesh->getIndicesPointer(), mesh->getIndicesPointer() + numTriangles*3);
+        m_liveTriangles.assign(numTriangles, 1);
+
+        for(int i = 0; i < mesh->getNumberOfGroups(); ++i)
+        {
+            const Mesh::Group& g = mesh->getGroup(i);
+            m_groupRanges.push_back(std::make_pair(g.startIndex/3, g.startIndex/3 + g.triangleCount));
+        }
+        if(m_groupRanges.empty())
+            m_groupRanges.push_back(std::make_pair(0, numTriangles));
+
+        // -------------------------------------------------
+        // Points, positions normalized to a unit diagonal
+        // -------------------------------------------------
+        float minimum[3] = {0.0f, 0.0f, 0.0f};
+        float maximum[3] = {0.0f, 0.0f, 0.0f};
+        for(int v = 0; v < numVertices; ++v)
+        {
+            const float* p = mesh->getPosition(v);
+            for(int j = 0; j < 3; ++j)
+            {
+                minimum[j] = v == 0 || p[j] < minimum[j] ? p[j] : minimum[j];
+                maximum[j] = v == 0 || p[j] > maximum[j] ? p[j] : maximum[j];
+            }
+        }
+        float diagonal = sqrtf((maximum[0]-minimum[0])*(maximum[0]-minimum[0]) +
+                               (maximum[1]-minimum[1])*(maximum[1]-minimum[1]) +
+                               (maximum[2]-minimum[2])*(maximum[2]-minimum[2]));
+        float scale = diagonal > 0.0f ? 1.0f / diagonal : 1.0f;
+
+        m_points.resize((size_t)numVertices*m_dimension);
+        for(int v = 0; v < numVertices; ++v)
+        {
+            float* point = &m_points[(size_t)v*m_dimension];
+            const float* p = mesh->getPosition(v);
+            for(int j = 0; j < 3; ++j)
+                point[j] = (p[j] - 0.5f*(minimum[j] + maximum[j])) * scale;
+            int k = 3;
+            if(texCoords)
+            {
+                const float* t = mesh->getTexCoord(v);
+                point[k++] = t[0] * TEXCOORD_WEIGHT;
+                point[k++] = t[1] * TEXCOORD_WEIGHT;
+            }
+            if(normals)
+            {
+                const float* n = mesh->getNormal(v);
+                float length = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+                float s = length > 0.0f ? NORMAL_WEIGHT / length : 0.0f;
+                point[k++] = n[0] * s;
+                point[k++] = n[1] * s;
+                point[k++] = n[2] * s;
+            }
+        }
+
+        // -------------------------------------------------
+        // Locked vertices: seams, group boundaries and non-manifold edges
+        // -------------------------------------------------
+        m_locked.assign(numVertices, 0);
+        m_border.assign(numVertices, 0);
+        m_removed.assign(numVertices, 0);
+        m_versions.assign(numVertices, 0);
+
+        std::vector<unsigned int> order(numVertices);
+        for(int v = 0; v < numVertices; ++v)
+            order[v] = v;
+        std::vector<float> positions((size_t)numVertices*3);
+        for(int v = 0; v < numVertices; ++v)
+            memcpy(&positions[(size_t)v*3], mesh->getPosition(v), 3*sizeof(float));
+        PositionLess less(numVertices > 0 ? &positions[0] : 0);
+        std::sort(order.begin(), order.end(), less);
+        for(int i = 1; i < numVertices; ++i)
+        {
+            if(less(order[i-1], order[i]) == false)
+                m_locked[order[i-1]] = m_locked[order[i]] = 1;
+        }
+
+        std::vector<int> vertexGroup(numVertices, -1);
+        for(size_t g = 0; g < m_groupRanges.size(); ++g)
+        {
+            for(int t = m_groupRanges[g].first; t < m_groupRanges[g].second; ++t)
+            {
+                for(int k = 0; k < 3; ++k)
+                {
+                    unsigned int v = m_indices[t*3+k];
+                    if(vertexGroup[v] >= 0 && vertexGroup[v] != (int)g)
+                        m_locked[v] = 1;
+                    vertexGroup[v] = (int)g;
+                }
+            }
+        }
+
+        const MeshAdjacency& adjacency = mesh->getAdjacency();
+        m_vertexTriangles.resize(numVertices);
+        for(int v = 0; v < numVertices; ++v)
+        {
+            const unsigned int* triangles = adjacency.getVertexTriangles(v);
+            m_vertexTriangles[v].assign(triangles, triangles + adjacency.getVertexTriangleCount(v));
+        }
+
+        // Original facing, so collapses cannot turn a triangle around
+        // in several small steps.
+        m_triangleNormals.resize((size_t)numTriangles*3);
+        for(int t = 0; t < numTriangles; ++t)
+        {
+            const float* a = getPoint(m_indices[t*3+0]);
+            const float* b = getPoint(m_indices[t*3+1]);
+            const float* c = getPoint(m_indices[t*3+2]);
+            double e1[3] = {(double)b[0]-a[0], (double)b[1]-a[1], (double)b[2]-a[2]};
+            double e2[3] = {(double)c[0]-a[0], (double)c[1]-a[1], (double)c[2]-a[2]};
+            m_triangleNormals[t*3+0] = (float)(e1[1]*e2[2] - e1[2]*e2[1]);
+            m_triangleNormals[t*3+1] = (float)(e1[2]*e2[0] - e1[0]*e2[2]);
+            m_triangleNormals[t*3+2] = (float)(e1[0]*e2[1] - e1[1]*e2[0]);
+        }
+
+        // -------------------------------------------------
+        // Quadrics
+        // -------------------------------------------------
+        Quadric zero;
+        clearQuadric(zero);
+        m_quadrics.assign(numVertices, zero);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+        for(int v = 0; v < numVertices; ++v)
+        {
+            const std::vector<unsigned int>& triangles = m_vertexTriangles[v];
+            for(size_t i = 0; i < triangles.size(); ++i)
+            {
+                const unsigned int* t = &m_indices[triangles[i]*3];
+                addTriangleQuadric(m_quadrics[v], getPoint(t[0]), getPoint(t[1]), getPoint(t[2]),
+                                   m_dimension);
+            }
+        }
+
+        for(int e = 0; e < adjacency.getNumberOfEdges(); ++e)
+        {
+            unsigned int v0, v1;
+            adjacency.getEdgeVertices(e, v0, v1);
+            int count = adjacency.getEdgeHalfEdgeCount(e);
+            if(count > 2)
+            {
+                m_locked[v0] = m_locked[v1] = 1;
+                continue;
+            }
+            if(count != 1 || v0 == v1)
+                continue;
+
+            m_border[v0] = m_border[v1] = 1;
+
+            // Plane through the edge, perpendicular to its triangle.
+            const unsigned int* t = &m_indices[(adjacency.getEdgeHalfEdges(e)[0]/3)*3];
+            const float* a = getPoint(t[0]);
+            const float* b = getPoint(t[1]);
+            const float* c = getPoint(t[2]);
+            double e1[3] = {(double)b[0]-a[0], (double)b[1]-a[1], (double)b[2]-a[2]};
+            double e2[3] = {(double)c[0]-a[0], (double)c[1]-a[1], (double)c[2]-a[2]};
+            double n[3] = {e1[1]*e2[2] - e1[2]*e2[1],
+                           e1[2]*e2[0] - e1[0]*e2[2],
+                           e1[0]*e2[1] - e1[1]*e2[0]};
+            const float* p0 = getPoint(v0);
+            const float* p1 = getPoint(v1);
+            double edge[3] = {(double)p1[0]-p0[0], (double)p1[1]-p0[1], (double)p1[2]-p0[2]};
+            double plane[3] = {edge[1]*n[2] - edge[2]*n[1],
+                               edge[2]*n[0] - edge[0]*n[2],
+                               edge[0]*n[1] - edge[1]*n[0]};
+            double length = sqrt(plane[0]*plane[0] + plane[1]*plane[1] + plane[2]*plane[2]);
+            if(length <= 0.0)
+                continue;
+            plane[0] /= length;
+            plane[1] /= length;
+            plane[2] /= length;
+            double d = -(plane[0]*p0[0] + plane[1]*p0[1] + plane[2]*p0[2]);
+            double weight = BORDER_WEIGHT * (edge[0]*edge[0] + edge[1]*edge[1] + edge[2]*edge[2]);
+            addPlaneQuadric(m_quadrics[v0], plane, d, weight, m_dimension);
+            addPlaneQuadric(m_quadrics[v1], plane, d, weight, m_dimension);
+        }
+
+        // -------------------------------------------------
+        // Initial candidates
+        // -------------------------------------------------
+        std::vector<Candidate> candidates(numVertices);
+        std::vector<char> found(numVertices, 0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+        for(int v = 0; v < numVertices; ++v)
+            found[v] = findCandidate(v, candidates[v]) ? 1 : 0;
+
+        std::vector<Candidate> initial;
+        initial.reserve(numVertices);
+        for(int v = 0; v < numVertices; ++v)
+        {
+            if(found[v])
+                initial.push_back(candidates[v]);
+        }
+        m_queue = std::priority_queue<Candidate>(std::less<Candidate>(), initial);
+    }
+
+    void Simplifier::gatherNeighbours(unsigned int v, std::vector<unsigned int>& neighbours) const
+    {
+        neighbours.clear();
+        const std::vector<unsigned int>& triangles = m_vertexTriangles[v];
+        for(size_t i = 0; i < triangles.size(); ++i)
+        {
+            if(m_liveTriangles[triangles[i]] == 0)
+                continue;
+            const unsigned int* t = &m_indices[triangles[i]*3];
+            for(int k = 0; k < 3; ++k)
+            {
+                if(t[k] != v)
+                    neighbours.push_back(t[k]);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    }
+
+    int Simplifier::countSharedTriangles(unsigned int v, unsigned int u) const
+    {
+        int count = 0;
+        const std::vector<unsigned int>& triangles = m_vertexTriangles[v];
+        for(size_t i = 0; i < triangles.size(); ++i)
+        {
+            const unsigned int* t = &m_indices[triangles[i]*3];
+            if(m_liveTriangles[triangles[i]] && (t[0] == u || t[1] == u || t[2] == u))
+                ++count;
+        }
+        return count;
+    }
+
+    bool Simplifier::isValidCollapse(unsigned int v, unsigned int u)
+    {
+        // Link condition: the edge may only share the vertices opposite
+        // to it in its own triangles, otherwise the surface gets pinched.
+        gatherNeighbours(v, m_neighbours);
+        gatherNeighbours(u, m_targetNeighbours);
+        m_common.clear();
+        std::set_intersection(m_neighbours.begin(), m_neighbours.end(),
+                              m_targetNeighbours.begin(), m_targetNeighbours.end(),
+                              std::back_inserter(m_common));
+        if((int)m_common.size() != countSharedTriangles(v, u))
+            return false;
+
+        // No triangle may flip or degenerate.
+        const float* target = getPoint(u);
+        const std::vector<unsigned int>& triangles = m_vertexTriangles[v];
+        for(size_t i = 0; i < triangles.size(); ++i)
+        {
+            if(m_liveTriangles[triangles[i]] == 0)
+                continue;
+            const unsigned int* t = &m_indices[triangles[i]*3];
+            if(t[0] == u || t[1] == u || t[2] == u)
+                continue;
+
+            const float* p[3];
+            const float* q[3];
+            for(int k = 0; k < 3; ++k)
+            {
+                p[k] = getPoint(t[k]);
+                q[k] = t[k] == v ? target : p[k];
+            }
+            double before[3], after[3];
+            double a1[3], a2[3], b1[3], b2[3];
+            for(int j = 0; j < 3; ++j)
+            {
+                a1[j] = (double)p[1][j] - p[0][j];
+                a2[j] = (double)p[2][j] - p[0][j];
+                b1[j] = (double)q[1][j] - q[0][j];
+                b2[j] = (double)q[2][j] - q[0][j];
+            }
+            before[0] = a1[1]*a2[2] - a1[2]*a2[1];
+            before[1] = a1[2]*a2[0] - a1[0]*a2[2];
+            before[2] = a1[0]*a2[1] - a1[1]*a2[0];
+            after[0] = b1[1]*b2[2] - b1[2]*b2[1];
+            after[1] = b1[2]*b2[0] - b1[0]*b2[2];
+            after[2] = b1[0]*b2[1] - b1[1]*b2[0];
+            // Rejects turns above ~75 degrees, against the previous and the
+            // original facing. Allowing up to 90 degrees against the previous
+            // one lets a series of collapses flip a triangle step by step.
+            double dot = before[0]*after[0] + before[1]*after[1] + before[2]*after[2];
+            double lengths = sqrt((before[0]*before[0] + before[1]*before[1] + before[2]*before[2]) *
+                                  (after[0]*after[0] + after[1]*after[1] + after[2]*after[2]));
+            if(dot <= 0.25 * lengths)
+                return false;
+            const float* original = &m_triangleNormals[triangles[i]*3];
+            dot = original[0]*after[0] + original[1]*after[1] + original[2]*after[2];
+            lengths = sqrt(((double)original[0]*original[0] + (double)original[1]*original[1] +
+                            (double)original[2]*original[2]) *
+                           (after[0]*after[0] + after[1]*after[1] + after[2]*after[2]));
+            if(dot <= 0.25 * lengths)
+                return false;
+        }
+        return true;
+    }
+
+    double Simplifier::getCost(unsigned int v, unsigned int u) const
+    {
+        const Quadric& qv = m_quadrics[v];
+        const Quadric& qu = m_quadrics[u];
+        const float* x = getPoint(u);
+        double weight = (double)qv.weight + qu.weight;
+        double error = evaluateQuadric(qv, x, m_dimension) + evaluateQuadric(qu, x, m_dimension);
+        return error > 0.0 && weight > 0.0 ? error / weight : 0.0;
+    }
+
+    // Cheapest collapse of v, validity is checked when it is taken.
+    bool Simplifier::findCandidate(unsigned int v, Candidate& candidate) const
+    {
+        if(m_removed[v] || m_locked[v])
+            return false;
+
+        bool found = false;
+        const std::vector<unsigned int>& triangles = m_vertexTriangles[v];
+        for(size_t i = 0; i < triangles.size(); ++i)
+        {
+            if(m_liveTriangles[triangles[i]] == 0)
+                continue;
+            // Around an inner vertex every neighbour follows v in exactly
+            // one triangle. Borders also need the vertex before v.
+            const unsigned int* t = &m_indices[triangles[i]*3];
+            int corner = t[0] == v ? 0 : (t[1] == v ? 1 : 2);
+            for(int k = 1; k < (m_border[v] ? 3 : 2); ++k)
+            {
+                unsigned int u = t[(corner+k)%3];
+                if(found && u == candidate.target)
+                    continue;
+                // Border vertices only move along the border.
+                if(m_border[v] && countSharedTriangles(v, u) != 1)
+                    continue;
+
+                double cost = getCost(v, u);
+                if(found == false || cost < candidate.cost)
+                {
+                    candidate.cost = (float)cost;
+                    candidate.vertex = v;
+                    candidate.target = u;
+                    candidate.version = m_versions[v];
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    // Cheapest collapse of v that passes isValidCollapse().
+    bool Simplifier::findValidCandidate(unsigned int v, Candidate& candidate)
+    {
+        if(m_removed[v] || m_locked[v])
+            return false;
+
+        gatherNeighbours(v, m_neighbours);
+        m_costs.clear();
+        for(size_t i = 0; i < m_neighbours.size(); ++i)
+        {
+            unsigned int u = m_neighbours[i];
+            if(m_border[v] && countSharedTriangles(v, u) != 1)
+                continue;
+            m_costs.push_back(std::make_pair(getCost(v, u), u));
+        }
+        std::sort(m_costs.begin(), m_costs.end());
+
+        // isValidCollapse() reuses m_neighbours, so walk a copy of the order.
+        std::vector<std::pair<double, unsigned int> > costs(m_costs);
+        for(size_t i = 0; i < costs.size(); ++i)
+        {
+            if(isValidCollapse(v, costs[i].second))
+            {
+                candidate.cost = (float)costs[i].first;
+                candidate.vertex = v;
+                candidate.target = costs[i].second;
+                candidate.version = m_versions[v];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Simplifier::collapse(unsigned int v, unsigned int u)
+    {
+        // Only the neighbours of v see a new neighbourhood. Collapses
+        // onto u that got more expensive are caught when they are taken.
+        std::vector<unsigned int> affected;
+        gatherNeighbours(v, affected);
+
+        std::vector<unsigned int>& triangles = m_vertexTriangles[v];
+        std::vector<unsigned int>& targetTriangles = m_vertexTriangles[u];
+        for(size_t i = 0; i < triangles.size(); ++i)
+        {
+            unsigned int triangle = triangles[i];
+            if(m_liveTriangles[triangle] == 0)
+                continue;
+            unsigned int* t = &m_indices[triangle*3];
+            if(t[0] == u || t[1] == u || t[2] == u)
+            {
+                m_liveTriangles[triangle] = 0;
+                --m_numLiveTriangles;
+                continue;
+            }
+            for(int k = 0; k < 3; ++k)
+            {
+                if(t[k] == v)
+                    t[k] = u;
+            }
+            targetTriangles.push_back(triangle);
+        }
+        std::vector<unsigned int>().swap(triangles);
+
+        size_t live = 0;
+        for(size_t i = 0; i < targetTriangles.size(); ++i)
+        {
+            if(m_liveTriangles[targetTriangles[i]])
+                targetTriangles[live++] = targetTriangles[i];
+        }
+        targetTriangles.resize(live);
+
+        addQuadric(m_quadrics[u], m_quadrics[v]);
+        m_removed[v] = 1;
+
+        for(size_t i = 0; i < affected.size(); ++i)
+        {
+            unsigned int w = affected[i];
+            ++m_versions[w];
+            Candidate candidate;
+            if(findCandidate(w, candidate))
+                m_queue.push(candidate);
+        }
+    }
+
+    float Simplifier::run(int targetTriangles, float maxError)
+    {
+        const double maxCost = (double)maxError * maxError;
+        while(m_numLiveTriangles > targetTriangles && m_queue.empty() == false)
+        {
+            Candidate candidate = m_queue.top();
+            if(candidate.cost > maxCost)
+                break;
+            m_queue.pop();
+
+            unsigned int v = candidate.vertex;
+            unsigned int u = candidate.target;
+            if(m_removed[v] || candidate.version != m_versions[v])
+                continue;
+
+            if(m_removed[u] == false)
+            {
+                // The target may have taken other collapses since.
+                float cost = (float)getCost(v, u);
+                if(cost > candidate.cost)
+                {
+                    candidate.cost = cost;
+                    m_queue.push(candidate);
+                    continue;
+                }
+                if(isValidCollapse(v, u))
+                {
+                    collapse(v, u);
+                    m_error = std::max(m_error, sqrtf(candidate.cost));
+                    continue;
+                }
+            }
+
+            ++m_versions[v];
+            Candidate next;
+            if(findValidCandidate(v, next))
+                m_queue.push(next);
+        }
+        return m_error;
+    }
+
+    void Simplifier::getIndices(std::vector<unsigned int>& indices, std::vector<int>& groupCounts) const
+    {
+        indices.clear();
+        groupCounts.clear();
+        for(size_t g = 0; g < m_groupRanges.size(); ++g)
+        {
+            int count = 0;
+            for(int t = m_groupRanges[g].first; t < m_groupRanges[g].second; ++t)
+            {
+                if(m_liveTriangles[t] == 0)
+                    continue;
+                indices.insert(indices.end(), &m_indices[t*3], &m_indices[t*3] + 3);
+                ++count;
+            }
+            groupCounts.push_back(count);
+        }
+    }
+}
+
+// Replaces the triangles of all groups.
+static void setTriangles(Mesh* mesh, const std::vector<unsigned int>& indices,
+                         const std::vector<int>& groupCounts)
+{
+    int start = 0;
+    for(int i = 0; i < mesh->getNumberOfGroups(); ++i)
+    {
+        Mesh::Group& g = mesh->getGroup(i);
+        g.startIndex = start*3;
+        g.triangleCount = groupCounts[i];
+        start += groupCounts[i];
+    }
+    mesh->setIndices(indices);
+    mesh->setNumTriangles(static_cast<int>(indices.size()/3));
+}
+
+// Drops vertices no triangle uses, keeping the order of the others.
+static void removeUnusedVertices(Mesh* mesh)
+{
+    const int numVertices = mesh->getNumberOfVertices();
+    const int numIndices = mesh->getNumberOfTriangles()*3;
+    unsigned int* indices = mesh->getIndicesPointer();
+
+    std::vector<unsigned int> oldToNew(numVertices, 0);
+    for(int i = 0; i < numIndices; ++i)
+        oldToNew[indices[i]] = 1;
+
+    std::vector<unsigned int> newToOld;
+    for(int v = 0; v < numVertices; ++v)
+    {
+        if(oldToNew[v])
+        {
+            oldToNew[v] = static_cast<unsigned int>(newToOld.size());
+            newToOld.push_back(v);
+        }
+    }
+    if((int)newToOld.size() == numVertices)
+        return;
+
+    std::vector<unsigned int> remapped(indices, indices + numIndices);
+    for(int i = 0; i < numIndices; ++i)
+        remapped[i] = oldToNew[remapped[i]];
+
+    mesh->remapVertices(newToOld);
+    mesh->setIndices(remapped);
+    mesh->calculateBounds();
+}
+
+SimplifyTool::SimplifyTool()
+{
+}
+
+SimplifyTool::~SimplifyTool()
+{
+}
+
+float SimplifyTool::simplify(Mesh* mesh, float ratio, float maxError)
+{
+    Simplifier simplifier(mesh);
+    float error = simplifier.run(static_cast<int>(static_cast<float>(mesh->getNumberOfTriangles()) * ratio), maxError);
+
+    std::vector<unsigned int> indices;
+    std::vector<int> groupCounts;
+    simplifier.getIndices(indices, groupCounts);
+    setTriangles(mesh, indices, groupCounts);
+    removeUnusedVertices(mesh);
+
+    return error;
+}
+
+void SimplifyTool::appendLodGroups(Mesh* mesh, int numLevels, float ratio, float maxError)
+{
+    const int numTriangles = mesh->getNumberOfTriangles();
+    const int numGroups = mesh->getNumberOfGroups();
+    Simplifier simplifier(mesh);
+
+    std::vector<unsigned int> indices(mesh->getIndicesPointer(),
+                                      mesh->getIndicesPointer() + numTriangles*3);
+    std::vector<unsigned int> levelIndices;
+    std::vector<int> groupCounts;
+    float levelRatio = 1.0f;
+    for(int level = 1; level <= numLevels; ++level)
+    {
+        levelRatio *= ratio;
+        simplifier.run(static_cast<int>(static_cast<float>(numTriangles) * levelRatio), maxError);
+        simplifier.getIndices(levelIndices, groupCounts);
+
+        int start = static_cast<int>(indices.size());
+        indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+        for(int i = 0; i < numGroups; ++i)
+        {
+            std::stringstream name;
+            name << mesh->getGroup(i).name << "_lod" << level;
+            std::string tmpGroupName = name.str();
+
+            Mesh::Group g;
+            g.name = new char[tmpGroupName.length()+1];
+            g.name[tmpGroupName.length()] = 0;
+            memcpy(g.name, tmpGroupName.c_str(), tmpGroupName.size());
+            g.startIndex = start;
+            g.triangleCount = groupCounts[i];
+            g.primitiveType = mesh->getGroup(i).primitiveType;
+            start += groupCounts[i]*3;
+
+            mesh->addGroup(g);
+        }
+    }
+    mesh->setIndices(indices);
+    mesh->setNumTriangles(static_cast<int>(indices.size()/3));
+}
+
+void SimplifyTool::createLodMeshes(Mesh* mesh, int numLevels, float ratio, float maxError,
+                                   std::vector<Mesh*>& lods)
+{
+    const int numTriangles = mesh->getNumberOfTriangles();
+    Simplifier simplifier(mesh);
+
+    std::vector<unsigned int> indices;
+    std::vector<int> groupCounts;
+    float levelRatio = 1.0f;
+    for(int level = 1; level <= numLevels; ++level)
+    {
+        levelRatio *= ratio;
+        simplifier.run(static_cast<int>(static_cast<float>(numTriangles) * levelRatio), maxError);
+        simplifier.getIndices(indices, groupCounts);
+
+        Mesh* lod = new Mesh(*mesh);
+        setTriangles(lod, indices, groupCounts);
+        removeUnusedVertices(lod);
+        lods.push_back(lod);
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _SIMPLIFYTOOL_H_
+#define _SIMPLIFYTOOL_H_
+
+#include "Mesh.h"
+
+namespace assembly3d
+{
+    namespace wiz
+    {
+        /**
+         * @brief Class for reducing the triangle count of meshes.
+         *
+         * Uses half-edge collapses ordered by quadric error (Garland and
+         * Heckbert), measured over positions, texture coordinates and
+         * normals. Collapses only move a vertex onto a neighbour, so all
+         * levels of detail index into the original vertices.
+         *
+         * Vertices on UV or normal seams, vertices shared by groups and
+         * vertices on non-manifold edges are never removed. Open borders
+         * only collapse along the border.
+        */
+        class SimplifyTool
+        {
+        public:
+            SimplifyTool();
+            ~SimplifyTool();
+
+            /**
+             * @brief Simplifies the mesh and removes unused vertices.
+             *
+             * @param mesh The mesh to work on.
+             * @param ratio Wanted ratio of remaining triangles.
+             * @param maxError Largest error, relative to the bounding box diagonal.
+             * @return Largest error of the applied collapses.
+             */
+            float simplify(Mesh* mesh, float ratio, float maxError);
+            /**
+             * @brief Appends levels of detail as groups.
+             *
+             * Level n of group "name" is added as "name_lod<n>" and holds
+             * ratio^n of the triangles. The vertices are shared.
+             *
+             * @param mesh The mesh to work on.
+             * @param numLevels Number of levels to add.
+             * @param ratio Ratio of triangles from one level to the next.
+             * @param maxError Largest error, relative to the bounding box diagonal.
+             */
+            void appendLodGroups(Mesh* mesh, int numLevels, float ratio, float maxError);
+            /**
+             * @brief Creates levels of detail as separate meshes.
+             *
+             * @param mesh The mesh to simplify, left unchanged.
+             * @param numLevels Number of levels to create.
+             * @param ratio Ratio of triangles from one level to the next.
+             * @param maxError Largest error, relative to the bounding box diagonal.
+             * @param lods Receives the meshes, owned by the caller.
+             */
+            void createLodMeshes(Mesh* mesh, int numLevels, float ratio, float maxError,
+                                 std::vector<Mesh*>& lods);
+        };
+    }
+}
+
+#endif  // _SIMPLIFYTOOL_H_
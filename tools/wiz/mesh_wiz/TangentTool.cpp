@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "MeshWizIncludes.h"
+#include "TangentTool.h"
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define A3D_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace assembly3d;
+using namespace assembly3d::wiz;
+
+// Texture space tangent of every triangle: 4 floats, the tangent scaled
+// by 1/UV area and the handedness (0 for triangles without UV area).
+static void computeTriangleTangents(Mesh* mesh, std::vector<float>& frames)
+{
+    const int numTriangles = mesh->getNumberOfTriangles();
+    frames.assign((size_t)numTriangles*4, 0.0f);
+    if(numTriangles == 0)
+        return;
+
+    const unsigned int* indices = mesh->getIndicesPointer();
+    const float* positions = mesh->getPositionsPointer();
+    const float* texCoords = mesh->getTexCoordsPointer();
+    const int positionStride = mesh->getStride(Mesh::POSITION);
+    const int texCoordStride = mesh->getStride(Mesh::TEXCOORD);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i = 0; i < numTriangles; ++i)
+    {
+        const unsigned int* t = indices + i*3;
+        const float* p0 = positions + (size_t)t[0]*positionStride;
+        const float* p1 = positions + (size_t)t[1]*positionStride;
+        const float* p2 = positions + (size_t)t[2]*positionStride;
+        const float* uv0 = texCoords + (size_t)t[0]*texCoordStride;
+        const float* uv1 = texCoords + (size_t)t[1]*texCoordStride;
+        const float* uv2 = texCoords + (size_t)t[2]*texCoordStride;
+
+        float s1 = uv1[0] - uv0[0];
+        float t1 = uv1[1] - uv0[1];
+        float s2 = uv2[0] - uv0[0];
+        float t2 = uv2[1] - uv0[1];
+        float area = s1*t2 - s2*t1;
+        if(area == 0.0f)
+            continue;
+
+        float scale = 1.0f / area;
+        float* frame = &frames[(size_t)i*4];
+        for(int j = 0; j < 3; ++j)
+            frame[j] = (t2*(p1[j] - p0[j]) - t1*(p2[j] - p0[j])) * scale;
+        frame[3] = area > 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+// Angle of a triangle at one of its vertices.
+static float getCornerAngle(const float* positions, int stride, const unsigned int* t,
+                            unsigned int vertex)
+{
+    int k = t[0] == vertex ? 0 : (t[1] == vertex ? 1 : 2);
+    const float* a = positions + (size_t)t[k]*stride;
+    const float* b = positions + (size_t)t[(k+1)%3]*stride;
+    const float* c = positions + (size_t)t[(k+2)%3]*stride;
+    float e1[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+    float e2[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+    float cross[3] = {e1[1]*e2[2] - e1[2]*e2[1],
+                      e1[2]*e2[0] - e1[0]*e2[2],
+                      e1[0]*e2[1] - e1[1]*e2[0]};
+    return atan2f(sqrtf(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]),
+                  e1[0]*e2[0] + e1[1]*e2[1] + e1[2]*e2[2]);
+}
+
+// Makes the tangent orthogonal to the unit normal and writes the
+// bitangent. Tangents without length get any direction in the plane.
+static void orthonormalizeScalar(const float* n, float* t, float* b, float sign)
+{
+    float d = n[0]*t[0] + n[1]*t[1] + n[2]*t[2];
+    float v[3] = {t[0] - n[0]*d, t[1] - n[1]*d, t[2] - n[2]*d};
+    float length = sqrtf(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    if(length < 1e-20f)
+    {
+        // Start from the axis least aligned with the normal.
+        float axis[3] = {0.0f, 0.0f, 0.0f};
+        int a = fabsf(n[0]) < fabsf(n[1]) ? (fabsf(n[0]) < fabsf(n[2]) ? 0 : 2)
+                                          : (fabsf(n[1]) < fabsf(n[2]) ? 1 : 2);
+        axis[a] = 1.0f;
+        d = n[a];
+        v[0] = axis[0] - n[0]*d;
+        v[1] = axis[1] - n[1]*d;
+        v[2] = axis[2] - n[2]*d;
+        length = sqrtf(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    }
+    t[0] = v[0] / length;
+    t[1] = v[1] / length;
+    t[2] = v[2] / length;
+    t[3] = sign;
+    b[0] = sign * (n[1]*t[2] - n[2]*t[1]);
+    b[1] = sign * (n[2]*t[0] - n[0]*t[2]);
+    b[2] = sign * (n[0]*t[1] - n[1]*t[0]);
+    b[3] = 0.0f;
+}
+
+// Orthonormalizes 4-float tangents against 4-float unit normals. The sign
+// is read from the tangent's w.
+static void orthonormalize(const float* normals, float* tangents, float* bitangents, int count)
+{
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int i = 0; i < count; ++i)
+    {
+        const float* n = normals + (size_t)i*4;
+        float* t = tangents + (size_t)i*4;
+        float* b = bitangents + (size_t)i*4;
+        float sign = t[3];
+#ifdef A3D_USE_SSE
+        __m128 vn = _mm_loadu_ps(n);
+        __m128 vt = _mm_loadu_ps(t);
+        __m128 prod = _mm_mul_ps(vn, vt);
+        __m128 d = _mm_add_ss(_mm_add_ss(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(1, 1, 1, 1))),
+                              _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(2, 2, 2, 2)));
+        d = _mm_shuffle_ps(d, d, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 v = _mm_sub_ps(vt, _mm_mul_ps(vn, d));
+        __m128 sq = _mm_mul_ps(v, v);
+        __m128 len2 = _mm_add_ss(_mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 1, 1, 1))),
+                                 _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 2, 2, 2)));
+        float length2;
+        _mm_store_ss(&length2, len2);
+        if(length2 < 1e-40f)
+        {
+            orthonormalizeScalar(n, t, b, sign);
+            continue;
+        }
+        __m128 length = _mm_sqrt_ps(_mm_shuffle_ps(len2, len2, _MM_SHUFFLE(0, 0, 0, 0)));
+        v = _mm_div_ps(v, length);
+
+        // sign * (n.yzx * t.zxy - n.zxy * t.yzx)
+        __m128 c = _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(vn, vn, _MM_SHUFFLE(3, 0, 2, 1)),
+                       _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 0, 2))),
+            _mm_mul_ps(_mm_shuffle_ps(vn, vn, _MM_SHUFFLE(3, 1, 0, 2)),
+                       _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1))));
+        c = _mm_mul_ps(c, _mm_set1_ps(sign));
+
+        _mm_storeu_ps(t, v);
+        _mm_storeu_ps(b, c);
+        t[3] = sign;
+        b[3] = 0.0f;
+#else
+        orthonormalizeScalar(n, t, b, sign);
+#endif
+    }
+}
+
+// Writes 4-float vectors into a mesh attribute layout. w is kept if the
+// attribute has 4 components, otherwise padded like Mesh::addTangent.
+static void storeAttribute(const std::vector<float>& values, int count, int size, int stride,
+                           std::vector<float>& data)
+{
+    data.assign((size_t)count*stride, 0.0f);
+    for(int i = 0; i < count; ++i)
+    {
+        const float* src = &values[(size_t)i*4];
+        float* dst = &data[(size_t)i*stride];
+        for(int j = 0; j < stride; ++j)
+            dst[j] = j < 3 || size > 3 ? src[j] : 1.0f;
+    }
+}
+
+TangentTool::TangentTool()
+{
+}
+
+TangentTool::~TangentTool()
+{
+}
+
+int TangentTool::generateTangents(Mesh* mesh, bool bitangents)
+{
+    if(mesh->hasPositions() == false || mesh->hasNormals() == false ||
+       mesh->hasTexCoords() == false)
+        return -1;
+
+    const int numVertices = mesh->getNumberOfVertices();
+    const int numTriangles = mesh->getNumberOfTriangles();
+    const MeshAdjacency& adjacency = mesh->getAdjacency();
+    const unsigned int* indices = numTriangles > 0 ? mesh->getIndicesPointer() : 0;
+    const float* positions = mesh->getPositionsPointer();
+    const int positionStride = mesh->getStride(Mesh::POSITION);
+
+    std::vector<float> frames;
+    computeTriangleTangents(mesh, frames);
+
+    // -------------------------------------------------
+    // Sum the projected tangents per vertex and handedness
+    // -------------------------------------------------
+    // sums holds the unit normal, the sum for the handedness of the
+    // vertex's first triangle and the sum for the other handedness.
+    std::vector<float> sums((size_t)numVertices*12, 0.0f);
+    std::vector<signed char> firstSign(numVertices, 0);
+    std::vector<char> split(numVertices, 0);
+
+    const float* normals = mesh->getNormalsPointer();
+    const int normalStride = mesh->getStride(Mesh::NORMAL);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+    for(int v = 0; v < numVertices; ++v)
+    {
+        float* n = &sums[(size_t)v*12];
+        const float* source = normals + (size_t)v*normalStride;
+        float length = sqrtf(source[0]*source[0] + source[1]*source[1] + source[2]*source[2]);
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        n[0] = source[0] * scale;
+        n[1] = source[1] * scale;
+        n[2] = source[2] * scale;
+
+        const unsigned int* triangles = adjacency.getVertexTriangles(v);
+        const int count = adjacency.getVertexTriangleCount(v);
+        for(int i = 0; i < count; ++i)
+        {
+            const float* frame = &frames[(size_t)triangles[i]*4];
+            if(frame[3] == 0.0f)
+                continue;
+
+            if(firstSign[v] == 0)
+                firstSign[v] = frame[3] > 0.0f ? 1 : -1;
+            bool first = (frame[3] > 0.0f) == (firstSign[v] > 0);
+            if(first == false)
+                split[v] = 1;
+
+            float d = n[0]*frame[0] + n[1]*frame[1] + n[2]*frame[2];
+            float p[3] = {frame[0] - n[0]*d, frame[1] - n[1]*d, frame[2] - n[2]*d};
+            float pl = sqrtf(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+            if(pl == 0.0f)
+                continue;
+
+            float w = getCornerAngle(positions, positionStride, indices + triangles[i]*3, v) / pl;
+            float* sum = n + (first ? 4 : 8);
+            sum[0] += w * p[0];
+            sum[1] += w * p[1];
+            sum[2] += w * p[2];
+        }
+    }
+
+    // -------------------------------------------------
+    // Split vertices used with both handedness
+    // -------------------------------------------------
+    std::vector<unsigned int> newToOld(numVertices);
+    std::vector<unsigned int> secondVertex(numVertices, 0);
+    for(int v = 0; v < numVertices; ++v)
+    {
+        newToOld[v] = v;
+        if(split[v])
+        {
+            secondVertex[v] = static_cast<unsigned int>(newToOld.size());
+            newToOld.push_back(v);
+        }
+    }
+    const int numNewVertices = static_cast<int>(newToOld.size());
+
+    std::vector<float> unitNormals((size_t)numNewVertices*4, 0.0f);
+    std::vector<float> tangents((size_t)numNewVertices*4, 0.0f);
+    std::vector<float> bitangentValues((size_t)numNewVertices*4, 0.0f);
+    for(int i = 0; i < numNewVertices; ++i)
+    {
+        unsigned int v = newToOld[i];
+        bool second = i >= numVertices;
+        const float* n = &sums[(size_t)v*12];
+        const float* sum = n + (second ? 8 : 4);
+        float sign = firstSign[v] < 0 ? -1.0f : 1.0f;
+        for(int j = 0; j < 3; ++j)
+        {
+            unitNormals[(size_t)i*4+j] = n[j];
+            tangents[(size_t)i*4+j] = sum[j];
+        }
+        tangents[(size_t)i*4+3] = second ? -sign : sign;
+    }
+
+    orthonormalize(numNewVertices > 0 ? &unitNormals[0] : 0,
+                   numNewVertices > 0 ? &tangents[0] : 0,
+                   numNewVertices > 0 ? &bitangentValues[0] : 0, numNewVertices);
+
+    std::vector<unsigned int> newIndices;
+    if(numNewVertices > numVertices)
+    {
+        newIndices.assign(indices, indices + numTriangles*3);
+        for(int corner = 0; corner < numTriangles*3; ++corner)
+        {
+            unsigned int v = indices[corner];
+            float sign = frames[(size_t)(corner/3)*4+3];
+            if(split[v] && sign != 0.0f && (sign > 0.0f) != (firstSign[v] > 0))
+                newIndices[corner] = secondVertex[v];
+        }
+    }
+
+    // -------------------------------------------------
+    // Store
+    // -------------------------------------------------
+    // TANGENT keeps the handedness in w, as in MikkTSpace.
+    if(mesh->hasTangents() == false)
+    {
+        mesh->addAttribute("TANGENT", 4, "FLOAT");
+        mesh->hasTangents(true);
+    }
+    if(bitangents && mesh->hasBitangents() == false)
+    {
+        mesh->addAttribute("BITANGENT", 3, "FLOAT");
+        mesh->hasBitangents(true);
+    }
+
+    if(numNewVertices > numVertices)
+    {
+        mesh->remapVertices(newToOld);
+        mesh->setIndices(newIndices);
+    }
+
+    // Loaded tangents with fewer components are widened. The old data is
+    // replaced below, so it does not need to be repacked.
+    Mesh::MeshFormat& format = mesh->getMeshFormat();
+    int tangentIndex = mesh->getAttributeIndexWithName("TANGENT");
+    if(format.attributeSize[tangentIndex] != 4)
+    {
+        format.attributeSize[tangentIndex] = 4;
+        mesh->updateStrides();
+    }
+
+    std::vector<float> data;
+    storeAttribute(tangents, numNewVertices, 4, mesh->getStride(Mesh::TANGENT), data);
+    mesh->setTangents(data);
+
+    if(mesh->hasBitangents())
+    {
+        int bitangentIndex = mesh->getAttributeIndexWithName("BITANGENT");
+        storeAttribute(bitangentValues, numNewVertices, format.attributeSize[bitangentIndex],
+                       mesh->getStride(Mesh::BITANGENT), data);
+        mesh->setBitangents(data);
+    }
+
+    return numNewVertices - numVertices;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2011 Peter Vasil
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _TANGENTTOOL_H_
+#define _TANGENTTOOL_H_
+
+#include "Mesh.h"
+
+namespace assembly3d
+{
+    namespace wiz
+    {
+        /**
+         * @brief Class for generating tangent frames.
+         *
+        */
+        class TangentTool
+        {
+        public:
+            TangentTool();
+            ~TangentTool();
+
+            /**
+             * @brief Replaces tangents and bitangents with generated ones.
+             *
+             * Follows the MikkTSpace conventions. Every triangle gets a
+             * texture space tangent and a handedness from the sign of its
+             * UV area. At every vertex the tangents are projected into the
+             * normal's plane, weighted by the corner angle and summed per
+             * handedness. A vertex used by triangles of both handedness is
+             * split. The result is orthonormalized against the normal and
+             * the bitangent is sign * cross(normal, tangent). TANGENT is
+             * stored with four components, the sign in w.
+             *
+             * @param mesh The mesh to work on, with normals and texture coordinates.
+             * @param bitangents True to write bitangents too.
+             * @return Number of vertices added by splitting, -1 if normals
+             * or texture coordinates are missing.
+             */
+            int generateTangents(Mesh* mesh, bool bitangents);
+        };
+    }
+}
+
+#endif  // _TANGENTTOOL_H_
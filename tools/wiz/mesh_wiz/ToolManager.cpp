@@ -47,7 +47,17 @@ ToolManager::ToolManager(Mesh* mesh, bool verbose)
       m_optimizeTool(new OptimizeTool()),
       m_frontFaceTool(new FrontFaceTool()),
       m_textureTool(new BakeTool()),
-      m_meshTool(new MeshTool())
+      m_meshTool(new MeshTool()),
+      m_modifierTool(new ModifierTool()),
+      m_normalTool(new NormalTool()),
+      m_tangentTool(new TangentTool()),
+      m_simplifyTool(new SimplifyTool()),
+      m_meshletTool(new MeshletTool()),
+      m_quantizeTool(new QuantizeTool()),
+      m_partitionTool(new PartitionTool()),
+      m_stackTransforms(false),
+      m_hasStackMatrix(false),
+      m_hasStackTexCoordMatrix(false)
 {
 }
 
@@ -59,16 +69,24 @@ ToolManager::~ToolManager()
     SAFE_DELETE(m_frontFaceTool);
     SAFE_DELETE(m_textureTool);
     SAFE_DELETE(m_meshTool);
+    SAFE_DELETE(m_modifierTool);
+    SAFE_DELETE(m_normalTool);
+    SAFE_DELETE(m_tangentTool);
+    SAFE_DELETE(m_simplifyTool);
+    SAFE_DELETE(m_meshletTool);
+    SAFE_DELETE(m_quantizeTool);
+    SAFE_DELETE(m_partitionTool);
 }
 
 bool ToolManager::convertIndexType(const char* type)
 {
+    std::string stype = type;
     if(m_verboseOutput) 
-        std::cout << "Converting index type to 'unsigned " << type << "'" << std::endl;
+        std::cout << "Converting index type to '" << (stype.compare("encoded") == 0 ? "" : "unsigned ")
+                  << type << "'" << std::endl;
     
     bool result = false;
 
-    std::string stype = type;
     if(stype.compare("int") == 0)
     {
         m_convertTool->convertIndicesToUnsignedInt(m_mesh);
@@ -76,65 +94,74 @@ bool ToolManager::convertIndexType(const char* type)
     }    
     else if(stype.compare("short") == 0)
     {
-        int sizeInt = sizeof(unsigned short)*8;
-        if(m_mesh->getNumberOfVertices() > (pow(2.0,sizeInt)))
-        {
-            result = false;
-        }
-        else
-        {
-            m_convertTool->convertIndicesToUnsignedShort(m_mesh);
-            result = true;
-        }
+        m_convertTool->convertIndicesToUnsignedShort(m_mesh);
+        result = true;
     }
     else if(stype.compare("byte") == 0)
     {
-        int sizeInt = sizeof(unsigned char)*8;
-        if(m_mesh->getNumberOfVertices() > (pow(2.0,sizeInt)))
-        {
-            result = false;
-        }
-        else
-        {
-            m_convertTool->convertIndicesToUnsignedByte(m_mesh);
-            result = true;
-        }
+        m_convertTool->convertIndicesToUnsignedByte(m_mesh);
+        result = true;
+    }
+    else if(stype.compare("encoded") == 0)
+    {
+        m_convertTool->convertIndicesToEncoded(m_mesh);
+        result = true;
     }
     return result;
 }
 
+bool ToolManager::convertPrimitiveType(const char* type)
+{
+    std::string stype = type;
+    if(m_verboseOutput)
+        std::cout << "Converting primitive type to '" << type << "'" << std::endl;
+
+    if(stype.compare("triangles") == 0)
+    {
+        m_convertTool->convertPrimitivesToTriangles(m_mesh);
+        return true;
+    }
+    if(stype.compare("strips") == 0)
+    {
+        if(m_mesh->getMeshFormat().indexType.compare("ENCODED") == 0)
+            return false;
+
+        m_convertTool->convertPrimitivesToTriangleStrips(m_mesh);
+        return true;
+    }
+    return false;
+}
+
+bool ToolManager::compressAttributes(const std::vector<std::string>& names)
+{
+    if(m_verboseOutput)
+    {
+        std::cout << "Compressing attributes";
+        for(size_t i = 0; i < names.size(); ++i)
+            std::cout << (i == 0 ? " " : ", ") << names[i];
+        std::cout << (names.empty() ? ": none" : "") << std::endl;
+    }
+
+    return m_convertTool->setCompressedAttributes(m_mesh, names);
+}
+
 void ToolManager::translate(float tx, float ty, float tz, bool transformTexCoords)
 {
     if(m_verboseOutput) 
         std::cout << "Translating mesh (x=" << tx << ", y=" << ty << ", z=" << tz << ")" << std::endl;
     
-    Mesh::Attribute attrib;
+    float matrix[3][4];
+    TransformTool::getTranslationMatrix(matrix, tx, ty, tz, false);
 
     if(transformTexCoords)
     {
-        attrib = m_mesh->getAttribute(Mesh::TEXCOORD);
-        m_transformTool->translate(&attrib, tx, ty, tz, false);
+        transformMesh(0, 0, matrix);
     }
     else
     {
-        attrib = m_mesh->getAttribute(Mesh::POSITION);
-        m_transformTool->translate(&attrib, tx, ty, tz, false);
-
-        if(m_mesh->hasNormals())
-        {
-            attrib = m_mesh->getAttribute(Mesh::NORMAL);
-            m_transformTool->translate(&attrib, tx, ty, tz, true);
-        }
-        if(m_mesh->hasTangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::TANGENT);
-            m_transformTool->translate(&attrib, tx, ty, tz, true);
-        }
-        if(m_mesh->hasBitangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::BITANGENT);
-            m_transformTool->translate(&attrib, tx, ty, tz, true);
-        }
+        float normalMatrix[3][4];
+        TransformTool::getTranslationMatrix(normalMatrix, tx, ty, tz, true);
+        transformMesh(matrix, normalMatrix, 0);
     }
 }
 
@@ -143,34 +170,14 @@ void ToolManager::rotate(float rangle, float rx, float ry, float rz, bool transf
     if(m_verboseOutput) 
         std::cout << "Rotating mesh (angle=" << rangle << ", x=" << rx << ", y=" << ry << ", z=" << rz << ")" << std::endl;
     
-    Mesh::Attribute attrib;
+    // A rotation is its own inverse transpose.
+    float matrix[3][4];
+    TransformTool::getRotationMatrix(matrix, rangle, rx, ry, rz);
 
     if(transformTexCoords)
-    {
-        attrib = m_mesh->getAttribute(Mesh::TEXCOORD);
-        m_transformTool->rotate(&attrib, rangle, rx, ry, rz);
-    }
+        transformMesh(0, 0, matrix);
     else
-    {
-        attrib = m_mesh->getAttribute(Mesh::POSITION);
-        m_transformTool->rotate(&attrib, rangle, rx, ry, rz);
-
-        if(m_mesh->hasNormals())
-        {
-            attrib = m_mesh->getAttribute(Mesh::NORMAL);
-            m_transformTool->rotate(&attrib, rangle, rx, ry, rz, true);
-        }
-        if(m_mesh->hasTangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::TANGENT);
-            m_transformTool->rotate(&attrib, rangle, rx, ry, rz, true);
-        }
-        if(m_mesh->hasBitangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::BITANGENT);
-            m_transformTool->rotate(&attrib, rangle, rx, ry, rz, true);
-        }
-    }
+        transformMesh(matrix, matrix, 0);
 }
 
 void ToolManager::scale(float sx, float sy, float sz, bool transformTexCoords)
@@ -178,32 +185,18 @@ void ToolManager::scale(float sx, float sy, float sz, bool transformTexCoords)
     if(m_verboseOutput) 
         std::cout << "Scaling mesh (x=" << sx << ", y=" << sy << ", z=" << sz << ")" << std::endl;
 
-    Mesh::Attribute attrib;
+    float matrix[3][4];
+    TransformTool::getScaleMatrix(matrix, sx, sy, sz);
+
     if(transformTexCoords)
     {
-        attrib = m_mesh->getAttribute(Mesh::TEXCOORD);
-        m_transformTool->scale(&attrib, sx, sy, sz);
+        transformMesh(0, 0, matrix);
     }
     else
     {
-        attrib = m_mesh->getAttribute(Mesh::POSITION);
-        m_transformTool->scale(&attrib, sx, sy, sz);
-
-        if(m_mesh->hasNormals())
-        {
-            attrib = m_mesh->getAttribute(Mesh::NORMAL);
-            m_transformTool->scale(&attrib, sx, sy, sz, true);
-        }
-        if(m_mesh->hasTangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::TANGENT);
-            m_transformTool->scale(&attrib, sx, sy, sz, true);
-        }
-        if(m_mesh->hasBitangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::BITANGENT);
-            m_transformTool->scale(&attrib, sx, sy, sz, true);
-        }
+        float normalMatrix[3][4];
+        TransformTool::getScaleMatrix(normalMatrix, sx, sy, sz, true);
+        transformMesh(matrix, normalMatrix, 0);
     }
 }
 
@@ -287,29 +280,10 @@ void ToolManager::remapAxes(const char* newX, const char* newY, const char* newZ
 	}
 	if(malformed == false)
 	{
-		Mesh::Attribute pos = m_mesh->getAttribute(Mesh::POSITION);
-		m_transformTool->remapAxes(&pos, axes[0], axes[1], axes[2]);
-		
-		if(m_mesh->hasNormals())
-		{
-			Mesh::Attribute normal = m_mesh->getAttribute(Mesh::NORMAL);
-			m_transformTool->remapAxes(&normal, axes[0], axes[1], axes[2], true);
-		}
-		if(m_mesh->hasTexCoords())
-		{
-			Mesh::Attribute texCoord = m_mesh->getAttribute(Mesh::TEXCOORD);
-			m_transformTool->remapAxes(&texCoord, axes[0], axes[1], axes[2], true);
-		}
-		if(m_mesh->hasTangents())
-		{
-			Mesh::Attribute tangent = m_mesh->getAttribute(Mesh::TEXCOORD);
-			m_transformTool->remapAxes(&tangent, axes[0], axes[1], axes[2], true);
-		}
-		if(m_mesh->hasBitangents())
-		{
-			Mesh::Attribute bitangent = m_mesh->getAttribute(Mesh::TEXCOORD);
-			m_transformTool->remapAxes(&bitangent, axes[0], axes[1], axes[2], true);
-		}	
+		// Axis permutations are their own inverse transpose.
+		float matrix[3][4];
+		TransformTool::getAxesMatrix(matrix, axes[0], axes[1], axes[2]);
+		transformMesh(matrix, matrix, matrix);
 	}
 	else 
 	{
@@ -321,34 +295,21 @@ void ToolManager::resize(float rsx, float rsy, float rsz, bool transformTexCoord
 {
     if(m_verboseOutput) 
         std::cout << "Resizing mesh (x=" << rsx << ", y=" << rsy << ", z=" << rsz << ")" << std::endl;
+    // Reads the bounds, so pending stacked transformations go first.
+    flushTransformStack();
+
+    float matrix[3][4];
+    TransformTool::getResizeMatrix(matrix, rsx, rsy, rsz, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength());
 
-    Mesh::Attribute attrib;
     if(transformTexCoords)
     {
-        attrib = m_mesh->getAttribute(Mesh::TEXCOORD);
-        m_transformTool->resize(&attrib, rsx, rsy, rsz, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength());
+        transformMesh(0, 0, matrix);
     }
     else
     {
-
-        attrib = m_mesh->getAttribute(Mesh::POSITION);
-        m_transformTool->resize(&attrib, rsx, rsy, rsz, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength());
-
-        if(m_mesh->hasNormals())
-        {
-            attrib = m_mesh->getAttribute(Mesh::NORMAL);
-            m_transformTool->resize(&attrib, rsx, rsy, rsz, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
-        }
-        if(m_mesh->hasTangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::TANGENT);
-            m_transformTool->resize(&attrib, rsx, rsy, rsz, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
-        }
-        if(m_mesh->hasBitangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::BITANGENT);
-            m_transformTool->resize(&attrib, rsx, rsy, rsz, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
-        }
+        float normalMatrix[3][4];
+        TransformTool::getResizeMatrix(normalMatrix, rsx, rsy, rsz, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
+        transformMesh(matrix, normalMatrix, 0);
     }
 }
 
@@ -356,34 +317,21 @@ void ToolManager::resize(const char* axis, float val, bool transformTexCoords)
 {
     if(m_verboseOutput) 
         std::cout << "Resizing mesh on axis=" << axis << " to value=" << val << std::endl;
+    // Reads the bounds, so pending stacked transformations go first.
+    flushTransformStack();
 
-    Mesh::Attribute attrib;
+    float matrix[3][4];
+    TransformTool::getResizeMatrix(matrix, axis[0], val, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength());
 
     if(transformTexCoords)
     {
-        attrib = m_mesh->getAttribute(Mesh::TEXCOORD);
-        m_transformTool->resize(&attrib, axis[0], val, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength());
+        transformMesh(0, 0, matrix);
     }
     else
     {
-        attrib = m_mesh->getAttribute(Mesh::POSITION);
-        m_transformTool->resize(&attrib, axis[0], val, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength());
-
-        if(m_mesh->hasNormals())
-        {
-            attrib = m_mesh->getAttribute(Mesh::NORMAL);
-            m_transformTool->resize(&attrib, axis[0], val, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
-        }
-        if(m_mesh->hasTangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::TANGENT);
-            m_transformTool->resize(&attrib, axis[0], val, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
-        }
-        if(m_mesh->hasBitangents())
-        {
-            attrib = m_mesh->getAttribute(Mesh::BITANGENT);
-            m_transformTool->resize(&attrib, axis[0], val, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
-        }
+        float normalMatrix[3][4];
+        TransformTool::getResizeMatrix(normalMatrix, axis[0], val, m_mesh->getWidth(), m_mesh->getHeight(), m_mesh->getLength(), true);
+        transformMesh(matrix, normalMatrix, 0);
     }
 }
 
@@ -391,44 +339,133 @@ void ToolManager::center(int axisX, int axisY, int axisZ, bool transformTexCoord
 {
     if(m_verboseOutput)
         std::cout << "Centering mesh" << std::endl;
+    // Reads the bounds, so pending stacked transformations go first.
+    flushTransformStack();
 
     float centerX, centerY, centerZ;
     centerX = centerY = centerZ = 0.0f;
     m_mesh->getCenter(centerX, centerY, centerZ);
 
-    Mesh::Attribute attrib;
+    float matrix[3][4];
+    TransformTool::getCenterMatrix(matrix, axisX, axisY, axisZ, centerX, centerY, centerZ);
+
     if(transformTexCoords)
     {
-        attrib = m_mesh->getAttribute(Mesh::TEXCOORD);
-        m_transformTool->center(&attrib, axisX, axisY, axisZ, centerX, centerY, centerZ);
+        transformMesh(0, 0, matrix);
     }
     else
+    {
+        float normalMatrix[3][4];
+        TransformTool::getCenterMatrix(normalMatrix, axisX, axisY, axisZ, centerX, centerY, centerZ, true);
+        transformMesh(matrix, normalMatrix, 0);
+    }
+}
+
+void ToolManager::beginTransformStack()
+{
+    m_stackTransforms = true;
+    m_hasStackMatrix = false;
+    m_hasStackTexCoordMatrix = false;
+}
+
+void ToolManager::endTransformStack()
+{
+    if(m_stackTransforms == false)
+        return;
+
+    flushTransformStack();
+    m_stackTransforms = false;
+}
+
+void ToolManager::flushTransformStack()
+{
+    if(m_hasStackMatrix || m_hasStackTexCoordMatrix)
+    {
+        if(m_verboseOutput)
+            std::cout << "Applying stacked transformations" << std::endl;
+
+        // Applied directly, later transformations are collected again.
+        m_stackTransforms = false;
+        transformMesh(m_hasStackMatrix ? m_stackMatrix : 0,
+                      m_hasStackMatrix ? m_stackNormalMatrix : 0,
+                      m_hasStackTexCoordMatrix ? m_stackTexCoordMatrix : 0);
+        m_stackTransforms = true;
+    }
+    m_hasStackMatrix = false;
+    m_hasStackTexCoordMatrix = false;
+}
+
+void ToolManager::transformMesh(float matrix[3][4], float normalMatrix[3][4],
+                                float texCoordMatrix[3][4])
+{
+    if(m_stackTransforms)
+    {
+        // Later transformations are applied after the stacked ones.
+        if(matrix)
+        {
+            if(m_hasStackMatrix)
+            {
+                TransformTool::multiply(m_stackMatrix, matrix, m_stackMatrix);
+                TransformTool::multiply(m_stackNormalMatrix, normalMatrix, m_stackNormalMatrix);
+            }
+            else
+            {
+                TransformTool::copy(m_stackMatrix, matrix);
+                TransformTool::copy(m_stackNormalMatrix, normalMatrix);
+                m_hasStackMatrix = true;
+            }
+        }
+        if(texCoordMatrix)
+        {
+            if(m_hasStackTexCoordMatrix)
+            {
+                TransformTool::multiply(m_stackTexCoordMatrix, texCoordMatrix, m_stackTexCoordMatrix);
+            }
+            else
+            {
+                TransformTool::copy(m_stackTexCoordMatrix, texCoordMatrix);
+                m_hasStackTexCoordMatrix = true;
+            }
+        }
+        return;
+    }
+
+    Mesh::Attribute attrib;
+    if(matrix)
     {
         attrib = m_mesh->getAttribute(Mesh::POSITION);
-        m_transformTool->center(&attrib, axisX, axisY, axisZ, centerX, centerY, centerZ);
-        
+        m_transformTool->transform(&attrib, matrix);
+        m_mesh->invalidateNormals();
+        m_mesh->calculateBounds();
+
         if(m_mesh->hasNormals())
         {
             attrib = m_mesh->getAttribute(Mesh::NORMAL);
-            m_transformTool->center(&attrib, axisX, axisY, axisZ, centerX, centerY, centerZ, true);
+            m_transformTool->transform(&attrib, normalMatrix);
         }
         if(m_mesh->hasTangents())
         {
             attrib = m_mesh->getAttribute(Mesh::TANGENT);
-            m_transformTool->center(&attrib, axisX, axisY, axisZ, centerX, centerY, centerZ, true);
+            m_transformTool->transform(&attrib, normalMatrix);
         }
         if(m_mesh->hasBitangents())
         {
             attrib = m_mesh->getAttribute(Mesh::BITANGENT);
-            m_transformTool->center(&attrib, axisX, axisY, axisZ, centerX, centerY, centerZ, true);
+            m_transformTool->transform(&attrib, normalMatrix);
         }
     }
+    if(texCoordMatrix && m_mesh->hasTexCoords())
+    {
+        attrib = m_mesh->getAttribute(Mesh::TEXCOORD);
+        m_transformTool->transform(&attrib, texCoordMatrix);
+    }
 }
 
 void ToolManager::stitch()
 {
     if(m_verboseOutput)
         std::cout << "Stitching vertices" << std::endl;
+    flushTransformStack();
 
     m_optimizeTool->stitch(m_mesh);
 }
@@ -437,6 +474,7 @@ void ToolManager::stitchEps(const char* attributeName, float epsilon)
 {
     if(m_verboseOutput)
         std::cout << "Stitching vertices. Comparing " << attributeName << " with an epsilon of " << epsilon << std::endl;
+    flushTransformStack();
 
     Mesh::AttributeType attrib;
 
@@ -464,11 +502,132 @@ void ToolManager::stitchEps(const char* attributeName, float epsilon)
     {
         std::cout << "No suitable attribute given, stiching without epsilon" << std::endl;
         m_optimizeTool->stitch(m_mesh);
+        return;
     }
     m_optimizeTool->stitch(m_mesh, attrib, epsilon);
 
 }
 
+void ToolManager::optimizeIndices()
+{
+    if(m_verboseOutput)
+        std::cout << "Optimizing indices for GPU cache" << std::endl;
+    flushTransformStack();
+
+    float acmrBefore, atvrBefore, acmrAfter, atvrAfter;
+    m_optimizeTool->analyzeVertexCache(m_mesh, OptimizeTool::VERTEX_CACHE_SIZE, acmrBefore, atvrBefore);
+
+    m_optimizeTool->optimizeIndices(m_mesh);
+
+    m_optimizeTool->analyzeVertexCache(m_mesh, OptimizeTool::VERTEX_CACHE_SIZE, acmrAfter, atvrAfter);
+    if(m_verboseOutput)
+    {
+        std::cout << "ACMR: " << acmrBefore << " -> " << acmrAfter << std::endl;
+        std::cout << "ATVR: " << atvrBefore << " -> " << atvrAfter << std::endl;
+    }
+}
+
+void ToolManager::optimizeVertices()
+{
+    if(m_verboseOutput)
+        std::cout << "Optimizing vertices order for GPU cache" << std::endl;
+    flushTransformStack();
+
+    m_optimizeTool->optimizeVertices(m_mesh);
+}
+
+void ToolManager::simplify(float ratio, float maxError)
+{
+    if(m_verboseOutput)
+        std::cout << "Simplifying to " << ratio << " of the triangles, max error " << maxError << std::endl;
+    flushTransformStack();
+
+    int numTriangles = m_mesh->getNumberOfTriangles();
+    float error = m_simplifyTool->simplify(m_mesh, ratio, maxError);
+
+    if(m_verboseOutput)
+        std::cout << "Triangles " << numTriangles << " -> " << m_mesh->getNumberOfTriangles()
+                  << ", error " << error << std::endl;
+}
+
+void ToolManager::appendLodGroups(int numLevels, float ratio, float maxError)
+{
+    if(m_verboseOutput)
+        std::cout << "Appending " << numLevels << " levels of detail as groups" << std::endl;
+    flushTransformStack();
+
+    m_simplifyTool->appendLodGroups(m_mesh, numLevels, ratio, maxError);
+}
+
+void ToolManager::createLodMeshes(int numLevels, float ratio, float maxError, std::vector<Mesh*>& lods)
+{
+    if(m_verboseOutput)
+        std::cout << "Creating " << numLevels << " levels of detail" << std::endl;
+    flushTransformStack();
+
+    m_simplifyTool->createLodMeshes(m_mesh, numLevels, ratio, maxError, lods);
+
+    if(m_verboseOutput)
+    {
+        for(size_t i = 0; i < lods.size(); ++i)
+            std::cout << "Level " << i+1 << ": " << lods[i]->getNumberOfTriangles() << " triangles" << std::endl;
+    }
+}
+
+void ToolManager::buildMeshlets(int maxVertices, int maxTriangles, Meshlets* meshlets)
+{
+    if(m_verboseOutput)
+        std::cout << "Building meshlets of at most " << maxVertices << " vertices and "
+                  << maxTriangles << " triangles" << std::endl;
+
+    m_meshletTool->buildMeshlets(m_mesh, maxVertices, maxTriangles, meshlets);
+
+    if(m_verboseOutput)
+    {
+        int numMeshlets = meshlets->getNumberOfMeshlets();
+        std::cout << numMeshlets << " meshlets";
+        if(numMeshlets > 0)
+            std::cout << ", " << static_cast<float>(m_mesh->getNumberOfTriangles()) / static_cast<float>(numMeshlets)
+                      << " triangles on average";
+        std::cout << std::endl;
+    }
+}
+
+void ToolManager::quantize(float maxError)
+{
+    if(m_verboseOutput)
+        std::cout << "Quantizing attributes, max error " << maxError << std::endl;
+
+    std::string resMsg;
+
+    m_quantizeTool->quantize(m_mesh, maxError, resMsg);
+
+    if(m_verboseOutput)
+        std::cout << resMsg << std::endl;
+}
+
+bool ToolManager::partitionIndices()
+{
+    // One value short of the index type, strips keep the largest one for
+    // their restart index.
+    const std::string& indexType = m_mesh->getMeshFormat().indexType;
+    int maxVertices = 0;
+    if(indexType.compare("UNSIGNED_SHORT") == 0)
+        maxVertices = 0xffff;
+    else if(indexType.compare("UNSIGNED_BYTE") == 0)
+        maxVertices = 0xff;
+    else
+        return false;
+
+    std::string resMsg;
+    if(m_partitionTool->partition(m_mesh, maxVertices, resMsg) == false)
+        return false;
+
+    if(m_verboseOutput)
+        std::cout << "Partitioning groups for " << indexType << " indices: " << resMsg << std::endl;
+    return true;
+}
+
 void ToolManager::flip()
 {
     if(m_verboseOutput)
@@ -501,6 +660,60 @@ bool ToolManager::makeNormalsConsistent()
     return modelChanged;
 }
 
+bool ToolManager::orientFrontFaces()
+{
+    if(m_verboseOutput)
+        std::cout << "Orienting front-faces" << std::endl;
+
+    std::string resMsg;
+
+    bool modelChanged = m_frontFaceTool->orientTriangles(m_mesh, resMsg);
+
+    if(m_verboseOutput)
+        std::cout << resMsg << std::endl;
+
+    return modelChanged;
+}
+
+bool ToolManager::generateNormals(const char* weighting, float creaseAngle)
+{
+    std::string sweighting = weighting;
+    MeshNormals::Weighting type;
+    if(sweighting.compare("area") == 0)
+        type = MeshNormals::AREA_WEIGHTED;
+    else if(sweighting.compare("angle") == 0)
+        type = MeshNormals::ANGLE_WEIGHTED;
+    else if(sweighting.compare("none") == 0)
+        type = MeshNormals::UNWEIGHTED;
+    else
+        return false;
+
+    if(m_verboseOutput)
+        std::cout << "Generating " << sweighting << " weighted normals, crease angle " << creaseAngle << std::endl;
+
+    int numSplit = m_normalTool->generateNormals(m_mesh, type, creaseAngle);
+
+    if(m_verboseOutput && numSplit > 0)
+        std::cout << "Split " << numSplit << " vertices at creases" << std::endl;
+
+    return true;
+}
+
+bool ToolManager::generateTangents(bool bitangents)
+{
+    if(m_verboseOutput)
+        std::cout << "Generating tangents" << (bitangents ? " and bitangents" : "") << std::endl;
+
+    int numSplit = m_tangentTool->generateTangents(m_mesh, bitangents);
+    if(numSplit < 0)
+        return false;
+
+    if(m_verboseOutput && numSplit > 0)
+        std::cout << "Split " << numSplit << " vertices at texture mirror seams" << std::endl;
+
+    return true;
+}
+
 bool ToolManager::checkFrontFaceConsistenty(int& numOutwards, int& numInwards)
 {
     std::vector<int> vertsOutwards;
@@ -532,3 +745,17 @@ void ToolManager::mergeMeshes(Mesh *second)
 {
     m_meshTool->merge(m_mesh, second);
 }
+
+bool ToolManager::applyModifiers(const std::vector<Modifier*>& modifiers,
+                                 const std::vector<float>& weights)
+{
+    if(m_verboseOutput)
+    {
+        for(size_t i = 0; i < modifiers.size(); ++i)
+        {
+            std::cout << "Applying modifier '" << modifiers[i]->getModifierPath() << "' with weight ";
+            std::cout << (i < weights.size() ? weights[i] : 1.0f) << std::endl;
+        }
+    }
+    return m_modifierTool->blend(m_mesh, modifiers, weights);
+}
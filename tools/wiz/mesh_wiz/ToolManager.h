@@ -40,6 +40,13 @@
 #include "FrontFaceTool.h"
 #include "BakeTool.h"
 #include "MeshTool.h"
+#include "ModifierTool.h"
+#include "NormalTool.h"
+#include "TangentTool.h"
+#include "SimplifyTool.h"
+#include "MeshletTool.h"
+#include "QuantizeTool.h"
+#include "PartitionTool.h"
 
 
 namespace assembly3d
@@ -66,9 +73,25 @@ namespace assembly3d
             /**
              * @brief Converts index type.
              *
-             * @param type The new index type (UNSIGNED_BYTE, UNSIGNED_SHORT and UNSIGNED_INT)
+             * @param type The new index type ("int", "short", "byte" or "encoded")
              */
             bool convertIndexType(const char* type);
+            /**
+             * @brief Converts primitive type.
+             *
+             * Strips need an index type with a restart index, so not
+             * ENCODED.
+             *
+             * @param type The new primitive type ("triangles" or "strips")
+             */
+            bool convertPrimitiveType(const char* type);
+            /**
+             * @brief Sets the vertex attributes stored compressed.
+             *
+             * @param names Attribute names, none if empty.
+             * @return False if the mesh lacks one of the attributes.
+             */
+            bool compressAttributes(const std::vector<std::string>& names);
             /**
              * @brief Translates mesh.
              *
@@ -120,6 +143,21 @@ namespace assembly3d
              * @param axisZ
              */
             void center(int axisX, int axisY, int axisZ, bool transformTexCoords=false);
+            /**
+             * @brief Starts collecting transformations instead of applying them.
+             *
+             * Translations, rotations, scales, resizes, axis remaps and
+             * centerings are composed into one matrix for positions and
+             * one for normals, tangents and bitangents. Passes that read
+             * the bounds or the geometry (resize, center, stitch, simplify
+             * and the optimizers) apply the collected ones first.
+             */
+            void beginTransformStack();
+            /**
+             * @brief Applies the collected transformations in one pass per attribute.
+             *
+             */
+            void endTransformStack();
             /**
              * @brief Stiches mesh.
              *
@@ -132,6 +170,64 @@ namespace assembly3d
              * @param epsilon
              */
             void stitchEps(const char* attributeName, float epsilon);
+            /**
+             * @brief Reorders triangles for the GPU post-transform cache.
+             *
+             */
+            void optimizeIndices();
+            /**
+             * @brief Reorders vertices for the GPU pre-transform cache.
+             *
+             */
+            void optimizeVertices();
+            /**
+             * @brief Reduces the triangle count with edge collapses.
+             *
+             * @param ratio Wanted ratio of remaining triangles.
+             * @param maxError Largest error, relative to the mesh size.
+             */
+            void simplify(float ratio, float maxError);
+            /**
+             * @brief Appends simplified levels of detail as groups.
+             *
+             * @param numLevels Number of levels.
+             * @param ratio Ratio of triangles from one level to the next.
+             * @param maxError Largest error, relative to the mesh size.
+             */
+            void appendLodGroups(int numLevels, float ratio, float maxError);
+            /**
+             * @brief Creates simplified levels of detail as new meshes.
+             *
+             * @param numLevels Number of levels.
+             * @param ratio Ratio of triangles from one level to the next.
+             * @param maxError Largest error, relative to the mesh size.
+             * @param lods Receives the meshes, owned by the caller.
+             */
+            void createLodMeshes(int numLevels, float ratio, float maxError, std::vector<Mesh*>& lods);
+            /**
+             * @brief Partitions the groups into meshlets.
+             *
+             * @param maxVertices Largest number of vertices per meshlet.
+             * @param maxTriangles Largest number of triangles per meshlet.
+             * @param meshlets Receives the meshlets.
+             */
+            void buildMeshlets(int maxVertices, int maxTriangles, Meshlets* meshlets);
+            /**
+             * @brief Chooses the smallest attribute encodings within an error bound.
+             *
+             * @param maxError Largest error per component, relative to the
+             * mesh size for positions.
+             */
+            void quantize(float maxError);
+            /**
+             * @brief Splits groups whose vertices exceed the index type.
+             *
+             * Only UNSIGNED_SHORT and UNSIGNED_BYTE indices are concerned.
+             * Every part is saved relative to its lowest vertex.
+             *
+             * @return True if the mesh has been changed.
+             */
+            bool partitionIndices();
             /**
              * @brief Flips front-face.
              *
@@ -144,12 +240,41 @@ namespace assembly3d
              *
              */
             bool makeNormalsConsistent();
+            /**
+             * @brief Makes the triangle winding consistent and outward facing.
+             *
+             */
+            bool orientFrontFaces();
+            /**
+             * @brief Generates vertex normals.
+             *
+             * @param weighting "area", "angle" or "none".
+             * @param creaseAngle Largest smoothed angle in degrees, 180 for no splitting.
+             * @return False if the weighting is unknown.
+             */
+            bool generateNormals(const char* weighting, float creaseAngle);
+            /**
+             * @brief Generates tangents from normals and texture coordinates.
+             *
+             * @param bitangents Also generates bitangents.
+             * @return False if normals or texture coordinates are missing.
+             */
+            bool generateTangents(bool bitangents);
             bool checkFrontFaceConsistenty(int& numOutwards, int& numInwards);
 
             int checkBakeable();
             int checkUVOverlapping();
 
             void mergeMeshes(Mesh* second);
+            /**
+             * @brief Blends modifiers onto the mesh.
+             *
+             * @param modifiers Modifiers to apply.
+             * @param weights One weight per modifier.
+             * @return False if a modifier does not fit the mesh.
+             */
+            bool applyModifiers(const std::vector<Modifier*>& modifiers,
+                                const std::vector<float>& weights);
 
         protected:
         private:
@@ -162,6 +287,35 @@ namespace assembly3d
             FrontFaceTool* m_frontFaceTool;
             BakeTool* m_textureTool;
             MeshTool* m_meshTool;
+            ModifierTool* m_modifierTool;
+            NormalTool* m_normalTool;
+            TangentTool* m_tangentTool;
+            SimplifyTool* m_simplifyTool;
+            MeshletTool* m_meshletTool;
+            QuantizeTool* m_quantizeTool;
+            PartitionTool* m_partitionTool;
+
+            /**
+             * @brief Applies or stacks a transformation.
+             *
+             * @param matrix Matrix for positions, 0 to leave them.
+             * @param normalMatrix Inverse transpose for normals, tangents and bitangents.
+             * @param texCoordMatrix Matrix for texture coordinates, 0 to leave them.
+             */
+            void transformMesh(float matrix[3][4], float normalMatrix[3][4],
+                               float texCoordMatrix[3][4]);
+            /**
+             * @brief Applies the collected transformations and keeps collecting.
+             *
+             */
+            void flushTransformStack();
+
+            bool m_stackTransforms;
+            bool m_hasStackMatrix;
+            bool m_hasStackTexCoordMatrix;
+            float m_stackMatrix[3][4];
+            float m_stackNormalMatrix[3][4];
+            float m_stackTexCoordMatrix[3][4];
         };
     }
 }
@@ -35,6 +35,11 @@
 #include "TransformTool.h"
 #include <cmath>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define A3D_USE_SSE
+#include <xmmintrin.h>
+#endif
+
 #define PIf		3.1415926535897932384626433832795f
 
 using namespace assembly3d;
@@ -52,21 +57,84 @@ TransformTool::~TransformTool()
 void TransformTool::translate(Mesh::Attribute *attribute, float tx, float ty,
                               float tz, bool inverseTranspose)
 {
-    float matrix[3][4] = {{1.0f,0.0f,0.0f,tx},
-                         {0.0f,1.0f,0.0f,ty},
-                         {0.0f,0.0f,1.0f,tz}};
+    float matrix[3][4];
+    getTranslationMatrix(matrix, tx, ty, tz, inverseTranspose);
+	transform(attribute, matrix);
+}
+
+void TransformTool::rotate(Mesh::Attribute *attribute, float rangle, float rx,
+                           float ry, float rz, bool inverseTranspose)
+{
+    float matrix[3][4];
+    getRotationMatrix(matrix, rangle, rx, ry, rz);
+    transform(attribute, matrix);
+}
+
+void TransformTool::scale(Mesh::Attribute* attribute, float sx, float sy,
+                          float sz, bool inverseTranspose)
+{
+    float matrix[3][4];
+    getScaleMatrix(matrix, sx, sy, sz, inverseTranspose);
+	transform(attribute, matrix);
+}
+
+void TransformTool::resize(Mesh::Attribute* attribute, float width, float height,
+                           float length, float mWidth, float mHeight,float mLength,
+                           bool inverseTranspose)
+{
+    float matrix[3][4];
+    getResizeMatrix(matrix, width, height, length, mWidth, mHeight, mLength,
+                    inverseTranspose);
+    transform(attribute, matrix);
+}
+
+void TransformTool::resize(Mesh::Attribute* attribute, const char axis,
+                           float val, float mWidth, float mHeight,float mLength,
+                           bool inverseTranspose)
+{
+    float matrix[3][4];
+    getResizeMatrix(matrix, axis, val, mWidth, mHeight, mLength,
+                    inverseTranspose);
+    transform(attribute, matrix);
+}
+
+void TransformTool::center(Mesh::Attribute* attribute, int ax, int ay, int az,
+                           float centerX, float centerY, float centerZ,
+                           bool inverseTranspose)
+{
+    float matrix[3][4];
+    getCenterMatrix(matrix, ax, ay, az, centerX, centerY, centerZ,
+                    inverseTranspose);
+    transform(attribute, matrix);
+}
+
+void TransformTool::remapAxes(Mesh::Attribute* attribute, float matrixCol1[3],
+							  float matrixCol2[3], float matrixCol3[3], 
+							  bool inverseTranspose)
+{
+    float matrix[3][4];
+    getAxesMatrix(matrix, matrixCol1, matrixCol2, matrixCol3);
+	transform(attribute, matrix);
+}
+
+void TransformTool::getTranslationMatrix(float matrix[3][4], float tx, float ty,
+                                         float tz, bool inverseTranspose)
+{
+    float translation[3][4] = {{1.0f,0.0f,0.0f,tx},
+                               {0.0f,1.0f,0.0f,ty},
+                               {0.0f,0.0f,1.0f,tz}};
 
     if(inverseTranspose)
     {
-        matrix[0][3] = 0.0f;
-        matrix[1][3] = 0.0f;
-        matrix[2][3] = 0.0f;
+        translation[0][3] = 0.0f;
+        translation[1][3] = 0.0f;
+        translation[2][3] = 0.0f;
     }
-	transform(attribute, matrix);
+    copy(matrix, translation);
 }
 
-void TransformTool::rotate(Mesh::Attribute *attribute, float rangle, float rx,
-                           float ry, float rz, bool inverseTranspose)
+void TransformTool::getRotationMatrix(float matrix[3][4], float rangle, float rx,
+                                      float ry, float rz)
 {
     // normalize rotation axis
     float rvec[3] = {rx, ry, rz};
@@ -79,43 +147,42 @@ void TransformTool::rotate(Mesh::Attribute *attribute, float rangle, float rx,
     float c = cosf(2.0f*PIf*rangle/360.0f);
     float t = 1.0f - c;
 
-    float matrix[3][4] = {{rx*rx*t + c,     rx*ry*t - rz*s, rx*rz*t + ry*s, 0.0f},
-                          {rx*ry*t + rz*s,  ry*ry*t + c,    ry*rz*t - rx*s, 0.0f},
-                          {rz*rx*t - ry*s,  rz*ry*t + rx*s, rz*rz*t + c,    0.0f}};
-
-    transform(attribute, matrix);
+    float rotation[3][4] = {{rx*rx*t + c,     rx*ry*t - rz*s, rx*rz*t + ry*s, 0.0f},
+                            {rx*ry*t + rz*s,  ry*ry*t + c,    ry*rz*t - rx*s, 0.0f},
+                            {rz*rx*t - ry*s,  rz*ry*t + rx*s, rz*rz*t + c,    0.0f}};
+    copy(matrix, rotation);
 }
 
-void TransformTool::scale(Mesh::Attribute* attribute, float sx, float sy,
-                          float sz, bool inverseTranspose)
+void TransformTool::getScaleMatrix(float matrix[3][4], float sx, float sy,
+                                   float sz, bool inverseTranspose)
 {
-    float matrix[3][4] = {{sx,0.0f,0.0f,0.0f},
-                         {0.0f,sy,0.0f,0.0f},
-                         {0.0f,0.0f,sz,0.0f}};
+    float scaling[3][4] = {{sx,0.0f,0.0f,0.0f},
+                           {0.0f,sy,0.0f,0.0f},
+                           {0.0f,0.0f,sz,0.0f}};
 
     if(inverseTranspose)
     {
-        matrix[0][0] = 1.0f/sx;
-        matrix[1][1] = 1.0f/sy;
-        matrix[2][2] = 1.0f/sz;
+        scaling[0][0] = 1.0f/sx;
+        scaling[1][1] = 1.0f/sy;
+        scaling[2][2] = 1.0f/sz;
     }
-	transform(attribute, matrix);
+    copy(matrix, scaling);
 }
 
-void TransformTool::resize(Mesh::Attribute* attribute, float width, float height,
-                           float length, float mWidth, float mHeight,float mLength,
-                           bool inverseTranspose)
+void TransformTool::getResizeMatrix(float matrix[3][4], float width, float height,
+                                    float length, float mWidth, float mHeight,
+                                    float mLength, bool inverseTranspose)
 {
     float rsx = width/mWidth;
     float rsy = height/mHeight;
     float rsz = length/mLength;
 
-    scale(attribute, rsx, rsy, rsz, inverseTranspose);
+    getScaleMatrix(matrix, rsx, rsy, rsz, inverseTranspose);
 }
 
-void TransformTool::resize(Mesh::Attribute* attribute, const char axis,
-                           float val, float mWidth, float mHeight,float mLength,
-                           bool inverseTranspose)
+void TransformTool::getResizeMatrix(float matrix[3][4], const char axis, float val,
+                                    float mWidth, float mHeight, float mLength,
+                                    bool inverseTranspose)
 {
     float rsx, rsy, rsz;
     rsx = rsy = rsz = 0.0f;
@@ -138,12 +205,12 @@ void TransformTool::resize(Mesh::Attribute* attribute, const char axis,
         rsy = rsz;
     }
 
-    scale(attribute, rsx, rsy, rsz, inverseTranspose);
+    getScaleMatrix(matrix, rsx, rsy, rsz, inverseTranspose);
 }
 
-void TransformTool::center(Mesh::Attribute* attribute, int ax, int ay, int az,
-                           float centerX, float centerY, float centerZ,
-                           bool inverseTranspose)
+void TransformTool::getCenterMatrix(float matrix[3][4], int ax, int ay, int az,
+                                    float centerX, float centerY, float centerZ,
+                                    bool inverseTranspose)
 {
     float tX, tY, tZ;
     tX = tY = tZ = 0.0f;
@@ -160,18 +227,43 @@ void TransformTool::center(Mesh::Attribute* attribute, int ax, int ay, int az,
         tZ = -centerZ;
     }
 
-    translate(attribute, tX, tY, tZ, inverseTranspose);
+    getTranslationMatrix(matrix, tX, tY, tZ, inverseTranspose);
 }
 
-void TransformTool::remapAxes(Mesh::Attribute* attribute, float matrixCol1[3],
-							  float matrixCol2[3], float matrixCol3[3], 
-							  bool inverseTranspose)
+void TransformTool::getAxesMatrix(float matrix[3][4], float matrixCol1[3],
+                                  float matrixCol2[3], float matrixCol3[3])
 {
-    float matrix[3][4] = {{matrixCol1[0],matrixCol2[0],matrixCol3[0],0.0f},
-						  {matrixCol1[1],matrixCol2[1],matrixCol3[1],0.0f},
-						  {matrixCol1[2],matrixCol2[2],matrixCol3[2],0.0f}};
+    float axes[3][4] = {{matrixCol1[0],matrixCol2[0],matrixCol3[0],0.0f},
+                        {matrixCol1[1],matrixCol2[1],matrixCol3[1],0.0f},
+                        {matrixCol1[2],matrixCol2[2],matrixCol3[2],0.0f}};
+    copy(matrix, axes);
+}
 
-	transform(attribute, matrix);
+void TransformTool::multiply(float result[3][4], const float lhs[3][4],
+                             const float rhs[3][4])
+{
+    // Both matrices have an implicit last row of (0, 0, 0, 1).
+    float product[3][4];
+    for(int i = 0; i < 3; ++i)
+    {
+        for(int j = 0; j < 4; ++j)
+        {
+            product[i][j] = lhs[i][0]*rhs[0][j] + lhs[i][1]*rhs[1][j] + lhs[i][2]*rhs[2][j];
+        }
+        product[i][3] += lhs[i][3];
+    }
+    copy(result, product);
+}
+
+void TransformTool::copy(float dst[3][4], const float src[3][4])
+{
+    for(int i = 0; i < 3; ++i)
+    {
+        for(int j = 0; j < 4; ++j)
+        {
+            dst[i][j] = src[i][j];
+        }
+    }
 }
 
 void TransformTool::normalize(float* vector, int size)
@@ -196,28 +288,95 @@ void TransformTool::normalize(float* vector, int size)
 }
 
 
-void TransformTool::transform(Mesh::Attribute *attribute, float matrix[3][4])
+// Kernels applying the 3x4 matrix to a block of vertices. When normalize
+// is set, the first size components of every result are normalized in
+// the same pass.
+
+static void transformScalar(float* data, int numVertices, int stride,
+                            int size, const float matrix[3][4], bool normalize)
 {
-    float* data = attribute->data;
-	
-    // iterating over vertices
-    for(int i = 0; i < attribute->count/4; ++i)
+    // components missing from the stride are treated as 0 and a missing
+    // w as 1
+    for(int i = 0; i < numVertices; ++i)
     {
-		float x,y,z,w;
-        x = data[i*4+0]; y = data[i*4+1]; z = data[i*4+2]; w = data[i*4+3];
-        data[i*4+0] = x*matrix[0][0] + y*matrix[0][1] + z*matrix[0][2] + w*matrix[0][3];
-        data[i*4+1] = x*matrix[1][0] + y*matrix[1][1] + z*matrix[1][2] + w*matrix[1][3];
-        data[i*4+2] = x*matrix[2][0] + y*matrix[2][1] + z*matrix[2][2] + w*matrix[2][3];
+        float* v = &data[i*stride];
+        float x,y,z,w;
+        x = v[0];
+        y = stride > 1 ? v[1] : 0.0f;
+        z = stride > 2 ? v[2] : 0.0f;
+        w = stride > 3 ? v[3] : 1.0f;
+        v[0] = x*matrix[0][0] + y*matrix[0][1] + z*matrix[0][2] + w*matrix[0][3];
+        if(stride > 1)
+            v[1] = x*matrix[1][0] + y*matrix[1][1] + z*matrix[1][2] + w*matrix[1][3];
+        if(stride > 2)
+            v[2] = x*matrix[2][0] + y*matrix[2][1] + z*matrix[2][2] + w*matrix[2][3];
+
+        if(normalize)
+            TransformTool::normalize(v, size);
     }
+}
 
-	if(attribute->type == Mesh::NORMAL ||
-	   attribute->type == Mesh::TANGENT ||
-	   attribute->type == Mesh::BITANGENT)
-	{
-		for(int i = 0; i < attribute->count/4; ++i)
-		{
-			normalize(&data[i*4], attribute->size);
-		}
-	}
+#ifdef A3D_USE_SSE
+static void transformStride4SSE(float* data, int numVertices, int size,
+                                const float matrix[3][4], bool normalize)
+{
+    // Matrix columns, the last one passes w through. The products are
+    // summed in the same order as in the scalar kernel, so both give
+    // identical results.
+    const __m128 col0 = _mm_setr_ps(matrix[0][0], matrix[1][0], matrix[2][0], 0.0f);
+    const __m128 col1 = _mm_setr_ps(matrix[0][1], matrix[1][1], matrix[2][1], 0.0f);
+    const __m128 col2 = _mm_setr_ps(matrix[0][2], matrix[1][2], matrix[2][2], 0.0f);
+    const __m128 col3 = _mm_setr_ps(matrix[0][3], matrix[1][3], matrix[2][3], 1.0f);
+    const __m128 one = _mm_set_ss(1.0f);
+
+    for(int i = 0; i < numVertices; ++i)
+    {
+        float* p = &data[i*4];
+        __m128 v = _mm_loadu_ps(p);
+
+        __m128 r = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0,0,0,0)), col0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1,1,1,1)), col1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2,2,2,2)), col2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3)), col3));
+
+        if(normalize)
+        {
+            __m128 sq = _mm_mul_ps(r, r);
+            __m128 sum = _mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1,1,1,1)));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2,2,2,2)));
+            if(size > 3)
+                sum = _mm_add_ss(sum, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(3,3,3,3)));
+
+            __m128 length = _mm_sqrt_ss(sum);
+            float scale = 0.0f;
+            if(_mm_cvtss_f32(length) != 0.0f)
+                scale = _mm_cvtss_f32(_mm_div_ss(one, length));
+
+            // w is only part of the vector for 4 component attributes
+            __m128 factor = _mm_setr_ps(scale, scale, scale, size > 3 ? scale : 1.0f);
+            r = _mm_mul_ps(r, factor);
+        }
+        _mm_storeu_ps(p, r);
+    }
 }
+#endif
 
+void TransformTool::transform(Mesh::Attribute *attribute, float matrix[3][4])
+{
+    const int stride = attribute->stride;
+    const int numVertices = attribute->count/stride;
+    const bool normalizeResult = attribute->type == Mesh::NORMAL ||
+                                 attribute->type == Mesh::TANGENT ||
+                                 attribute->type == Mesh::BITANGENT;
+
+#ifdef A3D_USE_SSE
+    if(stride == 4 && (normalizeResult == false || attribute->size >= 3))
+    {
+        transformStride4SSE(attribute->data, numVertices, attribute->size,
+                            matrix, normalizeResult);
+        return;
+    }
+#endif
+    transformScalar(attribute->data, numVertices, stride, attribute->size,
+                    matrix, normalizeResult);
+}
@@ -124,9 +124,55 @@ namespace assembly3d
 			void remapAxes(Mesh::Attribute* attribute, float matrixCol1[3],
 						   float matrixCol2[3], float matrixCol3[3], 
 						   bool inverseTranspose=false);
+
+            /**
+             * @brief Applies an affine matrix to all vertices of an attribute.
+             *
+             * Normals, tangents and bitangents are normalized afterwards.
+             *
+             * @param attribute The attribute to work on.
+             * @param matrix The upper 3x4 part of the matrix.
+             */
+            void transform(Mesh::Attribute* attribute, float matrix[3][4]);
+
+            /**
+             * @brief Builds the matrix used by translate().
+             *
+             * The matrix builders take the same parameters as the
+             * transformations and write the matrix they apply.
+             *
+             * @param matrix The matrix to write.
+             */
+            static void getTranslationMatrix(float matrix[3][4], float tx, float ty,
+                                             float tz, bool inverseTranspose=false);
+            static void getRotationMatrix(float matrix[3][4], float rangle, float rx,
+                                          float ry, float rz);
+            static void getScaleMatrix(float matrix[3][4], float sx, float sy,
+                                       float sz, bool inverseTranspose=false);
+            static void getResizeMatrix(float matrix[3][4], float width, float height,
+                                        float length, float mWidth, float mHeight,
+                                        float mLength, bool inverseTranspose=false);
+            static void getResizeMatrix(float matrix[3][4], const char axis, float val,
+                                        float mWidth, float mHeight, float mLength,
+                                        bool inverseTranspose=false);
+            static void getCenterMatrix(float matrix[3][4], int ax, int ay, int az,
+                                        float centerX, float centerY, float centerZ,
+                                        bool inverseTranspose=false);
+            static void getAxesMatrix(float matrix[3][4], float matrixCol1[3],
+                                      float matrixCol2[3], float matrixCol3[3]);
+
+            /**
+             * @brief Multiplies two affine matrices.
+             *
+             * @param result The matrix to write lhs*rhs in. May be lhs or rhs.
+             * @param lhs The transformation applied second.
+             * @param rhs The transformation applied first.
+             */
+            static void multiply(float result[3][4], const float lhs[3][4],
+                                 const float rhs[3][4]);
+            static void copy(float dst[3][4], const float src[3][4]);
         protected:
         private:
-            void transform(Mesh::Attribute* attribute, float matrix[3][4]);
         };
     }
 }